@@ -0,0 +1,40 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/**
+ * \file
+ * \brief   Counts heap allocations so benchmarks can report them next to their timings.
+ */
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <benchmark/benchmark.h>
+
+// The number of allocations made by the process so far.
+extern std::atomic<uint64_t> allocationCount;
+
+// Reports the allocations made per iteration since `start` was read.
+inline void reportAllocations(benchmark::State& state, uint64_t start) {
+  auto allocations = allocationCount.load(std::memory_order_relaxed) - start;
+  state.counters["allocs/iter"] = benchmark::Counter(
+    static_cast<double>(allocations) / static_cast<double>(state.iterations())
+  );
+}
@@ -0,0 +1,92 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <memory>
+#include <string>
+#include <thread>
+#include <benchmark/benchmark.h>
+#include <reminput/daemon.hpp>
+#include <reminput/uinput.hpp>
+#include <fcntl.h>
+#include <unistd.h>
+#include "allocations.hpp"
+
+// For explicitness.
+using namespace simular::reminput;
+
+// A daemon draining into /dev/null on its own thread, and one client of it.
+static std::string                      daemonName;
+static std::unique_ptr<InjectionDaemon> server;
+static std::unique_ptr<DaemonClient>    client;
+static std::thread                      runner;
+
+static void setupDaemon(const benchmark::State&) {
+  attachUInputDevice(open("/dev/null", O_WRONLY | O_CLOEXEC));
+  daemonName = "/reminputbench-" + std::to_string(getpid());
+  server     = std::make_unique<InjectionDaemon>(DaemonOptions { .name = daemonName.c_str() });
+  runner     = std::thread([] { server->run(); });
+  client     = std::make_unique<DaemonClient>(daemonName.c_str());
+}
+
+static void teardownDaemon(const benchmark::State&) {
+  client.reset();
+  server->stop();
+  runner.join();
+  server.reset();
+}
+
+// Handing one event to the daemon and waiting until it was injected, so the time is a full trip
+// through shared memory plus the write. Waiting yields, so the daemon gets to run on a single core.
+static void BM_DaemonHandoff(benchmark::State& state) {
+  int session = 0;
+  auto id     = reinterpret_cast<HandleID>(&session);
+  const KeyEventData data { .key = InputKey::A, .state = InputState::Press };
+
+  auto start = allocationCount.load(std::memory_order_relaxed);
+  for (auto _ : state) {
+    auto target = server->statistics().submitted + 1;
+    while (!client->enqueue(id, data))
+      std::this_thread::yield();
+    while (server->statistics().submitted < target)
+      std::this_thread::yield();
+  }
+
+  state.SetItemsProcessed(state.iterations());
+  reportAllocations(state, start);
+}
+BENCHMARK(BM_DaemonHandoff)->Setup(setupDaemon)->Teardown(teardownDaemon)->UseRealTime();
+
+// Only the client side of a handoff, with the daemon draining behind it.
+static void BM_DaemonEnqueue(benchmark::State& state) {
+  int session = 0;
+  auto id     = reinterpret_cast<HandleID>(&session);
+  const KeyEventData data { .key = InputKey::A, .state = InputState::Press };
+
+  auto start = allocationCount.load(std::memory_order_relaxed);
+  for (auto _ : state) {
+    while (!client->enqueue(id, data))
+      std::this_thread::yield();
+  }
+
+  state.SetItemsProcessed(state.iterations());
+  reportAllocations(state, start);
+}
+BENCHMARK(BM_DaemonEnqueue)->Setup(setupDaemon)->Teardown(teardownDaemon)->UseRealTime();
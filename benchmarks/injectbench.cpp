@@ -0,0 +1,258 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <cstdio>
+#include <stdexcept>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include <reminput/broadcast.hpp>
+#include <reminput/compiled.hpp>
+#include <reminput/recording.hpp>
+#include <reminput/reminput.hpp>
+#include <reminput/uinput.hpp>
+#include <fcntl.h>
+#include "allocations.hpp"
+
+// For explicitness.
+using namespace simular::reminput;
+
+// Points the backend at /dev/null, so only translation and one cheap write per batch are measured.
+static HandleID attachNullDevice() {
+  static int session    = 0;
+  static bool attached  = false;
+  if (!attached) {
+    attachUInputDevice(open("/dev/null", O_WRONLY | O_CLOEXEC));
+    attached = true;
+  }
+
+  return reinterpret_cast<HandleID>(&session);
+}
+
+// Makes a batch of alternating presses and releases.
+static std::vector<KeyEventData> makeKeyBatch(std::size_t size) {
+  std::vector<KeyEventData> batch(size);
+  for (std::size_t index = 0; index < size; index++) {
+    batch[index].key   = static_cast<InputKey>(1 + index % 26);
+    batch[index].state = index % 2 ? InputState::Release : InputState::Press;
+  }
+
+  return batch;
+}
+
+// Makes a batch of moves with a click every so often.
+static std::vector<MouseEventData> makeMouseBatch(std::size_t size) {
+  std::vector<MouseEventData> batch(size);
+  for (std::size_t index = 0; index < size; index++) {
+    batch[index].xpos     = static_cast<int32_t>(index);
+    batch[index].ypos     = static_cast<int32_t>(index * 2);
+    batch[index].scrolldy = 0;
+    batch[index].button   = index % 16 == 0 ? MouseButton::LeftButton : MouseButton::Undefined;
+    batch[index].state    = index % 32 == 0 ? InputState::Press : InputState::Release;
+  }
+
+  return batch;
+}
+
+// One key event per call through the free function, the way callers used to inject.
+static void BM_KeyboardEvent(benchmark::State& state) {
+  auto id    = attachNullDevice();
+  auto batch = makeKeyBatch(1);
+  injectKeyboardEvent(id, batch[0]);
+
+  auto start = allocationCount.load(std::memory_order_relaxed);
+  for (auto _ : state)
+    injectKeyboardEvent(id, batch[0]);
+
+  state.SetItemsProcessed(state.iterations());
+  reportAllocations(state, start);
+}
+BENCHMARK(BM_KeyboardEvent);
+
+// One mouse event per call through the free function, the way callers used to inject.
+static void BM_MouseEvent(benchmark::State& state) {
+  auto id    = attachNullDevice();
+  auto batch = makeMouseBatch(2);
+  injectMouseEvent(id, batch[0]);
+
+  auto start = allocationCount.load(std::memory_order_relaxed);
+  for (auto _ : state) {
+    injectMouseEvent(id, batch[1]);
+    injectMouseEvent(id, batch[0]);
+  }
+
+  state.SetItemsProcessed(state.iterations() * 2);
+  reportAllocations(state, start);
+}
+BENCHMARK(BM_MouseEvent);
+
+// Key batches of growing size, showing how the per-event cost falls as batches grow.
+static void BM_KeyboardBatch(benchmark::State& state) {
+  auto id    = attachNullDevice();
+  auto batch = makeKeyBatch(static_cast<std::size_t>(state.range(0)));
+  Injector injector;
+  injector.injectKeyboardEvents(id, batch);
+
+  auto start = allocationCount.load(std::memory_order_relaxed);
+  for (auto _ : state)
+    benchmark::DoNotOptimize(injector.injectKeyboardEvents(id, batch));
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  reportAllocations(state, start);
+}
+BENCHMARK(BM_KeyboardBatch)->RangeMultiplier(4)->Range(1, 4096);
+
+// The same key batches translated once up front, so only the write is left per injection.
+static void BM_CompiledKeyboardBatch(benchmark::State& state) {
+  auto id    = attachNullDevice();
+  auto batch = makeKeyBatch(static_cast<std::size_t>(state.range(0)));
+  std::vector<InputEvent> events;
+  for (const auto& event : batch)
+    events.push_back(InputEvent::fromKeyboard(event));
+  CompiledSequence sequence(events);
+  Injector injector;
+  injector.injectSequence(id, sequence);
+
+  auto start = allocationCount.load(std::memory_order_relaxed);
+  for (auto _ : state)
+    benchmark::DoNotOptimize(injector.injectSequence(id, sequence));
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  reportAllocations(state, start);
+}
+BENCHMARK(BM_CompiledKeyboardBatch)->RangeMultiplier(4)->Range(1, 4096);
+
+// Key batches under a per-injectee and a process budget too generous to ever wait, so the time over
+// BM_KeyboardBatch is what checking the budgets costs, including threads contending for the global one.
+static void BM_PacedKeyboardBatch(benchmark::State& state) {
+  auto id    = attachNullDevice();
+  auto batch = makeKeyBatch(static_cast<std::size_t>(state.range(0)));
+  Injector injector;
+  injector.setPacing(PacingOptions { .rate = 1000000000, .burst = 4096, .policy = PacingPolicy::Delay });
+  if (state.thread_index() == 0)
+    setGlobalPacing(1000000000, 4096);
+
+  auto start = allocationCount.load(std::memory_order_relaxed);
+  for (auto _ : state)
+    benchmark::DoNotOptimize(injector.injectKeyboardEvents(id, batch));
+
+  if (state.thread_index() == 0)
+    setGlobalPacing(0, 0);
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  reportAllocations(state, start);
+}
+BENCHMARK(BM_PacedKeyboardBatch)->Arg(1)->Arg(64)->Threads(1)->Threads(4);
+
+// Mouse batches of growing size, showing how the per-event cost falls as batches grow.
+static void BM_MouseBatch(benchmark::State& state) {
+  auto id    = attachNullDevice();
+  auto batch = makeMouseBatch(static_cast<std::size_t>(state.range(0)));
+  Injector injector;
+  injector.injectMouseEvents(id, batch);
+
+  auto start = allocationCount.load(std::memory_order_relaxed);
+  for (auto _ : state)
+    benchmark::DoNotOptimize(injector.injectMouseEvents(id, batch));
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  reportAllocations(state, start);
+}
+BENCHMARK(BM_MouseBatch)->RangeMultiplier(4)->Range(1, 4096);
+
+// Key batches diverted into a recording, the path deterministic tests take on headless machines.
+static void BM_RecordKeyboardBatch(benchmark::State& state) {
+  int window = 0;
+  auto id    = reinterpret_cast<HandleID>(&window);
+  auto batch = makeKeyBatch(static_cast<std::size_t>(state.range(0)));
+  startRecording(RecordingOptions { .path = "reminputbench.log", .capacity = 1 << 16 });
+  Injector injector;
+  injector.injectKeyboardEvents(id, batch);
+
+  auto start = allocationCount.load(std::memory_order_relaxed);
+  for (auto _ : state)
+    benchmark::DoNotOptimize(injector.injectKeyboardEvents(id, batch));
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  reportAllocations(state, start);
+  stopRecording();
+  std::remove("reminputbench.log");
+}
+BENCHMARK(BM_RecordKeyboardBatch)->RangeMultiplier(4)->Range(1, 4096);
+
+#if defined(__cpp_exceptions)
+// Injecting into a handle that fails validation, paying for the throw and catch every time.
+static void BM_RejectThrowing(benchmark::State& state) {
+  KeyEventData event { .key = InputKey::A, .state = InputState::Press };
+  for (auto _ : state) {
+    try {
+      injectKeyboardEvent(nullptr, event);
+    } catch (const std::runtime_error&) {
+      benchmark::ClobberMemory();
+    }
+  }
+}
+BENCHMARK(BM_RejectThrowing);
+#endif
+
+// Injecting into a handle that fails validation, reported through the result instead.
+static void BM_RejectResult(benchmark::State& state) {
+  KeyEventData event { .key = InputKey::A, .state = InputState::Press };
+  for (auto _ : state)
+    benchmark::DoNotOptimize(tryInjectKeyboardEvent(nullptr, event));
+}
+BENCHMARK(BM_RejectResult);
+
+// The same key batch sent to each of many sessions, one call per session.
+static void BM_SerialFanout(benchmark::State& state) {
+  attachNullDevice();
+  std::vector<int> sessions(static_cast<std::size_t>(state.range(0)));
+  auto batch = makeKeyBatch(64);
+  Injector injector;
+
+  auto start = allocationCount.load(std::memory_order_relaxed);
+  for (auto _ : state) {
+    for (auto& session : sessions)
+      benchmark::DoNotOptimize(injector.injectKeyboardEvents(reinterpret_cast<HandleID>(&session), batch));
+  }
+
+  state.SetItemsProcessed(state.iterations() * state.range(0) * 64);
+  reportAllocations(state, start);
+}
+BENCHMARK(BM_SerialFanout)->RangeMultiplier(4)->Range(4, 256);
+
+// The same key batch broadcast to many sessions, translated once and submitted by the pool.
+static void BM_Broadcast(benchmark::State& state) {
+  attachNullDevice();
+  std::vector<int> sessions(static_cast<std::size_t>(state.range(0)));
+  std::vector<BroadcastTarget> targets(sessions.size());
+  for (std::size_t index = 0; index < sessions.size(); index++)
+    targets[index].injectee = reinterpret_cast<HandleID>(&sessions[index]);
+  auto batch = makeKeyBatch(64);
+  Broadcaster broadcaster;
+  broadcaster.broadcast(targets, batch);
+
+  auto start = allocationCount.load(std::memory_order_relaxed);
+  for (auto _ : state)
+    benchmark::DoNotOptimize(broadcaster.broadcast(targets, batch));
+
+  state.SetItemsProcessed(state.iterations() * state.range(0) * 64);
+  reportAllocations(state, start);
+}
+BENCHMARK(BM_Broadcast)->RangeMultiplier(4)->Range(4, 256);
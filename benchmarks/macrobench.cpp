@@ -0,0 +1,80 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <chrono>
+#include <cstdio>
+#include <benchmark/benchmark.h>
+#include <reminput/macro.hpp>
+#include <reminput/recording.hpp>
+#include "allocations.hpp"
+
+// For explicitness.
+using namespace simular::reminput;
+
+// A macro of a million events, sixteen megabytes on disk.
+constexpr const char* kMacroPath = "reminputbench.macro";
+constexpr std::size_t kMacroSize = 1 << 20;
+
+static void saveMacro(const benchmark::State&) {
+  MacroWriter writer;
+  for (std::size_t index = 0; index < kMacroSize; index++) {
+    writer.key(std::chrono::microseconds(100), KeyEventData {
+      .key   = static_cast<InputKey>(1 + index % 26),
+      .state = index % 2 ? InputState::Release : InputState::Press,
+    });
+  }
+  writer.save(kMacroPath);
+}
+
+static void removeMacro(const benchmark::State&) {
+  std::remove(kMacroPath);
+}
+
+// Mapping a large macro until its first record can be read, which is all replay waits for.
+static void BM_OpenMacro(benchmark::State& state) {
+  auto start = allocationCount.load(std::memory_order_relaxed);
+  for (auto _ : state) {
+    MacroFile macro(kMacroPath);
+    benchmark::DoNotOptimize(macro.records().front().code);
+  }
+
+  reportAllocations(state, start);
+}
+BENCHMARK(BM_OpenMacro)->Setup(saveMacro)->Teardown(removeMacro);
+
+// Replaying the whole macro into a recording, converting through the replay buffer.
+static void BM_ReplayMacro(benchmark::State& state) {
+  int window = 0;
+  auto id    = reinterpret_cast<HandleID>(&window);
+  MacroFile macro(kMacroPath);
+  startRecording(RecordingOptions { .path = "reminputbench.log", .capacity = 1 << 16 });
+  Injector injector;
+
+  auto start = allocationCount.load(std::memory_order_relaxed);
+  for (auto _ : state)
+    benchmark::DoNotOptimize(replayMacro(injector, id, macro.records()));
+
+  state.SetItemsProcessed(state.iterations() * kMacroSize);
+  reportAllocations(state, start);
+  stopRecording();
+  std::remove("reminputbench.log");
+}
+BENCHMARK(BM_ReplayMacro)->Setup(saveMacro)->Teardown(removeMacro)->Unit(benchmark::kMillisecond);
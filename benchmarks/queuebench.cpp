@@ -0,0 +1,60 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <memory>
+#include <benchmark/benchmark.h>
+#include <reminput/queue.hpp>
+#include <reminput/uinput.hpp>
+#include <fcntl.h>
+#include "allocations.hpp"
+
+// For explicitness.
+using namespace simular::reminput;
+
+// Shared by every producer thread of a run.
+static std::unique_ptr<AsyncInjector> injector;
+static int                            sessions[64];
+
+static void setupInjector(const benchmark::State&) {
+  attachUInputDevice(open("/dev/null", O_WRONLY | O_CLOEXEC));
+  injector = std::make_unique<AsyncInjector>(1 << 14, QueuePolicy::Block);
+}
+
+static void teardownInjector(const benchmark::State&) {
+  injector.reset();
+}
+
+// Producers enqueueing as fast as they can, with the dispatcher draining into /dev/null.
+static void BM_AsyncEnqueue(benchmark::State& state) {
+  auto id = reinterpret_cast<HandleID>(&sessions[state.thread_index() % 64]);
+  const KeyEventData data { .key = InputKey::A, .state = InputState::Press };
+
+  auto start = allocationCount.load(std::memory_order_relaxed);
+  for (auto _ : state)
+    injector->enqueue(id, data);
+
+  // Count the time it takes to drain as part of the run.
+  injector->flush();
+  state.SetItemsProcessed(state.iterations());
+  if (state.thread_index() == 0)
+    reportAllocations(state, start);
+}
+BENCHMARK(BM_AsyncEnqueue)->Setup(setupInjector)->Teardown(teardownInjector)->ThreadRange(1, 8)->UseRealTime();
@@ -0,0 +1,89 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include <reminput/socket.hpp>
+#include <reminput/uinput.hpp>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "allocations.hpp"
+
+// For explicitness.
+using namespace simular::reminput;
+
+// A socket server injecting into /dev/null on its own thread, and one client of it.
+static std::string                   socketPath;
+static std::unique_ptr<SocketServer> socketServer;
+static std::thread                   socketRunner;
+static int                           socketClient = -1;
+
+static void setupSocket(const benchmark::State& state) {
+  attachUInputDevice(open("/dev/null", O_WRONLY | O_CLOEXEC));
+  socketPath   = "/tmp/reminputbench-" + std::to_string(getpid()) + ".sock";
+  socketServer = std::make_unique<SocketServer>(SocketServerOptions { .path = socketPath.c_str(), .forceEpoll = state.range(0) != 0 });
+  socketRunner = std::thread([] { socketServer->run(); });
+
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  std::strcpy(address.sun_path, socketPath.c_str());
+  socketClient = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  connect(socketClient, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+}
+
+static void teardownSocket(const benchmark::State&) {
+  close(socketClient);
+  socketServer->stop();
+  socketRunner.join();
+  socketServer.reset();
+}
+
+// Writing one frame of 64 key events and waiting until the server injected it. The argument
+// selects epoll instead of io_uring.
+static void BM_SocketFrame(benchmark::State& state) {
+  constexpr uint32_t kEvents = 64;
+  FrameHeader header { .count = kEvents, .flags = 0, .injectee = 1 };
+  std::vector<std::byte> frame(sizeof(header) + kEvents * sizeof(InputEvent));
+  std::memcpy(frame.data(), &header, sizeof(header));
+  for (uint32_t index = 0; index < kEvents; index++) {
+    auto event = InputEvent::fromKeyboard(KeyEventData { .key = InputKey::A, .state = InputState::Press });
+    std::memcpy(frame.data() + sizeof(header) + index * sizeof(event), &event, sizeof(event));
+  }
+
+  auto start = allocationCount.load(std::memory_order_relaxed);
+  for (auto _ : state) {
+    auto target = socketServer->statistics().frames + 1;
+    benchmark::DoNotOptimize(write(socketClient, frame.data(), frame.size()));
+    while (socketServer->statistics().frames < target)
+      std::this_thread::yield();
+  }
+
+  state.SetLabel(socketServer->usingIoUring() ? "io_uring" : "epoll");
+  state.SetItemsProcessed(state.iterations() * kEvents);
+  reportAllocations(state, start);
+}
+BENCHMARK(BM_SocketFrame)->Arg(0)->Arg(1)->Setup(setupSocket)->Teardown(teardownSocket)->UseRealTime();
@@ -0,0 +1,53 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <chrono>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include <reminput/trajectory.hpp>
+#include "allocations.hpp"
+
+// For explicitness.
+using namespace simular::reminput;
+
+// Generating a quarter second path at a 1 kHz polling rate, for each model.
+static void BM_Trajectory(benchmark::State& state) {
+  TrajectoryOptions options {
+    .startX   = 10,
+    .startY   = 20,
+    .endX     = 1700,
+    .endY     = 900,
+    .duration = std::chrono::milliseconds(250),
+    .interval = std::chrono::milliseconds(1),
+    .model    = static_cast<TrajectoryModel>(state.range(0)),
+  };
+  std::vector<TimedMouseEvent> events(trajectoryLength(options));
+
+  auto start = allocationCount.load(std::memory_order_relaxed);
+  for (auto _ : state) {
+    options.seed++;
+    benchmark::DoNotOptimize(generateTrajectory(options, events));
+  }
+
+  state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(events.size()));
+  reportAllocations(state, start);
+}
+BENCHMARK(BM_Trajectory)->DenseRange(0, 2);
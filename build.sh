@@ -66,6 +66,15 @@ for i in $(seq 1 ${#word}); do
     'b') # Build benchmarks.
       options="$options -DBUILD_BENCHMARKS=ON"
     ;;
+    'x') # Inject through X11 instead of uinput on Linux.
+      options="$options -DBUILD_X11=ON"
+    ;;
+    'n') # Build without exceptions.
+      options="$options -DBUILD_NO_EXCEPTIONS=ON"
+    ;;
+    'm') # Build the reminputd daemon.
+      options="$options -DBUILD_DAEMON=ON"
+    ;;
     'q') # Enable quiet building.
       options="$options -DBUILD_QUIET=ON"
     ;;
@@ -0,0 +1,98 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <reminput/daemon.hpp>
+#include <reminput/socket.hpp>
+
+// For explicitness.
+using namespace simular::reminput;
+
+// The daemon and socket server a signal stops.
+static InjectionDaemon* running = nullptr;
+static SocketServer*    serving = nullptr;
+
+static void stopRunning(int) {
+  if (running)
+    running->stop();
+  if (serving)
+    serving->stop();
+}
+
+// Usage: reminputd [name] [clients] [capacity] [socket]
+int main(int argc, char** argv) {
+  DaemonOptions options;
+  if (argc > 1)
+    options.name = argv[1];
+  if (argc > 2)
+    options.clients = std::strtoul(argv[2], nullptr, 10);
+  if (argc > 3)
+    options.capacity = std::strtoul(argv[3], nullptr, 10);
+
+  InjectionDaemon daemon(options);
+  if (!daemon.valid()) {
+    std::fprintf(stderr, "reminputd: could not create the shared memory segment %s, or another daemon serves it\n", options.name);
+    return EXIT_FAILURE;
+  }
+
+  // Clients that cannot map the segment can send frames over a socket instead.
+  std::unique_ptr<SocketServer> server;
+  if (argc > 4) {
+    server = std::make_unique<SocketServer>(SocketServerOptions { .path = argv[4] });
+    if (!server->valid()) {
+      std::fprintf(stderr, "reminputd: could not listen on %s\n", argv[4]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  running = &daemon;
+  serving = server.get();
+  std::signal(SIGINT, stopRunning);
+  std::signal(SIGTERM, stopRunning);
+  std::thread socketRunner;
+  if (server)
+    socketRunner = std::thread([&] { server->run(); });
+  daemon.run();
+  if (socketRunner.joinable()) {
+    server->stop();
+    socketRunner.join();
+  }
+
+  auto statistics = daemon.statistics();
+  std::printf("reminputd: %llu submitted, %llu failed, %llu connections\n",
+              static_cast<unsigned long long>(statistics.submitted),
+              static_cast<unsigned long long>(statistics.failed),
+              static_cast<unsigned long long>(statistics.connections));
+  if (server) {
+    auto socketStatistics = server->statistics();
+    std::printf("reminputd: %llu frames, %llu submitted, %llu failed, %llu rejected over %s\n",
+                static_cast<unsigned long long>(socketStatistics.frames),
+                static_cast<unsigned long long>(socketStatistics.submitted),
+                static_cast<unsigned long long>(socketStatistics.failed),
+                static_cast<unsigned long long>(socketStatistics.rejected),
+                argv[4]);
+  }
+  return EXIT_SUCCESS;
+}
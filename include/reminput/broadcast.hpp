@@ -0,0 +1,138 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/**
+ * \file
+ * \brief   Delivers one batch of events to many injectees at once.
+ * \details A batch is translated into native input a single time, and a pool of worker threads
+ *          then validates and submits that shared translation to every target in parallel.
+ */
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <reminput/reminput.hpp>
+
+namespace simular::reminput {
+  /**
+   * \brief   One injectee of a broadcast, and what happened when the batch was delivered to it.
+   * \details The caller sets `injectee`; the broadcast fills in the rest.
+   */
+  struct BroadcastTarget final {
+    /**
+     * \brief   The object that will receive the batch.
+     */
+    HandleID injectee = nullptr;
+
+    /**
+     * \brief   Whether the injectee passed validation. Invalid injectees are skipped, not thrown for.
+     */
+    bool valid = false;
+
+    /**
+     * \brief   The number of events, counted from the front of the batch, that the platform accepted.
+     */
+    std::size_t accepted = 0;
+
+    /**
+     * \brief   How long validating and submitting to this injectee took.
+     */
+    std::chrono::nanoseconds elapsed{0};
+  };
+
+  /**
+   * \brief   How long the parts of a broadcast took.
+   */
+  struct BroadcastTiming final {
+    /**
+     * \brief   How long translating the batch took, once for every target.
+     */
+    std::chrono::nanoseconds translation{0};
+
+    /**
+     * \brief   How long it took, from the start of the fan-out, until every target was served.
+     */
+    std::chrono::nanoseconds fanout{0};
+
+    /**
+     * \brief   The longest any single target took, the floor of `fanout` however many workers run.
+     */
+    std::chrono::nanoseconds slowest{0};
+  };
+
+  /**
+   * \brief   Broadcasts batches of events to sets of injectees over a pool of worker threads.
+   * \details The calling thread serves targets alongside the workers, so a broadcaster without
+   *          workers delivers serially on the caller. Validation is cached per injectee as with an
+   *          `Injector`. Every target receives the batch from the same starting point, so each
+   *          broadcast of mouse events sends its first position even if a previous one ended there.
+   *          A broadcaster must only be used by one thread at a time.
+   */
+  class Broadcaster final {
+  public:
+    /**
+     * \brief     Starts the worker threads.
+     * \param[in] workers The number of workers besides the calling thread. The default uses every
+     *                    other hardware thread.
+     */
+    explicit Broadcaster(std::size_t workers = defaultWorkers());
+
+    /**
+     * \brief   Stops the worker threads.
+     */
+    ~Broadcaster();
+
+    Broadcaster(const Broadcaster&) = delete;
+    Broadcaster& operator=(const Broadcaster&) = delete;
+
+    /**
+     * \brief   Returns one less than the number of hardware threads, or zero if that is unknown.
+     */
+    static std::size_t defaultWorkers();
+
+    /**
+     * \brief         Delivers a batch of key events to every target.
+     * \param[in,out] targets The injectees to deliver to, whose results are filled in.
+     * \param[in]     data The key events to send, in the order they should be received.
+     * \return        How long the parts of the broadcast took.
+     */
+    BroadcastTiming broadcast(std::span<BroadcastTarget> targets, std::span<const KeyEventData> data);
+
+    /**
+     * \brief         Delivers a batch of mouse events to every target.
+     * \param[in,out] targets The injectees to deliver to, whose results are filled in.
+     * \param[in]     data The mouse events to send, in the order they should be received.
+     * \return        How long the parts of the broadcast took.
+     */
+    BroadcastTiming broadcast(std::span<BroadcastTarget> targets, std::span<const MouseEventData> data);
+
+    /**
+     * \brief     Forgets the state kept for the injectee, such as after its window closed.
+     * \param[in] injectee The object whose state should be released.
+     */
+    void release(HandleID injectee);
+
+  private:
+    struct Pool;
+    std::unique_ptr<Pool> pool;
+  };
+}
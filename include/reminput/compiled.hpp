@@ -0,0 +1,71 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/**
+ * \file
+ * \brief   Sequences translated into native input once, to be injected any number of times.
+ * \details Injecting a `CompiledSequence` skips translation entirely and hands the stored native
+ *          records straight to the platform, so repeating a macro costs little more than the
+ *          system calls that submit it.
+ */
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <reminput/reminput.hpp>
+
+namespace simular::reminput {
+  /**
+   * \brief   A sequence of events, translated once into the native records of the platform.
+   * \details Consecutive events of the same kind are stored as one contiguous buffer and submitted
+   *          in one call; waits are left out. Mouse events are translated from an unknown cursor,
+   *          so every injection sends the first position of the sequence even if the cursor is
+   *          already there. Positions are in screen space, mapped with the desktop as it was when
+   *          the sequence was translated. A fixed macro can be written as a `constexpr` array of
+   *          `InputEvent`, so that only the translation, which depends on the platform, is left for
+   *          run time. A sequence is never changed by injecting it, so any number of threads may
+   *          share one.
+   */
+  class CompiledSequence final {
+  public:
+    /**
+     * \brief     Translates a sequence.
+     * \details   Translation stops at the first record that is not valid, so `size` counts only the
+     *            events before it.
+     * \param[in] events The events, in the order they should be received.
+     */
+    explicit CompiledSequence(std::span<const InputEvent> events);
+
+    ~CompiledSequence();
+    CompiledSequence(CompiledSequence&&) noexcept;
+    CompiledSequence& operator=(CompiledSequence&&) noexcept;
+
+    /**
+     * \brief   Returns the number of events in the sequence, waits left out.
+     */
+    std::size_t size() const noexcept;
+
+  private:
+    friend class Injector;
+    struct Runs;
+    std::unique_ptr<Runs> runs;
+  };
+}
@@ -0,0 +1,201 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/**
+ * \file
+ * \brief   A daemon that injects for many client processes through one backend.
+ * \details The daemon creates a named shared memory segment holding one single-producer,
+ *          single-consumer ring per client. A client claims a ring and writes packed events into
+ *          it directly; the daemon drains every ring into batched injections. Handing an event
+ *          over is a few stores into shared memory, and a system call only happens to wake a
+ *          daemon that went to sleep. Only available on Linux.
+ */
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <reminput/reminput.hpp>
+
+namespace simular::reminput {
+  /**
+   * \brief   The name of the shared memory segment a daemon creates unless told otherwise.
+   */
+  constexpr const char* kDefaultDaemonName = "/reminputd";
+
+  /**
+   * \brief   Describes the shared memory segment a daemon creates.
+   */
+  struct DaemonOptions final {
+    /**
+     * \brief   The name of the segment, starting with a slash.
+     */
+    const char* name = kDefaultDaemonName;
+
+    /**
+     * \brief   The most clients that can be connected at once.
+     */
+    std::size_t clients = 64;
+
+    /**
+     * \brief   The number of events each client ring holds, rounded up to a power of two.
+     */
+    std::size_t capacity = 4096;
+
+    /**
+     * \brief   How many empty polls the daemon spins through, yielding between them, before it sleeps.
+     */
+    std::size_t spins = 4096;
+  };
+
+  /**
+   * \brief   Counters describing what happened to the events clients sent a daemon.
+   */
+  struct DaemonStatistics final {
+    /**
+     * \brief   Events the platform accepted.
+     */
+    uint64_t submitted;
+
+    /**
+     * \brief   Events that were drained but not accepted, such as those for a closed window or records
+     *          the backends could not index.
+     */
+    uint64_t failed;
+
+    /**
+     * \brief   Clients that connected, including those since gone.
+     */
+    uint64_t connections;
+  };
+
+  /**
+   * \brief   Owns the shared memory segment and injects whatever clients write into it.
+   * \details The segment is removed when the daemon is destroyed. Rings of clients that
+   *          disconnected or died are drained and then handed to new clients. Invalid injectees
+   *          are counted as failures. `poll()` and `run()` must only be used by one thread; `stop()`
+   *          is safe from any thread and from a signal handler.
+   */
+  class InjectionDaemon final {
+  public:
+    /**
+     * \brief     Creates the shared memory segment, replacing one left behind by a daemon that died.
+     * \details   A segment of that name served by a live daemon, or not made by a daemon of this
+     *            version, is left alone and the daemon is not valid.
+     * \param[in] options Describes the segment.
+     */
+    explicit InjectionDaemon(const DaemonOptions& options = {});
+
+    /**
+     * \brief   Removes the shared memory segment.
+     */
+    ~InjectionDaemon();
+
+    InjectionDaemon(const InjectionDaemon&) = delete;
+    InjectionDaemon& operator=(const InjectionDaemon&) = delete;
+
+    /**
+     * \brief   Checks whether the segment was created, so clients can connect.
+     */
+    bool valid() const;
+
+    /**
+     * \brief   Drains every ring once, injecting what was in them.
+     * \return  The number of events drained.
+     */
+    std::size_t poll();
+
+    /**
+     * \brief   Drains the rings until `stop()` is called, sleeping while they are all empty.
+     */
+    void run();
+
+    /**
+     * \brief   Makes `run()` return once the rings are empty.
+     */
+    void stop();
+
+    /**
+     * \brief   Returns the counters of this daemon.
+     */
+    DaemonStatistics statistics() const;
+
+  private:
+    struct Segment;
+    std::unique_ptr<Segment> segment;
+  };
+
+  /**
+   * \brief   A connection to a daemon, through a ring of its shared memory segment.
+   * \details Events for the same injectee are injected in the order they were enqueued. A client
+   *          must only be used by one thread at a time. Injection happens later in the daemon, so
+   *          enqueuing reports nothing about the injectee.
+   */
+  class DaemonClient final {
+  public:
+    /**
+     * \brief     Claims a ring of the daemon's segment.
+     * \param[in] name The name of the segment.
+     */
+    explicit DaemonClient(const char* name = kDefaultDaemonName);
+
+    /**
+     * \brief   Gives the ring back once the daemon drained it.
+     */
+    ~DaemonClient();
+
+    DaemonClient(const DaemonClient&) = delete;
+    DaemonClient& operator=(const DaemonClient&) = delete;
+
+    /**
+     * \brief   Checks whether a ring was claimed, which fails if no daemon runs or every ring is taken.
+     */
+    bool connected() const;
+
+    /**
+     * \brief     Hands a key event to the daemon.
+     * \param[in] injectee The object that will receive the key event injection.
+     * \param[in] data The data for the key event.
+     * \return    False if the ring was full or the client is not connected.
+     */
+    bool enqueue(HandleID injectee, const KeyEventData& data);
+
+    /**
+     * \brief     Hands a mouse event to the daemon.
+     * \param[in] injectee The object that will receive the mouse event injection.
+     * \param[in] data The data for the mouse event.
+     * \return    False if the ring was full or the client is not connected.
+     */
+    bool enqueue(HandleID injectee, const MouseEventData& data);
+
+    /**
+     * \brief     Hands a batch of packed events to the daemon, publishing them together.
+     * \param[in] injectee The object that will receive the events.
+     * \param[in] data The events to send, in the order they should be received.
+     * \return    The number of events, counted from the front of `data`, that fit in the ring.
+     */
+    std::size_t enqueue(HandleID injectee, std::span<const InputEvent> data);
+
+  private:
+    struct Ring;
+    std::unique_ptr<Ring> ring;
+  };
+}
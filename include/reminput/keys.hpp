@@ -0,0 +1,159 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/**
+ * \file
+ * \brief   Converts keys to and from their names, at compile time or at run time.
+ * \details The names are the enumerator names of `InputKey`, taken from `REMINPUT_INPUT_KEYS`, so a
+ *          new key is named as soon as it is declared. Neither direction allocates.
+ */
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <reminput/reminput.hpp>
+
+namespace simular::reminput {
+  /**
+   * \brief   The name of every key, indexed by `InputKey`.
+   */
+#define REMINPUT_INPUT_KEY_NAME(name) std::string_view(#name),
+  inline constexpr std::array<std::string_view, kInputKeyCount> kInputKeyNames {
+    REMINPUT_INPUT_KEYS(REMINPUT_INPUT_KEY_NAME)
+  };
+#undef REMINPUT_INPUT_KEY_NAME
+
+  namespace detail {
+    // The first level of the hash spreads the names over buckets, and each bucket then picks the
+    // seed that moves its names into free slots of the second level.
+    constexpr std::size_t kKeyNameBuckets = 64;
+    constexpr std::size_t kKeyNameSlots   = 256;
+    static_assert(kInputKeyCount < kKeyNameSlots, "a slot holds a key index below 255");
+
+    // Folds a name into its hash, ignoring case.
+    constexpr uint32_t hashKeyName(std::string_view name, uint32_t seed) noexcept {
+      auto hash = 2166136261u ^ (seed * 16777619u);
+      for (auto character : name) {
+        if (character >= 'A' && character <= 'Z')
+          character = static_cast<char>(character - 'A' + 'a');
+        hash = (hash ^ static_cast<uint8_t>(character)) * 16777619u;
+      }
+
+      return hash ^ (hash >> 15);
+    }
+
+    // Compares two names, ignoring case.
+    constexpr bool sameKeyName(std::string_view left, std::string_view right) noexcept {
+      if (left.size() != right.size())
+        return false;
+      for (std::size_t index = 0; index < left.size(); index++) {
+        auto a = left[index], b = right[index];
+        if (a >= 'A' && a <= 'Z') a = static_cast<char>(a - 'A' + 'a');
+        if (b >= 'A' && b <= 'Z') b = static_cast<char>(b - 'A' + 'a');
+        if (a != b)
+          return false;
+      }
+
+      return true;
+    }
+
+    // A perfect hash over the key names: the seed of each bucket, and the key in each slot plus one.
+    struct KeyNameHash final {
+      std::array<uint8_t, kKeyNameBuckets> seeds{};
+      std::array<uint8_t, kKeyNameSlots>   slots{};
+      bool                                 valid = true;
+    };
+
+    // Builds the perfect hash, placing the fullest buckets first while the most slots are free.
+    constexpr KeyNameHash buildKeyNameHash() noexcept {
+      KeyNameHash table{};
+      std::array<uint8_t, kInputKeyCount>      bucketOf{};
+      std::array<std::size_t, kKeyNameBuckets> sizes{};
+      for (std::size_t key = 0; key < kInputKeyCount; key++) {
+        bucketOf[key] = static_cast<uint8_t>(hashKeyName(kInputKeyNames[key], 0) % kKeyNameBuckets);
+        sizes[bucketOf[key]]++;
+      }
+
+      for (auto size = kInputKeyCount; size > 0; size--) {
+        for (std::size_t bucket = 0; bucket < kKeyNameBuckets; bucket++) {
+          if (sizes[bucket] != size)
+            continue;
+
+          auto placed = false;
+          for (uint32_t seed = 1; seed < 256 && !placed; seed++) {
+            auto slots = table.slots;
+            placed = true;
+            for (std::size_t key = 0; key < kInputKeyCount && placed; key++) {
+              if (bucketOf[key] != bucket)
+                continue;
+              auto& slot = slots[hashKeyName(kInputKeyNames[key], seed) % kKeyNameSlots];
+              placed = slot == 0;
+              slot   = static_cast<uint8_t>(key + 1);
+            }
+
+            if (placed) {
+              table.seeds[bucket] = static_cast<uint8_t>(seed);
+              table.slots         = slots;
+            }
+          }
+
+          table.valid = table.valid && placed;
+        }
+      }
+
+      return table;
+    }
+
+    inline constexpr KeyNameHash kKeyNameHash = buildKeyNameHash();
+    static_assert(kKeyNameHash.valid, "no seed places every key name, widen the hash");
+  }
+
+  /**
+   * \brief   Finds the key with the given name.
+   * \details Names are the enumerator names of `InputKey`, such as "PageUp" or "F5", compared
+   *          without regard to case. The lookup costs two hashes of the name and one comparison.
+   * \param[in] name The name to look up.
+   * \return  The key, or nothing if no key has that name.
+   */
+  constexpr std::optional<InputKey> parseInputKey(std::string_view name) noexcept {
+    auto seed = detail::kKeyNameHash.seeds[detail::hashKeyName(name, 0) % detail::kKeyNameBuckets];
+    if (seed == 0)
+      return std::nullopt;
+
+    auto slot = detail::kKeyNameHash.slots[detail::hashKeyName(name, seed) % detail::kKeyNameSlots];
+    if (slot == 0 || !detail::sameKeyName(kInputKeyNames[slot - 1], name))
+      return std::nullopt;
+
+    return static_cast<InputKey>(slot - 1);
+  }
+
+  /**
+   * \brief   Names a key.
+   * \param[in] key The key to name.
+   * \return  The name of the key, or an empty string if the key is out of range.
+   */
+  constexpr std::string_view toString(InputKey key) noexcept {
+    auto index = static_cast<std::size_t>(key);
+    return index < kInputKeyCount ? kInputKeyNames[index] : std::string_view();
+  }
+}
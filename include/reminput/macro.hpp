@@ -0,0 +1,131 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/**
+ * \file
+ * \brief   A compact binary format for input macros, and a replayer that streams it.
+ * \details A macro file is a short header followed by fixed-width records in little-endian byte
+ *          order. Each record holds the delay since the record before it, so a file can be replayed
+ *          straight from a read-only mapping without parsing it first.
+ */
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include <reminput/reminput.hpp>
+
+namespace simular::reminput {
+  /**
+   * \brief   A single record of a macro, stored on disk exactly as it is in memory.
+   * \details Only little-endian platforms are supported, so memory order is the file order.
+   */
+  using MacroRecord = InputEvent;
+
+  /**
+   * \brief   Builds a macro in memory and saves it.
+   */
+  class MacroWriter final {
+  public:
+    /**
+     * \brief     Appends a key event.
+     * \param[in] delay How long to wait after the previous event.
+     * \param[in] data The key event.
+     */
+    void key(std::chrono::nanoseconds delay, const KeyEventData& data);
+
+    /**
+     * \brief     Appends a mouse event.
+     * \param[in] delay How long to wait after the previous event.
+     * \param[in] data The mouse event.
+     */
+    void mouse(std::chrono::nanoseconds delay, const MouseEventData& data);
+
+    /**
+     * \brief   Returns the records appended so far.
+     */
+    std::span<const MacroRecord> records() const;
+
+    /**
+     * \brief     Writes the macro to a file, replacing it.
+     * \param[in] path The path of the file.
+     * \return    False if the file could not be written.
+     */
+    bool save(const char* path) const;
+
+  private:
+    // Appends waits for whatever part of the delay one record cannot hold, returning the rest.
+    uint32_t split(std::chrono::nanoseconds delay);
+
+    std::vector<MacroRecord> entries;
+  };
+
+  /**
+   * \brief   A read-only mapping of a macro file.
+   */
+  class MacroFile final {
+  public:
+    /**
+     * \brief     Maps the macro at the given path.
+     * \param[in] path The path of the macro.
+     */
+    explicit MacroFile(const char* path);
+
+    /**
+     * \brief   Unmaps the macro.
+     */
+    ~MacroFile();
+
+    MacroFile(const MacroFile&) = delete;
+    MacroFile& operator=(const MacroFile&) = delete;
+
+    /**
+     * \brief   Returns whether the file was mapped and is a macro of this version, with no record
+     *          of an unknown kind, key, button or state.
+     */
+    bool valid() const;
+
+    /**
+     * \brief   Returns the records of the macro, which point into the mapping.
+     */
+    std::span<const MacroRecord> records() const;
+
+  private:
+    const void*        mapping = nullptr;
+    std::size_t        length  = 0;
+    const MacroRecord* entries = nullptr;
+    std::size_t        count   = 0;
+  };
+
+  /**
+   * \brief     Replays a macro as fast as the platform accepts it, ignoring its delays.
+   * \details   Consecutive events of the same kind are handed to the injector together, unpacked at
+   *            most 1024 at a time into buffers the injector reuses. Once those have grown, which
+   *            the first replay through an injector does, replay allocates nothing.
+   * \param[in] injector The context to inject through.
+   * \param[in] injectee The object that will receive the events.
+   * \param[in] records The records of the macro.
+   * \return    The number of events accepted, stopping at the first event not accepted.
+   * \throws    std::runtime_error If the injectee is not a valid window object on a given platform.
+   */
+  std::size_t replayMacro(Injector& injector, HandleID injectee, std::span<const MacroRecord> records);
+}
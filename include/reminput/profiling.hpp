@@ -0,0 +1,174 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/**
+ * \file
+ * \brief   Latency histograms for each stage of an injection.
+ * \details The library only records these when built with `BUILD_PROFILING`; otherwise the
+ *          instrumentation is compiled out and every snapshot is empty. Each thread records into
+ *          histograms of its own without locks or shared writes, and a snapshot sums them.
+ */
+#pragma once
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+namespace simular::reminput {
+  /**
+   * \brief   A stage of an injection that is timed separately.
+   */
+  enum class ProfileStage : uint8_t {
+    Validate,  /**< Checking the injectee, such as `IsWindow`. */
+    Translate, /**< Mapping keys and buttons while building the native buffer. */
+    Submit,    /**< The call that hands the native buffer to the OS. */
+  };
+
+  /**
+   * \brief   The number of stages in `ProfileStage`.
+   */
+  constexpr std::size_t kProfileStageCount = 3;
+
+  /**
+   * \brief   A histogram of durations in nanoseconds with log-linear buckets.
+   * \details Like an HDR histogram, every power of two is split into `kSubBuckets` linear buckets,
+   *          so any recorded value is known to within 1 / `kSubBuckets` of itself. Durations past
+   *          `kMaxValue` are counted in the last bucket.
+   */
+  struct LatencyHistogram final {
+    static constexpr unsigned    kSubBucketBits = 3;
+    static constexpr uint64_t    kSubBuckets    = uint64_t{1} << kSubBucketBits;
+    static constexpr unsigned    kMaxValueBits  = 40;
+    static constexpr uint64_t    kMaxValue      = (uint64_t{1} << kMaxValueBits) - 1;
+    static constexpr std::size_t kBucketCount   = (kMaxValueBits - kSubBucketBits + 1) * kSubBuckets;
+
+    /**
+     * \brief     Finds the bucket a duration is counted in.
+     * \param[in] value The duration in nanoseconds.
+     */
+    static constexpr std::size_t bucketOf(uint64_t value) {
+      value = value > kMaxValue ? kMaxValue : value;
+      if (value < kSubBuckets)
+        return static_cast<std::size_t>(value);
+
+      auto shift = static_cast<unsigned>(std::bit_width(value)) - 1 - kSubBucketBits;
+      return static_cast<std::size_t>((shift + 1) * kSubBuckets + ((value >> shift) - kSubBuckets));
+    }
+
+    /**
+     * \brief     Finds the largest duration counted in a bucket.
+     * \param[in] bucket The index of the bucket.
+     */
+    static constexpr uint64_t bucketUpperBound(std::size_t bucket) {
+      if (bucket < kSubBuckets)
+        return bucket;
+
+      auto shift    = static_cast<unsigned>(bucket / kSubBuckets) - 1;
+      auto mantissa = bucket % kSubBuckets + kSubBuckets;
+      return ((mantissa + 1) << shift) - 1;
+    }
+
+    /**
+     * \brief     Counts a duration.
+     * \param[in] value The duration in nanoseconds.
+     */
+    constexpr void record(uint64_t value) {
+      counts[bucketOf(value)]++;
+    }
+
+    /**
+     * \brief   Returns the number of durations recorded.
+     */
+    constexpr uint64_t total() const {
+      uint64_t sum = 0;
+      for (auto count : counts)
+        sum += count;
+      return sum;
+    }
+
+    /**
+     * \brief     Returns the duration at or under which the given fraction of durations fall.
+     * \param[in] fraction The fraction to look for, such as 0.99 for the 99th percentile.
+     * \return    The upper bound of the bucket holding that duration, or zero when empty.
+     */
+    constexpr uint64_t percentile(double fraction) const {
+      auto sum = total();
+      if (sum == 0)
+        return 0;
+
+      auto target  = static_cast<uint64_t>(fraction * static_cast<double>(sum));
+      auto running = uint64_t{0};
+      for (std::size_t bucket = 0; bucket < kBucketCount; bucket++) {
+        running += counts[bucket];
+        if (running > target || running == sum)
+          return bucketUpperBound(bucket);
+      }
+
+      return kMaxValue;
+    }
+
+    /**
+     * \brief   The number of durations counted in each bucket.
+     */
+    std::array<uint64_t, kBucketCount> counts{};
+  };
+
+  /**
+   * \brief   Everything recorded by the instrumentation, summed over every thread.
+   */
+  struct ProfileSnapshot final {
+    /**
+     * \brief   The durations of each stage, indexed by `ProfileStage`.
+     */
+    std::array<LatencyHistogram, kProfileStageCount> stages{};
+
+    /**
+     * \brief   The number of events callers asked to inject.
+     */
+    uint64_t requested = 0;
+
+    /**
+     * \brief   The number of events the platform accepted.
+     */
+    uint64_t accepted = 0;
+
+    /**
+     * \brief     Returns the histogram of a stage.
+     * \param[in] stage The stage to look up.
+     */
+    constexpr const LatencyHistogram& operator[](ProfileStage stage) const {
+      return stages[static_cast<std::size_t>(stage)];
+    }
+  };
+
+  /**
+   * \brief   Sums what every thread has recorded so far.
+   * \details This does not stop threads from injecting, so a snapshot taken while they do may miss
+   *          their latest few records.
+   */
+  ProfileSnapshot profileSnapshot();
+
+  /**
+   * \brief   Clears what every thread has recorded so far.
+   * \details Records made by threads injecting at the same time may survive the reset.
+   */
+  void resetProfile();
+}
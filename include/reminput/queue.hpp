@@ -0,0 +1,149 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/**
+ * \file
+ * \brief   An opt-in asynchronous mode, where callers queue events and a dispatcher thread injects.
+ * \details Producers never wait on the platform. Events are placed in a bounded lock-free ring that
+ *          any number of threads may enqueue into, and a single dispatcher thread drains it in
+ *          batches into the platform backend.
+ */
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <reminput/reminput.hpp>
+
+namespace simular::reminput {
+  /**
+   * \brief   What to do when an event is enqueued into a full queue.
+   */
+  enum class QueuePolicy {
+    Block,      /**< Wait for the dispatcher to make room. */
+    DropOldest, /**< Discard the oldest queued event to make room. */
+    Fail,       /**< Reject the new event. */
+  };
+
+  /**
+   * \brief   An event waiting in the queue, along with who should receive it.
+   */
+  struct QueuedEvent final {
+    /**
+     * \brief   The object that will receive the event.
+     */
+    HandleID injectee;
+
+    /**
+     * \brief   The event, packed.
+     */
+    InputEvent data;
+  };
+  static_assert(sizeof(QueuedEvent) <= 24);
+
+  /**
+   * \brief   Counters describing what happened to the events given to an asynchronous injector.
+   */
+  struct AsyncStatistics final {
+    /**
+     * \brief   Events the platform accepted.
+     */
+    uint64_t submitted;
+
+    /**
+     * \brief   Events that were dequeued but not accepted, such as those for a closed window.
+     */
+    uint64_t failed;
+
+    /**
+     * \brief   Events that were discarded or rejected because the queue was full.
+     */
+    uint64_t dropped;
+
+    /**
+     * \brief   Moves that were not injected because a newer move for the same injectee replaced them.
+     */
+    uint64_t coalesced;
+  };
+
+  /**
+   * \brief   Injects events on a dedicated dispatcher thread.
+   * \details Enqueuing is lock-free and safe from any number of threads. Events for the same
+   *          injectee are injected in the order they were enqueued by a single thread. Since
+   *          injection happens later, invalid injectees are counted as failures instead of
+   *          throwing.
+   */
+  class AsyncInjector final {
+  public:
+    /**
+     * \brief     Starts the dispatcher thread.
+     * \param[in] capacity The number of events the queue can hold, rounded up to a power of two.
+     * \param[in] policy What to do when enqueuing into a full queue.
+     */
+    explicit AsyncInjector(std::size_t capacity = 4096, QueuePolicy policy = QueuePolicy::Block);
+
+    /**
+     * \brief   Injects everything still queued and stops the dispatcher thread.
+     */
+    ~AsyncInjector();
+
+    AsyncInjector(const AsyncInjector&) = delete;
+    AsyncInjector& operator=(const AsyncInjector&) = delete;
+
+    /**
+     * \brief     Queues a key event for injection.
+     * \param[in] injectee The object that will receive the key event injection.
+     * \param[in] data The data for the key event.
+     * \return    False if the event was rejected because the queue was full.
+     */
+    bool enqueue(HandleID injectee, const KeyEventData& data);
+
+    /**
+     * \brief     Queues a mouse event for injection.
+     * \param[in] injectee The object that will receive the mouse event injection.
+     * \param[in] data The data for the mouse event.
+     * \return    False if the event was rejected because the queue was full.
+     */
+    bool enqueue(HandleID injectee, const MouseEventData& data);
+
+    /**
+     * \brief     Sets whether consecutive pure moves for the same injectee are collapsed to the newest.
+     * \details   Applies to moves drained together, so it only takes effect when producers outrun the
+     *            dispatcher. Buttons, wheel steps and key events are never dropped or reordered. Off
+     *            by default.
+     * \param[in] enabled Whether to coalesce moves.
+     */
+    void setMoveCoalescing(bool enabled);
+
+    /**
+     * \brief   Waits until every event enqueued before this call has been injected or dropped.
+     */
+    void flush();
+
+    /**
+     * \brief   Returns the counters of this injector.
+     */
+    AsyncStatistics statistics() const;
+
+  private:
+    struct Queue;
+    std::unique_ptr<Queue> queue;
+  };
+}
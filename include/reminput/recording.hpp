@@ -0,0 +1,197 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/**
+ * \file
+ * \brief   Records injections into a memory-mapped log instead of sending them to the platform.
+ * \details While recording, every event that passes validation is translated into a fixed-size
+ *          record with a timestamp and appended to a ring stored in a file, and nothing reaches the
+ *          platform. This lets injection run at full speed on machines without a desktop, and the
+ *          logs of two runs can be compared record by record. Recording can be started from code,
+ *          or for a whole process by setting `REMINPUT_RECORD` to the path of the log.
+ */
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <reminput/reminput.hpp>
+
+namespace simular::reminput {
+  /**
+   * \brief   Describes the log to record into.
+   */
+  struct RecordingOptions final {
+    /**
+     * \brief   The path of the log, which is created or truncated.
+     */
+    const char* path = "reminput.log";
+
+    /**
+     * \brief   The number of records the ring holds before it overwrites the oldest.
+     * \details Rounded up to a power of two.
+     */
+    std::size_t capacity = std::size_t{1} << 20;
+  };
+
+  /**
+   * \brief   A single recorded event.
+   * \details Keys and buttons are stored as their `InputKey` and `MouseButton` values, so logs do
+   *          not depend on the platform they were recorded on.
+   */
+  struct RecordedEvent final {
+    /**
+     * \brief   Which kind of event was recorded.
+     */
+    enum class Kind : uint8_t {
+      Keyboard,
+      Mouse,
+      Unicode, /**< A character typed without a key, its code point held in `xpos`. */
+      Motion,  /**< A relative mouse motion, its whole pixel deltas held in `xpos` and `ypos`. */
+    };
+
+    /**
+     * \brief   One more than the position of the record in the log, written last.
+     * \details Set to zero before the rest is written. A record whose sequence does not match its
+     *          position was still being written or has been overwritten.
+     */
+    uint64_t sequence;
+
+    /**
+     * \brief   Nanoseconds between the start of the recording and the injection.
+     */
+    uint64_t timestamp;
+
+    /**
+     * \brief   The injectee the event was sent to.
+     */
+    uint64_t injectee;
+
+    /**
+     * \brief   The absolute location of the mouse on the x-axis, for mouse events.
+     */
+    int32_t xpos;
+
+    /**
+     * \brief   The absolute location of the mouse on the y-axis, for mouse events.
+     */
+    int32_t ypos;
+
+    /**
+     * \brief   Which kind of event was recorded.
+     */
+    Kind kind;
+
+    /**
+     * \brief   The `InputKey` of a key event, or the `MouseButton` of a mouse event.
+     */
+    uint8_t code;
+
+    /**
+     * \brief   The `InputState` of the key or button.
+     */
+    uint8_t state;
+
+    /**
+     * \brief   The scroll wheel steps, for mouse events.
+     */
+    int8_t scrolldy;
+
+    uint32_t reserved;
+  };
+  static_assert(sizeof(RecordedEvent) == 40);
+
+  /**
+   * \brief     Starts diverting every injection into a new log.
+   * \details   Any recording in progress is stopped first. While recording, any non-null injectee is
+   *            considered valid.
+   * \param[in] options The log to record into.
+   * \return    False if the log could not be created, in which case injections are not diverted.
+   */
+  bool startRecording(const RecordingOptions& options);
+
+  /**
+   * \brief   Stops recording, sending injections to the platform again.
+   * \details The log stays mapped until the process exits, so threads still finishing a batch never
+   *          write into unmapped memory.
+   */
+  void stopRecording();
+
+  /**
+   * \brief   Returns whether injections are currently being recorded.
+   */
+  bool isRecording();
+
+  /**
+   * \brief   A read-only view of a log, which may still be being recorded into.
+   */
+  class RecordingLog final {
+  public:
+    /**
+     * \brief     Maps the log at the given path.
+     * \param[in] path The path of the log.
+     */
+    explicit RecordingLog(const char* path);
+
+    /**
+     * \brief   Unmaps the log.
+     */
+    ~RecordingLog();
+
+    RecordingLog(const RecordingLog&) = delete;
+    RecordingLog& operator=(const RecordingLog&) = delete;
+
+    /**
+     * \brief   Returns whether the log was mapped and is a log.
+     */
+    bool valid() const;
+
+    /**
+     * \brief   Returns the number of records still in the ring.
+     */
+    std::size_t size() const;
+
+    /**
+     * \brief   Returns the number of records ever appended, including overwritten ones.
+     */
+    uint64_t appended() const;
+
+    /**
+     * \brief     Returns a record, oldest first.
+     * \details   The record is read in place, so while the log is still being recorded into it may
+     *            be overwritten as it is read. Use `read` to copy it safely.
+     * \param[in] index The index of the record, less than `size()`.
+     */
+    const RecordedEvent& operator[](std::size_t index) const;
+
+    /**
+     * \brief      Copies a record, oldest first, if it is whole.
+     * \param[in]  index The index of the record, less than `size()`.
+     * \param[out] event The copy of the record.
+     * \return     False if the record was being written or was overwritten since the ring was
+     *             measured, in which case the copy must not be used.
+     */
+    bool read(std::size_t index, RecordedEvent& event) const;
+
+  private:
+    const void*          mapping = nullptr;
+    std::size_t          length  = 0;
+    const RecordedEvent* records = nullptr;
+  };
+}
@@ -25,25 +25,52 @@
  * \details
  */
 #pragma once
+#include <array>
+#include <chrono>
+#include <cstddef>
 #include <cstdint>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <type_traits>
+
+// Expands `KEY(name)` once per keyboard key, in the order of `InputKey`. This list is the one
+// definition of the keys; the enumeration, the key names and every backend table are built from it.
+#define REMINPUT_INPUT_KEYS(KEY) \
+  KEY(Undefined) KEY(A) KEY(B) KEY(C) KEY(D) KEY(E) KEY(F) KEY(G) KEY(H) KEY(I) KEY(J) KEY(K)  \
+  KEY(L) KEY(M) KEY(N) KEY(O) KEY(P) KEY(Q) KEY(R) KEY(S) KEY(T) KEY(U) KEY(V) KEY(W) KEY(X)   \
+  KEY(Y) KEY(Z) KEY(NumBar0) KEY(NumBar1) KEY(NumBar2) KEY(NumBar3) KEY(NumBar4) KEY(NumBar5)  \
+  KEY(NumBar6) KEY(NumBar7) KEY(NumBar8) KEY(NumBar9) KEY(NumPad0) KEY(NumPad1) KEY(NumPad2)   \
+  KEY(NumPad3) KEY(NumPad4) KEY(NumPad5) KEY(NumPad6) KEY(NumPad7) KEY(NumPad8) KEY(NumPad9)   \
+  KEY(NumLock) KEY(NumPadSlash) KEY(NumPadMul) KEY(NumPadAdd) KEY(NumPadSub) KEY(NumPadDot)    \
+  KEY(NumPadEnter) KEY(LeftShift) KEY(LeftControl) KEY(LeftAlt) KEY(LeftSuper) KEY(RightShift) \
+  KEY(RightControl) KEY(RightAlt) KEY(RightSuper) KEY(ArrowUp) KEY(ArrowRight) KEY(ArrowDown)  \
+  KEY(ArrowLeft) KEY(Enter) KEY(Backspace) KEY(Insert) KEY(Home) KEY(PageUp) KEY(PageDown)     \
+  KEY(Delete) KEY(End) KEY(PrintScreen) KEY(ScrollLock) KEY(Pause) KEY(CapsLock) KEY(Tab)      \
+  KEY(Escape) KEY(Space) KEY(Grave) KEY(Minus) KEY(Equal) KEY(LBracket) KEY(RBracket)          \
+  KEY(Backslash) KEY(Semicolon) KEY(Apostrophe) KEY(Comma) KEY(Period) KEY(ForwardSlash)       \
+  KEY(F1) KEY(F2) KEY(F3) KEY(F4) KEY(F5) KEY(F6) KEY(F7) KEY(F8) KEY(F9) KEY(F10) KEY(F11)    \
+  KEY(F12) KEY(F13) KEY(F14) KEY(F15) KEY(F16) KEY(F17) KEY(F18) KEY(F19) KEY(F20) KEY(F21)    \
+  KEY(F22) KEY(F23) KEY(F24)                                                                  
 
 namespace simular::reminput {
   /**
    * \brief   Represents a keyboard key.
-   * \details
+   * \details The keys are listed once, in `REMINPUT_INPUT_KEYS`.
    */
   enum class InputKey {
-    Undefined,
-    A, B, C, D, E, F, G, H, I, J, K, L, M, N, O, P, Q, R, S, T, U, V, W, X, Y, Z,
-    NumBar0, NumBar1, NumBar2, NumBar3, NumBar4, NumBar5, NumBar6, NumBar7, NumBar8, NumBar9,
-    NumPad0, NumPad1, NumPad2, NumPad3, NumPad4, NumPad5, NumPad6, NumPad7, NumPad8, NumPad9,
-    NumLock, NumPadSlash, NumPadMul, NumPadAdd, NumPadSub, NumPadDot, NumPadEnter,
-    LeftShift, LeftControl, LeftAlt, LeftSuper, RightShift, RightControl, RightAlt, RightSuper, ArrowUp, ArrowRight, ArrowDown, ArrowLeft,
-    Enter, Backspace, Insert, Home, PageUp, PageDown, Delete, End, PrintScreen, ScrollLock, Pause, CapsLock, Tab, Escape, Space,
-    Grave, Minus, Equal, LBracket, RBracket, Backslash, Semicolon, Apostrophe, Comma, Period, ForwardSlash,
-    F1, F2, F3, F4, F5, F6, F7, F8, F9, F10, F11, F12, F13, F14, F15, F16, F17, F18, F19, F20, F21, F22, F23, F24,
+#define REMINPUT_INPUT_KEY_ENUMERATOR(name) name,
+    REMINPUT_INPUT_KEYS(REMINPUT_INPUT_KEY_ENUMERATOR)
+#undef REMINPUT_INPUT_KEY_ENUMERATOR
   };
 
+  /**
+   * \brief   The number of keys in `InputKey`, including `InputKey::Undefined`.
+   */
+#define REMINPUT_INPUT_KEY_COUNT(name) + 1
+  constexpr std::size_t kInputKeyCount = 0 REMINPUT_INPUT_KEYS(REMINPUT_INPUT_KEY_COUNT);
+#undef REMINPUT_INPUT_KEY_COUNT
+
   /**
    * \brief   Represents the state of a given input.
    * \return
@@ -100,16 +127,62 @@ namespace simular::reminput {
     InputState state;
   };
 
+  /**
+   * \brief   How an injection went, as reported by the functions that never throw.
+   */
+  enum class InjectStatus : uint8_t {
+    Ok,              /**< The platform accepted everything. */
+    InvalidInjectee, /**< The injectee failed validation, so nothing was sent. */
+    Partial,         /**< Only some events, counted from the front of the batch, were accepted, text
+                          was cut short at a character no key types, or packed events stopped at a
+                          record with an unknown kind, key, button or state. */
+    BackendFailure,  /**< The platform accepted nothing, such as when the device could not be opened,
+                          or memory ran out while translating. */
+  };
+
+  /**
+   * \brief   The outcome of an injection that never throws.
+   * \details Converts to true only when everything was accepted.
+   */
+  struct InjectResult final {
+    /**
+     * \brief   How the injection went.
+     */
+    InjectStatus status = InjectStatus::Ok;
+
+    /**
+     * \brief   The number of events, counted from the front of the batch, that the platform accepted.
+     */
+    std::size_t accepted = 0;
+
+    constexpr explicit operator bool() const noexcept {
+      return status == InjectStatus::Ok;
+    }
+  };
+
   /**
    * \brief     Injects a key event into the event stream of the given injectee.
    * \details   On most systems, the native platform window object processes events that are sent to
    *            it. Applications can send events themselves to trigger things within the application.
    * \param[in] injectee The object that will receive the key event injection.
    * \param[in] data The data for the key event.
-   * \throws    std::runtime_error If the injectee is not a valid window object on a given platform.
+   * \throws    std::runtime_error If the injectee is not a valid window object on a given platform. A
+   *            library built without exceptions aborts instead, so such builds should call the
+   *            `tryInject` functions.
    */
   void injectKeyboardEvent(HandleID injectee, const KeyEventData& data);
 
+  /**
+   * \brief     Injects a batch of key events into the event stream of the given injectee.
+   * \details   The injectee is validated once for the whole batch, and the events are handed to the
+   *            platform together and in order, rather than one call per event.
+   * \param[in] injectee The object that will receive the key event injections.
+   * \param[in] data The key events to send, in the order they should be received.
+   * \return    The number of events, counted from the front of `data`, that the platform accepted.
+   * \throws    std::runtime_error If the injectee is not a valid window object on a given platform.
+   */
+  std::size_t injectKeyboardEvents(HandleID injectee, std::span<const KeyEventData> data);
+
   /**
    * \brief   Represents mouse event data to be sent to the injectee.
    * \details This contains the scroll delta, the move delta, the button, and the state of the
@@ -119,14 +192,16 @@ namespace simular::reminput {
     /**
      * \brief   The absolute location of the mouse on the x-axis.
      * \details This value is the absolute location of the cursor x-position on the desktop virtual
-     *          space. **This should be in screen space**.
+     *          space. **This should be in screen space**, unless the injector was set to another
+     *          `CoordinateSpace`.
      */
     int32_t xpos;
 
     /**
      * \brief   The absolute location of the mouse on the y-axis.
      * \details This value is the absolute location of the cursor y-position on the desktop virtual
-     *          space. **This should be in screen space**.
+     *          space. **This should be in screen space**, unless the injector was set to another
+     *          `CoordinateSpace`.
      */
     int32_t ypos;
 
@@ -152,6 +227,246 @@ namespace simular::reminput {
     InputState state;
   };
 
+  /**
+   * \brief   The number of bits of a relative motion delta below the pixel.
+   */
+  constexpr int kSubpixelBits = 8;
+
+  /**
+   * \brief   The delta of a relative motion that moves the mouse by one pixel.
+   */
+  constexpr int32_t kSubpixelScale = int32_t{1} << kSubpixelBits;
+
+  /**
+   * \brief   Represents relative mouse motion to be sent to the injectee.
+   * \details Deltas are fixed point, in 1/`kSubpixelScale` of a pixel. Each injectee keeps what is
+   *          left over after rounding to whole pixels and adds it to its next motion, so a long
+   *          stream of tiny deltas moves exactly as far as their sum, neither drifting nor stalling.
+   *          A button and wheel steps can go with the motion, so the mouse can be driven without
+   *          ever knowing where the cursor is. The platform may apply pointer acceleration.
+   */
+  struct MouseMotionData final {
+    /**
+     * \brief   How far to move on the x-axis, in 1/`kSubpixelScale` of a pixel.
+     */
+    int32_t dx;
+
+    /**
+     * \brief   How far to move on the y-axis, in 1/`kSubpixelScale` of a pixel.
+     */
+    int32_t dy;
+
+    /**
+     * \brief   The amount of times the scroll wheel moved on the y-axis, as in `MouseEventData`.
+     */
+    int8_t scrolldy;
+
+    /**
+     * \brief   A button whose state should be changed, or `MouseButton::Undefined` for none.
+     */
+    MouseButton button;
+
+    /**
+     * \brief   The state of the button.
+     */
+    InputState state;
+  };
+
+  /**
+   * \brief   A key, button, move or wheel event packed into sixteen bytes.
+   * \details Enumerations are stored as bytes, so the record is trivially copyable and has no
+   *          padding. Arrays of it can be copied with `memcpy`, written to files or shared memory as
+   *          they are, and four of them fit in a cache line. Batches, queues and macros all carry
+   *          events in this form.
+   */
+  struct InputEvent final {
+    /**
+     * \brief   What the record holds.
+     * \details A wait only carries a delay, for gaps too long for one record.
+     */
+    enum class Kind : uint8_t {
+      Keyboard,
+      Mouse,
+      Wait,
+    };
+
+    /**
+     * \brief   Nanoseconds to wait after the event before this one, or zero when untimed.
+     */
+    uint32_t delay = 0;
+
+    /**
+     * \brief   What the record holds.
+     */
+    Kind kind = Kind::Wait;
+
+    /**
+     * \brief   The `InputKey` of a key event, or the `MouseButton` of a mouse event.
+     */
+    uint8_t code = 0;
+
+    /**
+     * \brief   The `InputState` of the key or button.
+     */
+    uint8_t state = 0;
+
+    /**
+     * \brief   The scroll wheel steps, for mouse events.
+     */
+    int8_t scrolldy = 0;
+
+    /**
+     * \brief   The absolute location of the mouse on the x-axis, for mouse events.
+     */
+    int32_t xpos = 0;
+
+    /**
+     * \brief   The absolute location of the mouse on the y-axis, for mouse events.
+     */
+    int32_t ypos = 0;
+
+    /**
+     * \brief     Packs a key event.
+     * \param[in] data The key event.
+     * \param[in] delay Nanoseconds to wait after the event before this one.
+     */
+    static constexpr InputEvent fromKeyboard(const KeyEventData& data, uint32_t delay = 0) {
+      return InputEvent {
+        .delay = delay,
+        .kind  = Kind::Keyboard,
+        .code  = static_cast<uint8_t>(data.key),
+        .state = static_cast<uint8_t>(data.state),
+      };
+    }
+
+    /**
+     * \brief     Packs a mouse event.
+     * \param[in] data The mouse event.
+     * \param[in] delay Nanoseconds to wait after the event before this one.
+     */
+    static constexpr InputEvent fromMouse(const MouseEventData& data, uint32_t delay = 0) {
+      return InputEvent {
+        .delay    = delay,
+        .kind     = Kind::Mouse,
+        .code     = static_cast<uint8_t>(data.button),
+        .state    = static_cast<uint8_t>(data.state),
+        .scrolldy = data.scrolldy,
+        .xpos     = data.xpos,
+        .ypos     = data.ypos,
+      };
+    }
+
+    /**
+     * \brief     Makes a record that only waits.
+     * \param[in] delay Nanoseconds to wait after the event before this one.
+     */
+    static constexpr InputEvent wait(uint32_t delay) {
+      return InputEvent { .delay = delay, .kind = Kind::Wait };
+    }
+
+    /**
+     * \brief   Returns the key event of a keyboard record.
+     */
+    constexpr KeyEventData keyboard() const {
+      return KeyEventData {
+        .key   = static_cast<InputKey>(code),
+        .state = static_cast<InputState>(state),
+      };
+    }
+
+    /**
+     * \brief   Returns the mouse event of a mouse record.
+     */
+    constexpr MouseEventData mouse() const {
+      return MouseEventData {
+        .xpos     = xpos,
+        .ypos     = ypos,
+        .scrolldy = scrolldy,
+        .button   = static_cast<MouseButton>(code),
+        .state    = static_cast<InputState>(state),
+      };
+    }
+  };
+  static_assert(sizeof(InputEvent) == 16 && std::is_trivially_copyable_v<InputEvent>);
+
+  /**
+   * \brief   A set of keys and mouse buttons, such as those held down.
+   * \details One bit per key and button, packed into words so that comparing two sets takes a
+   *          handful of word operations.
+   */
+  struct InputSet final {
+    /**
+     * \brief   The number of words the key bits take.
+     */
+    static constexpr std::size_t kKeyWords = (kInputKeyCount + 63) / 64;
+
+    /**
+     * \brief   The key bits, where bit `n % 64` of word `n / 64` is the key of value `n`.
+     */
+    std::array<uint64_t, kKeyWords> keys{};
+
+    /**
+     * \brief   The button bits, where bit `n` is the button of value `n`.
+     */
+    uint32_t buttons = 0;
+
+    /**
+     * \brief     Adds the key to, or removes it from, the set. Values past the last key are ignored.
+     * \param[in] key The key.
+     * \param[in] held Whether the key belongs in the set.
+     */
+    constexpr void set(InputKey key, bool held = true) {
+      auto index = static_cast<std::size_t>(key);
+      if (index >= kInputKeyCount)
+        return;
+      auto bit   = uint64_t{1} << (index % 64);
+      keys[index / 64] = held ? keys[index / 64] | bit : keys[index / 64] & ~bit;
+    }
+
+    /**
+     * \brief     Adds the button to, or removes it from, the set. `MouseButton::Undefined` and values
+     *            past the last button are ignored.
+     * \param[in] button The button.
+     * \param[in] held Whether the button belongs in the set.
+     */
+    constexpr void set(MouseButton button, bool held = true) {
+      if (button == MouseButton::Undefined || static_cast<uint32_t>(button) > static_cast<uint32_t>(MouseButton::Button4))
+        return;
+      auto bit = uint32_t{1} << static_cast<uint32_t>(button);
+      buttons  = held ? buttons | bit : buttons & ~bit;
+    }
+
+    /**
+     * \brief     Checks whether the key is in the set, never true for values past the last key.
+     * \param[in] key The key.
+     */
+    constexpr bool test(InputKey key) const {
+      auto index = static_cast<std::size_t>(key);
+      return index < kInputKeyCount && (keys[index / 64] >> (index % 64)) & 1;
+    }
+
+    /**
+     * \brief     Checks whether the button is in the set, never true for values past the last button.
+     * \param[in] button The button.
+     */
+    constexpr bool test(MouseButton button) const {
+      auto index = static_cast<uint32_t>(button);
+      return index <= static_cast<uint32_t>(MouseButton::Button4) && (buttons >> index) & 1;
+    }
+
+    /**
+     * \brief   Checks whether the set holds nothing.
+     */
+    constexpr bool empty() const {
+      for (auto word : keys)
+        if (word)
+          return false;
+      return buttons == 0;
+    }
+
+    constexpr bool operator==(const InputSet&) const = default;
+  };
+
   /**
    * \brief     Injects a mouse event into the event stream of the given injectee.
    * \details   On most systems, the native platform window object processes events that are sent to
@@ -161,4 +476,545 @@ namespace simular::reminput {
    * \throws    std::runtime_error If the injectee is not a valid window object on a given platform.
    */
   void injectMouseEvent(HandleID injectee, const MouseEventData& data);
+
+  /**
+   * \brief     Injects a batch of mouse events into the event stream of the given injectee.
+   * \details   The injectee is validated once for the whole batch, and the events are handed to the
+   *            platform together and in order, rather than one call per event.
+   * \param[in] injectee The object that will receive the mouse event injections.
+   * \param[in] data The mouse events to send, in the order they should be received.
+   * \return    The number of events, counted from the front of `data`, that the platform accepted.
+   * \throws    std::runtime_error If the injectee is not a valid window object on a given platform.
+   */
+  std::size_t injectMouseEvents(HandleID injectee, std::span<const MouseEventData> data);
+
+  /**
+   * \brief     Moves the mouse of the given injectee relative to where it is.
+   * \details   Injects `REL_X` and `REL_Y` through uinput, `MOUSEEVENTF_MOVE` without
+   *            `MOUSEEVENTF_ABSOLUTE` on Windows, and relative XTest motion on X11. The position
+   *            absolute mouse events skip repeated moves against is forgotten.
+   * \param[in] injectee The object that will receive the motion.
+   * \param[in] data The motion.
+   * \throws    std::runtime_error If the injectee is not a valid window object on a given platform.
+   */
+  void injectMouseMotion(HandleID injectee, const MouseMotionData& data);
+
+  /**
+   * \brief     Moves the mouse of the given injectee relative to where it is, once per motion.
+   * \details   Motions that add up to less than a pixel, with no button and no wheel steps, are
+   *            carried into the next motion instead of being sent, and count as accepted.
+   * \param[in] injectee The object that will receive the motion.
+   * \param[in] data The motions to send, in the order they should be received.
+   * \return    The number of motions, counted from the front of `data`, that were accepted.
+   * \throws    std::runtime_error If the injectee is not a valid window object on a given platform.
+   */
+  std::size_t injectMouseMotions(HandleID injectee, std::span<const MouseMotionData> data);
+
+  /**
+   * \brief     Types UTF-8 text into the given injectee as one batch of key events.
+   * \details   Characters are mapped to keys as on a US keyboard, and shift is only pressed and
+   *            released where the case changes. On platforms that can type characters without a
+   *            key, such as Windows, other characters are typed that way; elsewhere typing stops
+   *            before the first of them.
+   * \param[in] injectee The object that will receive the text.
+   * \param[in] text The text to type.
+   * \return    The number of characters, counted from the front of `text`, that were typed.
+   * \throws    std::runtime_error If the injectee is not a valid window object on a given platform.
+   */
+  std::size_t injectText(HandleID injectee, std::u8string_view text);
+
+  /**
+   * \brief     Injects a key event, reporting a bad injectee in the result instead of throwing.
+   * \param[in] injectee The object that will receive the key event injection.
+   * \param[in] data The data for the key event.
+   * \return    How the injection went.
+   */
+  InjectResult tryInjectKeyboardEvent(HandleID injectee, const KeyEventData& data) noexcept;
+
+  /**
+   * \brief     Injects a batch of key events, reporting a bad injectee in the result instead of throwing.
+   * \param[in] injectee The object that will receive the key event injections.
+   * \param[in] data The key events to send, in the order they should be received.
+   * \return    How the injection went.
+   */
+  InjectResult tryInjectKeyboardEvents(HandleID injectee, std::span<const KeyEventData> data) noexcept;
+
+  /**
+   * \brief     Injects a mouse event, reporting a bad injectee in the result instead of throwing.
+   * \param[in] injectee The object that will receive the mouse event injection.
+   * \param[in] data The mouse event data to send to the injectee event stream.
+   * \return    How the injection went.
+   */
+  InjectResult tryInjectMouseEvent(HandleID injectee, const MouseEventData& data) noexcept;
+
+  /**
+   * \brief     Injects a batch of mouse events, reporting a bad injectee in the result instead of throwing.
+   * \param[in] injectee The object that will receive the mouse event injections.
+   * \param[in] data The mouse events to send, in the order they should be received.
+   * \return    How the injection went.
+   */
+  InjectResult tryInjectMouseEvents(HandleID injectee, std::span<const MouseEventData> data) noexcept;
+
+  /**
+   * \brief     Moves the mouse relatively, reporting a bad injectee in the result instead of throwing.
+   * \param[in] injectee The object that will receive the motion.
+   * \param[in] data The motion.
+   * \return    How the injection went.
+   */
+  InjectResult tryInjectMouseMotion(HandleID injectee, const MouseMotionData& data) noexcept;
+
+  /**
+   * \brief     Moves the mouse relatively once per motion, reporting a bad injectee in the result instead of throwing.
+   * \param[in] injectee The object that will receive the motion.
+   * \param[in] data The motions to send, in the order they should be received.
+   * \return    How the injection went.
+   */
+  InjectResult tryInjectMouseMotions(HandleID injectee, std::span<const MouseMotionData> data) noexcept;
+
+  /**
+   * \brief     Types UTF-8 text, reporting a bad injectee in the result instead of throwing.
+   * \details   `accepted` counts characters. Text cut short at a character no key types reports
+   *            `Partial`, as does text whose key events were only accepted in part.
+   * \param[in] injectee The object that will receive the text.
+   * \param[in] text The text to type.
+   * \return    How the injection went.
+   */
+  InjectResult tryInjectText(HandleID injectee, std::u8string_view text) noexcept;
+
+  /**
+   * \brief     Injects a batch of packed events of any kind into the event stream of the given injectee.
+   * \details   Runs of key events and runs of mouse events are each handed to the platform in
+   *            batches of up to 1024. Delays are ignored, and waits are skipped; a `Scheduler`
+   *            honours them. The batch stops at the first record that is not valid.
+   * \param[in] injectee The object that will receive the events.
+   * \param[in] data The events to send, in the order they should be received.
+   * \return    The number of records, counted from the front of `data`, that were accepted.
+   * \throws    std::runtime_error If the injectee is not a valid window object on a given platform.
+   */
+  std::size_t injectEvents(HandleID injectee, std::span<const InputEvent> data);
+
+  /**
+   * \brief     Injects a batch of packed events, reporting a bad injectee in the result instead of throwing.
+   * \param[in] injectee The object that will receive the events.
+   * \param[in] data The events to send, in the order they should be received.
+   * \return    How the injection went, with `accepted` counting records.
+   */
+  InjectResult tryInjectEvents(HandleID injectee, std::span<const InputEvent> data) noexcept;
+
+  /**
+   * \brief     Presses and releases whatever it takes for exactly the given keys and buttons to be held.
+   * \details   Only the differences from what was last sent to the injectee are injected, releases
+   *            first. Buttons go down and up wherever the pointer is, without moving it.
+   * \param[in] injectee The object that will receive the events.
+   * \param[in] desired The keys and buttons that should be held afterwards.
+   * \return    The number of presses and releases accepted.
+   * \throws    std::runtime_error If the injectee is not a valid window object on a given platform.
+   */
+  std::size_t setInputState(HandleID injectee, const InputSet& desired);
+
+  /**
+   * \brief     Sets the held keys and buttons, reporting a bad injectee in the result instead of throwing.
+   * \param[in] injectee The object that will receive the events.
+   * \param[in] desired The keys and buttons that should be held afterwards.
+   * \return    How the injection went, with `accepted` counting presses and releases.
+   */
+  InjectResult trySetInputState(HandleID injectee, const InputSet& desired) noexcept;
+
+  /**
+   * \brief     Releases every key and button held down in the injectee.
+   * \param[in] injectee The object that will receive the events.
+   * \return    The number of releases accepted.
+   * \throws    std::runtime_error If the injectee is not a valid window object on a given platform.
+   */
+  std::size_t releaseAll(HandleID injectee);
+
+  class CompiledSequence;
+
+  /**
+   * \brief     Injects a sequence that was translated ahead of time.
+   * \details   The native records are submitted as they are, one call per run of the same kind.
+   * \param[in] injectee The object that will receive the events.
+   * \param[in] sequence The translated events.
+   * \return    The number of events, counted from the front of the sequence, that were accepted.
+   * \throws    std::runtime_error If the injectee is not a valid window object on a given platform.
+   */
+  std::size_t injectSequence(HandleID injectee, const CompiledSequence& sequence);
+
+  /**
+   * \brief     Injects a translated sequence, reporting a bad injectee in the result instead of throwing.
+   * \param[in] injectee The object that will receive the events.
+   * \param[in] sequence The translated events.
+   * \return    How the injection went, with `accepted` counting events.
+   */
+  InjectResult tryInjectSequence(HandleID injectee, const CompiledSequence& sequence) noexcept;
+
+  /**
+   * \brief     Sets how long an injectee stays trusted after it was found valid.
+   * \details   Checking an injectee, such as with `IsWindow`, is a lookup in the window manager, so
+   *            the result is cached per injectee and reused until the interval passes, a submission
+   *            is not fully accepted, or the injectee is invalidated. An injectee that is gone is
+   *            therefore reported, by `std::runtime_error` or `InjectStatus::InvalidInjectee`, within
+   *            one interval. Zero checks before every batch. The default is 100 milliseconds.
+   * \param[in] interval How long a successful check is trusted for.
+   */
+  void setValidationInterval(std::chrono::nanoseconds interval);
+
+  /**
+   * \brief     Makes the next injection into the injectee check it again, in every context.
+   * \details   Call this when a window is known to have closed or been replaced, so that its handle
+   *            is not trusted for the rest of the validation interval. The geometry cached with the
+   *            check is read again too, so call it when a window has moved or the desktop changed.
+   *            Other injectees keep their cached checks, apart from the rare one whose handle
+   *            shares a slot with this one.
+   * \param[in] injectee The object whose cached validation should be dropped.
+   */
+  void invalidateInjectee(HandleID injectee);
+
+  /**
+   * \brief   What the positions of absolute mouse events are relative to.
+   * \details Positions are mapped onto what the platform expects with a scale and offset kept for
+   *          each injectee. These are read along with validating the injectee, so they are at most
+   *          one validation interval old unless `invalidateInjectee` is called.
+   */
+  enum class CoordinateSpace : uint8_t {
+    Screen, /**< Pixels on the virtual desktop, which spans every monitor. */
+    Client, /**< Pixels from the top left corner of the client area of the injectee. Where the
+                 injectee is not a window, as with uinput sessions, this is the same as `Screen`. */
+  };
+
+  /**
+   * \brief   What happens to events that arrive faster than a pacing budget allows.
+   */
+  enum class PacingPolicy : uint8_t {
+    Delay,    /**< The injecting thread waits until the events fit the budget. */
+    Coalesce, /**< Runs of pure moves in a throttled mouse batch are collapsed to their newest
+                   position first, and whatever is left waits as with `Delay`. */
+  };
+
+  /**
+   * \brief   Describes the budget every injectee of an `Injector` gets.
+   */
+  struct PacingOptions final {
+    /**
+     * \brief   The most events per second sent to each injectee, or zero for no limit.
+     */
+    uint32_t rate = 0;
+
+    /**
+     * \brief   The most events sent back to back after the injectee was idle. Larger batches are
+     *          split into pieces of this size.
+     */
+    uint32_t burst = 1;
+
+    /**
+     * \brief   What happens to events over the budget.
+     */
+    PacingPolicy policy = PacingPolicy::Delay;
+  };
+
+  /**
+   * \brief   Counters describing how much pacing held an `Injector` back.
+   */
+  struct PacingStatistics final {
+    /**
+     * \brief   The batches, or pieces of batches, that had to wait.
+     */
+    uint64_t throttled = 0;
+
+    /**
+     * \brief   The moves dropped because a throttled batch was coalesced.
+     */
+    uint64_t coalesced = 0;
+
+    /**
+     * \brief   How long injections waited in total.
+     */
+    std::chrono::nanoseconds delayed{0};
+  };
+
+  /**
+   * \brief     Limits how many events per second the whole process sends, across every injector,
+   *            broadcaster and injectee.
+   * \details   The budget is shared through one atomic, so injecting threads never take a lock.
+   *            Events over it wait as with `PacingPolicy::Delay`, or are coalesced first by
+   *            injectors set to `PacingPolicy::Coalesce`. Recordings are never paced. No limit by
+   *            default.
+   * \param[in] rate The most events per second, or zero for no limit.
+   * \param[in] burst The most events sent back to back after the process was idle.
+   */
+  void setGlobalPacing(uint32_t rate, uint32_t burst);
+
+  namespace detail {
+    struct Context;
+  }
+
+  /**
+   * \brief   A context that injects events and keeps the state needed between injections.
+   * \details Cursor positions are tracked per injectee, and events are translated in a buffer the
+   *          context owns, so separate contexts share no mutable state and can inject in parallel. A
+   *          context must only be used by one thread at a time. The free inject functions are
+   *          wrappers over a default context kept for each thread.
+   */
+  class Injector final {
+  public:
+    /**
+     * \brief   Creates a context with no state for any injectee.
+     */
+    Injector();
+
+    /**
+     * \brief   Releases the state of every injectee.
+     */
+    ~Injector();
+
+    Injector(Injector&&) noexcept;
+    Injector& operator=(Injector&&) noexcept;
+
+    /**
+     * \brief     Injects a key event into the event stream of the given injectee.
+     * \param[in] injectee The object that will receive the key event injection.
+     * \param[in] data The data for the key event.
+     * \throws    std::runtime_error If the injectee is not a valid window object on a given platform.
+     */
+    void injectKeyboardEvent(HandleID injectee, const KeyEventData& data);
+
+    /**
+     * \brief     Injects a batch of key events into the event stream of the given injectee.
+     * \param[in] injectee The object that will receive the key event injections.
+     * \param[in] data The key events to send, in the order they should be received.
+     * \return    The number of events, counted from the front of `data`, that the platform accepted.
+     * \throws    std::runtime_error If the injectee is not a valid window object on a given platform.
+     */
+    std::size_t injectKeyboardEvents(HandleID injectee, std::span<const KeyEventData> data);
+
+    /**
+     * \brief     Injects a mouse event into the event stream of the given injectee.
+     * \param[in] injectee The object that will receive the mouse event injection.
+     * \param[in] data The mouse event data to send to the injectee event stream.
+     * \throws    std::runtime_error If the injectee is not a valid window object on a given platform.
+     */
+    void injectMouseEvent(HandleID injectee, const MouseEventData& data);
+
+    /**
+     * \brief     Injects a batch of mouse events into the event stream of the given injectee.
+     * \param[in] injectee The object that will receive the mouse event injections.
+     * \param[in] data The mouse events to send, in the order they should be received.
+     * \return    The number of events, counted from the front of `data`, that the platform accepted.
+     * \throws    std::runtime_error If the injectee is not a valid window object on a given platform.
+     */
+    std::size_t injectMouseEvents(HandleID injectee, std::span<const MouseEventData> data);
+
+    /**
+     * \brief     Moves the mouse of the given injectee relative to where it is.
+     * \param[in] injectee The object that will receive the motion.
+     * \param[in] data The motion.
+     * \throws    std::runtime_error If the injectee is not a valid window object on a given platform.
+     */
+    void injectMouseMotion(HandleID injectee, const MouseMotionData& data);
+
+    /**
+     * \brief     Moves the mouse of the given injectee relative to where it is, once per motion.
+     * \details   What is left of each motion after rounding to whole pixels is kept per injectee and
+     *            carried into the next.
+     * \param[in] injectee The object that will receive the motion.
+     * \param[in] data The motions to send, in the order they should be received.
+     * \return    The number of motions, counted from the front of `data`, that were accepted.
+     * \throws    std::runtime_error If the injectee is not a valid window object on a given platform.
+     */
+    std::size_t injectMouseMotions(HandleID injectee, std::span<const MouseMotionData> data);
+
+    /**
+     * \brief     Types UTF-8 text into the given injectee as one batch of key events.
+     * \param[in] injectee The object that will receive the text.
+     * \param[in] text The text to type.
+     * \return    The number of characters, counted from the front of `text`, that were typed.
+     * \throws    std::runtime_error If the injectee is not a valid window object on a given platform.
+     */
+    std::size_t injectText(HandleID injectee, std::u8string_view text);
+
+    /**
+     * \brief     Injects a key event, reporting a bad injectee in the result instead of throwing.
+     * \param[in] injectee The object that will receive the key event injection.
+     * \param[in] data The data for the key event.
+     * \return    How the injection went.
+     */
+    InjectResult tryInjectKeyboardEvent(HandleID injectee, const KeyEventData& data) noexcept;
+
+    /**
+     * \brief     Injects a batch of key events, reporting a bad injectee in the result instead of throwing.
+     * \param[in] injectee The object that will receive the key event injections.
+     * \param[in] data The key events to send, in the order they should be received.
+     * \return    How the injection went.
+     */
+    InjectResult tryInjectKeyboardEvents(HandleID injectee, std::span<const KeyEventData> data) noexcept;
+
+    /**
+     * \brief     Injects a mouse event, reporting a bad injectee in the result instead of throwing.
+     * \param[in] injectee The object that will receive the mouse event injection.
+     * \param[in] data The mouse event data to send to the injectee event stream.
+     * \return    How the injection went.
+     */
+    InjectResult tryInjectMouseEvent(HandleID injectee, const MouseEventData& data) noexcept;
+
+    /**
+     * \brief     Injects a batch of mouse events, reporting a bad injectee in the result instead of throwing.
+     * \param[in] injectee The object that will receive the mouse event injections.
+     * \param[in] data The mouse events to send, in the order they should be received.
+     * \return    How the injection went.
+     */
+    InjectResult tryInjectMouseEvents(HandleID injectee, std::span<const MouseEventData> data) noexcept;
+
+    /**
+     * \brief     Moves the mouse relatively, reporting a bad injectee in the result instead of throwing.
+     * \param[in] injectee The object that will receive the motion.
+     * \param[in] data The motion.
+     * \return    How the injection went.
+     */
+    InjectResult tryInjectMouseMotion(HandleID injectee, const MouseMotionData& data) noexcept;
+
+    /**
+     * \brief     Moves the mouse relatively once per motion, reporting a bad injectee in the result instead of throwing.
+     * \param[in] injectee The object that will receive the motion.
+     * \param[in] data The motions to send, in the order they should be received.
+     * \return    How the injection went.
+     */
+    InjectResult tryInjectMouseMotions(HandleID injectee, std::span<const MouseMotionData> data) noexcept;
+
+    /**
+     * \brief     Types UTF-8 text, reporting a bad injectee in the result instead of throwing.
+     * \details   Text cut short at a character no key types reports `Partial`.
+     * \param[in] injectee The object that will receive the text.
+     * \param[in] text The text to type.
+     * \return    How the injection went, with `accepted` counting characters.
+     */
+    InjectResult tryInjectText(HandleID injectee, std::u8string_view text) noexcept;
+
+    /**
+     * \brief     Injects a batch of packed events of any kind into the event stream of the given injectee.
+     * \details   The batch stops at the first record that is not valid.
+     * \param[in] injectee The object that will receive the events.
+     * \param[in] data The events to send, in the order they should be received.
+     * \return    The number of records, counted from the front of `data`, that were accepted.
+     * \throws    std::runtime_error If the injectee is not a valid window object on a given platform.
+     */
+    std::size_t injectEvents(HandleID injectee, std::span<const InputEvent> data);
+
+    /**
+     * \brief     Injects a batch of packed events, reporting a bad injectee in the result instead of throwing.
+     * \param[in] injectee The object that will receive the events.
+     * \param[in] data The events to send, in the order they should be received.
+     * \return    How the injection went, with `accepted` counting records.
+     */
+    InjectResult tryInjectEvents(HandleID injectee, std::span<const InputEvent> data) noexcept;
+
+    /**
+     * \brief     Presses and releases whatever it takes for exactly the given keys and buttons to be held.
+     * \details   Every injection through the injector keeps track of what it left held, per
+     *            injectee. Only the differences from that are injected, releases first, as one batch
+     *            per kind. Buttons go down and up wherever the pointer is, without moving it, so
+     *            releasing what is stuck never moves the pointer.
+     * \param[in] injectee The object that will receive the events.
+     * \param[in] desired The keys and buttons that should be held afterwards.
+     * \return    The number of presses and releases accepted.
+     * \throws    std::runtime_error If the injectee is not a valid window object on a given platform.
+     */
+    std::size_t setInputState(HandleID injectee, const InputSet& desired);
+
+    /**
+     * \brief     Sets the held keys and buttons, reporting a bad injectee in the result instead of throwing.
+     * \param[in] injectee The object that will receive the events.
+     * \param[in] desired The keys and buttons that should be held afterwards.
+     * \return    How the injection went, with `accepted` counting presses and releases.
+     */
+    InjectResult trySetInputState(HandleID injectee, const InputSet& desired) noexcept;
+
+    /**
+     * \brief     Releases every key and button held down in the injectee.
+     * \param[in] injectee The object that will receive the events.
+     * \return    The number of releases accepted.
+     * \throws    std::runtime_error If the injectee is not a valid window object on a given platform.
+     */
+    std::size_t releaseAll(HandleID injectee);
+
+    /**
+     * \brief   Releases every key and button held down in any injectee, such as before shutting down.
+     * \details Injectees that are no longer valid are skipped and forgotten. Walks the injectees in
+     *          place, so it allocates nothing beyond what growing the translation buffers takes.
+     * \return  The number of releases accepted.
+     */
+    std::size_t releaseAll() noexcept;
+
+    /**
+     * \brief     Returns the keys and buttons the injector left held down in the injectee.
+     * \param[in] injectee The object to look up.
+     */
+    InputSet heldInputs(HandleID injectee) const;
+
+    /**
+     * \brief     Injects a sequence that was translated ahead of time.
+     * \details   The native records are submitted as they are, one call per run of the same kind.
+     *            The cursor of the injectee is left where the sequence left it.
+     * \param[in] injectee The object that will receive the events.
+     * \param[in] sequence The translated events.
+     * \return    The number of events, counted from the front of the sequence, that were accepted.
+     * \throws    std::runtime_error If the injectee is not a valid window object on a given platform.
+     */
+    std::size_t injectSequence(HandleID injectee, const CompiledSequence& sequence);
+
+    /**
+     * \brief     Injects a translated sequence, reporting a bad injectee in the result instead of throwing.
+     * \param[in] injectee The object that will receive the events.
+     * \param[in] sequence The translated events.
+     * \return    How the injection went, with `accepted` counting events.
+     */
+    InjectResult tryInjectSequence(HandleID injectee, const CompiledSequence& sequence) noexcept;
+
+    /**
+     * \brief     Sets whether consecutive pure moves in a mouse batch are collapsed to the newest.
+     * \details   A pure move has no button and no wheel steps. A run of them only sends its last
+     *            position, which cuts what reaches the OS when positions arrive faster than it can
+     *            take them. Other events are never dropped or reordered. Off by default.
+     * \param[in] enabled Whether to coalesce moves.
+     */
+    void setMoveCoalescing(bool enabled);
+
+    /**
+     * \brief   Returns the number of moves that were dropped because a newer move replaced them.
+     */
+    uint64_t coalescedMoves() const;
+
+    /**
+     * \brief     Sets what the positions of mouse events given to this injector are relative to.
+     * \details   Every injectee is checked again before its next injection, which reads its geometry
+     *            in the new space. Compiled sequences and broadcasts always use `CoordinateSpace::Screen`,
+     *            and recordings keep positions as given. The default is `CoordinateSpace::Screen`.
+     * \param[in] space The coordinate space.
+     */
+    void setCoordinateSpace(CoordinateSpace space);
+
+    /**
+     * \brief     Limits how many events per second each injectee of this injector is sent.
+     * \details   Every injectee has its own budget, refilled at `rate` and holding up to `burst`
+     *            events, which the injecting thread checks without locks. Batches are split into
+     *            pieces of at most `burst` events, and each piece waits until both its injectee and
+     *            the process, see `setGlobalPacing`, have room for it. Compiled sequences are paced
+     *            a whole run at a time. Recordings are never paced. No limit by default.
+     * \param[in] options The budget of each injectee.
+     */
+    void setPacing(const PacingOptions& options);
+
+    /**
+     * \brief   Returns how much pacing held this injector back.
+     */
+    PacingStatistics pacingStatistics() const;
+
+    /**
+     * \brief     Forgets the state kept for the injectee, such as after its window closed.
+     * \param[in] injectee The object whose state should be released.
+     */
+    void release(HandleID injectee);
+
+  private:
+    std::unique_ptr<detail::Context> context;
+  };
 }
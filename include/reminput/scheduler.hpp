@@ -0,0 +1,169 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/**
+ * \file
+ * \brief   Plays timestamped events, releasing each one at its deadline.
+ * \details Waiting is split in two: the thread sleeps on a precise OS timer until shortly before the
+ *          deadline, then spins for the rest. How long it spins is learned from how late the timer
+ *          wakes up, and never exceeds the spin budget, so CPU time can be traded against jitter.
+ */
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <reminput/macro.hpp>
+#include <reminput/profiling.hpp>
+#include <reminput/reminput.hpp>
+
+namespace simular::reminput {
+  /**
+   * \brief   A key event and when to release it.
+   */
+  struct TimedKeyEvent final {
+    /**
+     * \brief   When to release the event, counted from the start of playback.
+     */
+    std::chrono::nanoseconds at;
+
+    /**
+     * \brief   The event to release.
+     */
+    KeyEventData data;
+  };
+
+  /**
+   * \brief   A mouse event and when to release it.
+   */
+  struct TimedMouseEvent final {
+    /**
+     * \brief   When to release the event, counted from the start of playback.
+     */
+    std::chrono::nanoseconds at;
+
+    /**
+     * \brief   The event to release.
+     */
+    MouseEventData data;
+  };
+
+  /**
+   * \brief   Describes how a scheduler waits.
+   */
+  struct SchedulerOptions final {
+    /**
+     * \brief   The longest a scheduler spins before a deadline.
+     * \details Zero only sleeps, which costs no CPU time but leaves the jitter of the OS timer.
+     */
+    std::chrono::nanoseconds spinBudget = std::chrono::microseconds(200);
+  };
+
+  /**
+   * \brief   Releases timestamped events at their deadlines on the calling thread.
+   * \details Events are played in order. Those that are due together, because they share a deadline
+   *          or playback fell behind, are injected as one batch. A scheduler must only be used by one
+   *          thread at a time. On Linux, the timer slack of a thread is lowered to one nanosecond the
+   *          first time it sleeps here.
+   */
+  class Scheduler final {
+  public:
+    /**
+     * \brief     Creates a scheduler.
+     * \param[in] options How the scheduler waits.
+     */
+    explicit Scheduler(const SchedulerOptions& options = SchedulerOptions());
+
+    /**
+     * \brief     Sets the longest the scheduler spins before a deadline.
+     * \param[in] budget The spin budget, zero to only sleep.
+     */
+    void setSpinBudget(std::chrono::nanoseconds budget);
+
+    /**
+     * \brief   Returns the longest the scheduler spins before a deadline.
+     */
+    std::chrono::nanoseconds spinBudget() const;
+
+    /**
+     * \brief     Blocks until the deadline.
+     * \param[in] deadline When to return.
+     * \return    The time it returned at, which is never before the deadline.
+     */
+    std::chrono::steady_clock::time_point waitUntil(std::chrono::steady_clock::time_point deadline);
+
+    /**
+     * \brief     Measures how late the OS timer wakes up, so the first deadlines spin the right amount.
+     * \details   Otherwise the first few waits spin for the whole budget while this is learned.
+     * \param[in] samples The number of one millisecond sleeps to measure.
+     */
+    void calibrate(std::size_t samples = 16);
+
+    /**
+     * \brief     Plays key events, injecting each at its deadline.
+     * \param[in] injector The context to inject through.
+     * \param[in] injectee The object that will receive the events.
+     * \param[in] events The events, in order of their deadlines.
+     * \return    The number of events accepted, stopping at the first batch not fully accepted.
+     * \throws    std::runtime_error If the injectee is not a valid window object on a given platform.
+     */
+    std::size_t play(Injector& injector, HandleID injectee, std::span<const TimedKeyEvent> events);
+
+    /**
+     * \brief     Plays mouse events, injecting each at its deadline.
+     * \param[in] injector The context to inject through.
+     * \param[in] injectee The object that will receive the events.
+     * \param[in] events The events, in order of their deadlines.
+     * \return    The number of events accepted, stopping at the first batch not fully accepted.
+     * \throws    std::runtime_error If the injectee is not a valid window object on a given platform.
+     */
+    std::size_t play(Injector& injector, HandleID injectee, std::span<const TimedMouseEvent> events);
+
+    /**
+     * \brief     Plays a macro, honouring the delays between its records.
+     * \param[in] injector The context to inject through.
+     * \param[in] injectee The object that will receive the events.
+     * \param[in] records The records of the macro.
+     * \return    The number of events accepted, stopping at the first event not accepted.
+     * \throws    std::runtime_error If the injectee is not a valid window object on a given platform.
+     */
+    std::size_t play(Injector& injector, HandleID injectee, std::span<const MacroRecord> records);
+
+    /**
+     * \brief   Returns how late each played event was released, in nanoseconds.
+     */
+    const LatencyHistogram& lateness() const;
+
+    /**
+     * \brief   Clears the lateness histogram.
+     */
+    void resetLateness();
+
+  private:
+    // Records how late the OS timer woke up, in nanoseconds.
+    void learn(int64_t overshoot);
+
+    int64_t          budget;
+    int64_t          overshootMean      = 0;
+    int64_t          overshootDeviation = 0;
+    LatencyHistogram latenessHistogram;
+  };
+}
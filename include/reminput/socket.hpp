@@ -0,0 +1,182 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/**
+ * \file
+ * \brief   A local socket front-end, so processes that do not link the library can inject.
+ * \details Clients connect to a Unix domain stream socket and write frames. A frame is a
+ *          `FrameHeader` followed by `count` `InputEvent` records, all in little-endian byte order
+ *          and laid out exactly as in memory, so the server injects the records straight out of
+ *          its receive buffers as one batch per frame. Nothing is sent back. On Linux the server
+ *          receives through io_uring, with multishot accepts and multishot receives into a ring of
+ *          provided buffers, and falls back to epoll where io_uring is unavailable. Only available
+ *          on Linux.
+ */
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <reminput/reminput.hpp>
+
+namespace simular::reminput {
+  /**
+   * \brief   The most records a single frame may carry.
+   */
+  constexpr uint32_t kMaxFrameEvents = 4096;
+
+  /**
+   * \brief   Sits at the front of every frame.
+   */
+  struct FrameHeader final {
+    /**
+     * \brief   The number of `InputEvent` records following the header, at most `kMaxFrameEvents`.
+     */
+    uint32_t count = 0;
+
+    /**
+     * \brief   Reserved, must be zero.
+     */
+    uint32_t flags = 0;
+
+    /**
+     * \brief   The handle of the object that will receive the events.
+     */
+    uint64_t injectee = 0;
+  };
+  static_assert(sizeof(FrameHeader) == 16 && sizeof(FrameHeader) % sizeof(InputEvent) == 0);
+
+  /**
+   * \brief   Describes the socket a server listens on and how it receives.
+   */
+  struct SocketServerOptions final {
+    /**
+     * \brief   The path of the socket, or null for reminputd.sock in `$XDG_RUNTIME_DIR`, or
+     *          /tmp/reminputd-<uid>.sock where that is not set.
+     * \details A socket left by a server that is gone is replaced. The server is not valid if
+     *          another one still accepts connections on the path, or if it is not a socket.
+     */
+    const char* path = nullptr;
+
+    /**
+     * \brief   The most clients that can be connected at once. Further clients are disconnected.
+     */
+    std::size_t connections = 4096;
+
+    /**
+     * \brief   The size of each receive buffer.
+     */
+    std::size_t bufferSize = 16384;
+
+    /**
+     * \brief   The number of receive buffers shared by every connection, rounded up to a power of two.
+     */
+    std::size_t bufferCount = 256;
+
+    /**
+     * \brief   Whether to use epoll even where io_uring is available.
+     */
+    bool forceEpoll = false;
+  };
+
+  /**
+   * \brief   Counters describing what a socket server received.
+   */
+  struct SocketStatistics final {
+    /**
+     * \brief   Frames received whole and injected.
+     */
+    uint64_t frames;
+
+    /**
+     * \brief   Events the platform accepted.
+     */
+    uint64_t submitted;
+
+    /**
+     * \brief   Events that were received but not accepted, such as those for a closed window.
+     */
+    uint64_t failed;
+
+    /**
+     * \brief   Connections closed because they sent a malformed frame or there was no room for them.
+     */
+    uint64_t rejected;
+
+    /**
+     * \brief   Clients that connected, including those since gone.
+     */
+    uint64_t connections;
+  };
+
+  /**
+   * \brief   Listens on a Unix domain socket and injects the frames clients send.
+   * \details Every connection is served by the thread calling `run()`. A frame whose header or
+   *          records are malformed, such as a key outside of `InputKey`, closes its connection.
+   *          Frames are injected in the order each connection sent them. Receive buffers are
+   *          allocated up front; the only other memory is a buffer per connection for frames that
+   *          straddle two receives, kept for the life of the connection.
+   */
+  class SocketServer final {
+  public:
+    /**
+     * \brief     Binds and listens on the socket, and sets up io_uring or epoll.
+     * \param[in] options Describes the socket.
+     */
+    explicit SocketServer(const SocketServerOptions& options = {});
+
+    /**
+     * \brief   Closes every connection and removes the socket.
+     */
+    ~SocketServer();
+
+    SocketServer(const SocketServer&) = delete;
+    SocketServer& operator=(const SocketServer&) = delete;
+
+    /**
+     * \brief   Checks whether the server is listening.
+     */
+    bool valid() const;
+
+    /**
+     * \brief   Checks whether the server receives through io_uring rather than epoll.
+     */
+    bool usingIoUring() const;
+
+    /**
+     * \brief   Serves connections until `stop()` is called.
+     */
+    void run();
+
+    /**
+     * \brief   Makes `run()` return. Safe from any thread and from a signal handler.
+     */
+    void stop();
+
+    /**
+     * \brief   Returns the counters of this server.
+     */
+    SocketStatistics statistics() const;
+
+  private:
+    struct Loop;
+    std::unique_ptr<Loop> loop;
+  };
+}
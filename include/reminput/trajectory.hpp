@@ -0,0 +1,115 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/**
+ * \file
+ * \brief   Generates human-like mouse paths as ready-to-play batches of moves.
+ */
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <reminput/scheduler.hpp>
+
+namespace simular::reminput {
+  /**
+   * \brief   The shape of a generated path.
+   * \details Every model eases in and out along a minimum-jerk profile, the bell-shaped speed of a
+   *          hand reaching for a target; they differ in the path the cursor follows.
+   */
+  enum class TrajectoryModel : uint8_t {
+    MinimumJerk, /**< A straight line. */
+    Bezier,      /**< A cubic Bezier curve bowing to one side of the line. */
+    Noisy,       /**< A straight line with a smooth wobble that dies out at both ends. */
+  };
+
+  /**
+   * \brief   Describes a path to generate.
+   */
+  struct TrajectoryOptions final {
+    /**
+     * \brief   Where the path starts on the x-axis, in screen space.
+     */
+    int32_t startX = 0;
+
+    /**
+     * \brief   Where the path starts on the y-axis, in screen space.
+     */
+    int32_t startY = 0;
+
+    /**
+     * \brief   Where the path ends on the x-axis, in screen space.
+     */
+    int32_t endX = 0;
+
+    /**
+     * \brief   Where the path ends on the y-axis, in screen space.
+     */
+    int32_t endY = 0;
+
+    /**
+     * \brief   How long the movement takes.
+     */
+    std::chrono::nanoseconds duration = std::chrono::milliseconds(250);
+
+    /**
+     * \brief   The time between two moves, such as the polling rate of a mouse.
+     */
+    std::chrono::nanoseconds interval = std::chrono::milliseconds(1);
+
+    /**
+     * \brief   The shape of the path.
+     */
+    TrajectoryModel model = TrajectoryModel::MinimumJerk;
+
+    /**
+     * \brief   How far a Bezier path bows, as a fraction of the distance, negative for the other side.
+     */
+    float curvature = 0.2f;
+
+    /**
+     * \brief   The largest wobble of a noisy path, in pixels.
+     */
+    float noise = 3.0f;
+
+    /**
+     * \brief   Picks the wobble of a noisy path, so the same seed always gives the same path.
+     */
+    uint64_t seed = 0;
+  };
+
+  /**
+   * \brief     Returns the number of moves a path is made of.
+   * \param[in] options The path.
+   */
+  std::size_t trajectoryLength(const TrajectoryOptions& options);
+
+  /**
+   * \brief     Generates a path into a caller-provided buffer, allocating nothing.
+   * \details   The moves are timed from the start of the movement, so they can be handed straight to
+   *            `Scheduler::play`. The first move is at the start and the last at the end, exactly.
+   * \param[in] options The path.
+   * \param[in] events Where to write the moves.
+   * \return    The number of moves written, or zero if `events` is shorter than `trajectoryLength`.
+   */
+  std::size_t generateTrajectory(const TrajectoryOptions& options, std::span<TimedMouseEvent> events);
+}
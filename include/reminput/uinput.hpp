@@ -0,0 +1,86 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/**
+ * \file
+ * \brief   Controls for the Linux uinput backend.
+ * \details On Linux the library injects through a single virtual keyboard and mouse created with
+ *          uinput. Since that device is shared by every window on the seat, the `HandleID` given to
+ *          the inject functions only names the session injecting and must not be null.
+ */
+#pragma once
+#include <cstdint>
+
+namespace simular::reminput {
+  /**
+   * \brief   Describes how the virtual device should be created.
+   * \details These are only read when the device is opened, which happens lazily on the first
+   *          injection after the library starts or after the device is closed. The strings are
+   *          copied when the options are configured, so they need not outlive the call.
+   */
+  struct UInputOptions final {
+    /**
+     * \brief   The path of the uinput character device.
+     */
+    const char* path = "/dev/uinput";
+
+    /**
+     * \brief   The name the virtual device reports to the system.
+     */
+    const char* name = "RemoteInput Virtual Device";
+
+    /**
+     * \brief   The width of the screen space the absolute x-axis spans.
+     * \details Mouse positions are sent in screen space, so this should match the desktop size.
+     */
+    int32_t width = 1920;
+
+    /**
+     * \brief   The height of the screen space the absolute y-axis spans.
+     * \details Mouse positions are sent in screen space, so this should match the desktop size.
+     */
+    int32_t height = 1080;
+  };
+
+  /**
+   * \brief     Sets how the virtual device is created, closing the current device if one is open.
+   * \details   Safe to call while other threads inject. The current device is only closed once
+   *            writes already in flight to it finish; injections that follow open the new one.
+   * \param[in] options The options to create the device with on the next injection.
+   */
+  void configureUInputDevice(const UInputOptions& options);
+
+  /**
+   * \brief     Uses an already set up descriptor as the virtual device instead of opening one.
+   * \details   Ownership of the descriptor passes to the library. Any descriptor that accepts
+   *            `write()` works, such as one end of a pipe, which allows testing without uinput.
+   *            Any previous device is closed once writes already in flight to it finish.
+   * \param[in] descriptor The descriptor to write input events to.
+   */
+  void attachUInputDevice(int descriptor);
+
+  /**
+   * \brief   Destroys the virtual device, if one is open.
+   * \details The next injection opens a new device. Writes already in flight finish first, so
+   *          this may wait for them.
+   */
+  void closeUInputDevice();
+}
@@ -0,0 +1,55 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/**
+ * \file
+ * \brief   Controls for the X11 backend.
+ * \details When built with `BUILD_X11`, the library injects through the XTest extension of a single
+ *          X connection and every `HandleID` is an X `Window` on that display.
+ */
+#pragma once
+
+namespace simular::reminput {
+  /**
+   * \brief   Describes which X server to inject into.
+   * \details These are only read when the connection is opened, which happens lazily on the first
+   *          injection after the library starts or after the connection is closed.
+   */
+  struct X11Options final {
+    /**
+     * \brief   The name of the display to connect to.
+     * \details When null, the `DISPLAY` environment variable is used.
+     */
+    const char* display = nullptr;
+  };
+
+  /**
+   * \brief     Sets which display to inject into, closing the current connection if one is open.
+   * \param[in] options The options to connect with on the next injection.
+   */
+  void configureX11Connection(const X11Options& options);
+
+  /**
+   * \brief   Closes the connection to the X server, if one is open.
+   * \details The next injection opens a new connection.
+   */
+  void closeX11Connection();
+}
@@ -0,0 +1,147 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/**
+ * \file
+ * \brief   Describes the functions each platform backend provides to the platform agnostic front.
+ * \details Exactly one backend is compiled into the library, selected by the platform macros in
+ *          `config.hpp`, so these are plain functions rather than an interface.
+ */
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <span>
+#include <reminput/reminput.hpp>
+#include "coordinates.hpp"
+
+namespace simular::reminput::detail {
+  /**
+   * \brief   The message of the error thrown when an injectee fails validation.
+   * \details Each backend describes what kind of handle it expected.
+   */
+  extern const char* const kInvalidInjecteeMessage;
+
+  /**
+   * \brief     Checks whether the injectee is a handle the backend can deliver events to.
+   * \param[in] injectee The handle to check.
+   * \return    True if events can be submitted for the injectee.
+   */
+  bool validateInjectee(HandleID injectee);
+
+  /**
+   * \brief      Works out how positions in a coordinate space map onto what the backend sends.
+   * \details    Called whenever the injectee is validated, so the result is cached alongside.
+   * \param[in]  injectee The handle positions are relative to, or null for the desktop itself.
+   * \param[in]  space What the positions are relative to.
+   * \param[out] transform The mapping.
+   * \return     False if the geometry of the injectee could not be read.
+   */
+  bool queryTransform(HandleID injectee, CoordinateSpace space, Transform& transform);
+
+  /**
+   * \brief   The last cursor position sent to an injectee.
+   * \details Backends use this to skip moves to where the cursor already is. Positions are those
+   *          the backend was given, after any transform was applied.
+   */
+  struct Cursor final {
+    int32_t x = std::numeric_limits<int32_t>::min();
+    int32_t y = std::numeric_limits<int32_t>::min();
+  };
+
+  /**
+   * \brief   Buffers a backend translates batches into, defined by each backend.
+   * \details Each context owns one, so translation never shares memory between threads.
+   */
+  struct Scratch;
+
+  /**
+   * \brief   Destroys scratch buffers made by `createScratch()`.
+   */
+  struct ScratchDeleter final {
+    void operator()(Scratch* scratch) const;
+  };
+
+  /**
+   * \brief   Creates empty scratch buffers for a new context.
+   */
+  std::unique_ptr<Scratch, ScratchDeleter> createScratch();
+
+  /**
+   * \brief         Translates a batch of key events into the buffers of the calling context.
+   * \param[in,out] scratch The buffers to translate into, replacing what they held.
+   * \param[in]     data The key events to translate, in order.
+   */
+  void translateKeyboardEvents(Scratch& scratch, std::span<const KeyEventData> data);
+
+  /**
+   * \brief         Translates a batch of mouse events into the buffers of the calling context.
+   * \param[in,out] scratch The buffers to translate into, replacing what they held.
+   * \param[in,out] cursor The last position sent, used to skip moves to where the cursor already is.
+   * \param[in]     data The mouse events to translate, in order.
+   */
+  void translateMouseEvents(Scratch& scratch, Cursor& cursor, std::span<const MouseEventData> data);
+
+  /**
+   * \brief         Translates a batch of relative motions into the buffers of the calling context.
+   * \param[in,out] scratch The buffers to translate into, replacing what they held.
+   * \param[in]     data The motions to translate, in order, with deltas already rounded to whole pixels.
+   */
+  void translateMotionEvents(Scratch& scratch, std::span<const MouseMotionData> data);
+
+  /**
+   * \brief   One step of typing text, either a key event or a character typed natively.
+   */
+  struct TextStroke final {
+    /**
+     * \brief   The key event, used when `unicode` is zero.
+     */
+    KeyEventData key;
+
+    /**
+     * \brief   A code point the platform types by itself, or zero.
+     */
+    char32_t unicode = 0;
+  };
+
+  /**
+   * \brief   Whether the backend can type characters that have no key, through `TextStroke::unicode`.
+   */
+  extern const bool kUnicodeText;
+
+  /**
+   * \brief         Translates the strokes typing a text into the buffers of the calling context.
+   * \details       Strokes with a code point are only passed to backends with `kUnicodeText`.
+   * \param[in,out] scratch The buffers to translate into, replacing what they held.
+   * \param[in]     data The strokes to translate, in order.
+   */
+  void translateTextEvents(Scratch& scratch, std::span<const TextStroke> data);
+
+  /**
+   * \brief     Submits the last batch translated into the buffers to an already validated injectee.
+   * \details   The buffers are only read, so several threads may submit the same translation at once.
+   * \param[in] scratch The buffers holding the translated batch.
+   * \param[in] injectee The object that will receive the events.
+   * \return    The number of events, counted from the front of the batch, that the platform accepted.
+   */
+  std::size_t submitTranslated(const Scratch& scratch, HandleID injectee);
+}
@@ -0,0 +1,209 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <reminput/broadcast.hpp>
+#include "backend.hpp"
+#include "config.hpp"
+#include "context.hpp"
+#include "pacing.hpp"
+#include "profiling.hpp"
+#include "recording.hpp"
+
+namespace simular::reminput {
+  // The workers and the caller claim targets from a shared counter, so a slow injectee only holds
+  // up the thread serving it. Each broadcast is a generation: the caller publishes the batch, bumps
+  // the generation, serves targets itself, then waits for every worker to report back before the
+  // batch, which it still owns, can go out of scope.
+  struct Broadcaster::Pool {
+    // Validates and submits to one target.
+    void serve(std::size_t index) {
+      auto& target = targets[index];
+      auto& state  = states[index];
+      auto start   = std::chrono::steady_clock::now();
+      {
+        REMINPUT_PROFILE_STAGE(Validate);
+        target.valid = detail::checkInjectee(state, target.injectee);
+      }
+
+      target.accepted = 0;
+      if (target.valid) {
+        if (recorder && mouse) {
+          target.accepted = detail::recordMouseEvents(*recorder, target.injectee, mouseEvents);
+        } else if (recorder) {
+          target.accepted = detail::recordKeyboardEvents(*recorder, target.injectee, keyboardEvents);
+        } else {
+          // Broadcasts have no budget per injectee, but still count against the one of the process.
+          detail::paceGlobally(size);
+          target.accepted = detail::submitTranslated(*scratch, target.injectee);
+        }
+
+        // Anything short of the whole batch may mean the injectee is gone, so check it next time.
+        if (target.accepted < size)
+          detail::staleInjectee(state);
+        if (mouse)
+          detail::trackMouseEvents(state, mouseEvents.first(target.accepted));
+        else
+          detail::trackKeyboardEvents(state, keyboardEvents.first(target.accepted));
+      }
+
+      REMINPUT_PROFILE_COUNT(size, target.accepted);
+      target.elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    }
+
+    // Serves targets until none are left unclaimed.
+    void drain() {
+      for (auto index = next.fetch_add(1, std::memory_order_relaxed); index < targets.size();
+           index = next.fetch_add(1, std::memory_order_relaxed))
+        serve(index);
+    }
+
+    // A worker thread, which helps with every generation until stopped.
+    void work() {
+      auto seen = uint64_t{0};
+      while (true) {
+        generation.wait(seen, std::memory_order_acquire);
+        seen = generation.load(std::memory_order_acquire);
+        if (stopping.load(std::memory_order_relaxed))
+          return;
+
+        drain();
+        if (pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+          pending.notify_one();
+      }
+    }
+
+    // Serves every target of the translated batch and fills in the timing.
+    void fanout(std::span<BroadcastTarget> batchTargets, std::size_t batchSize, BroadcastTiming& timing) {
+      // Workers get a private copy of each cached validation, so none of them touches the map.
+      targets = batchTargets;
+      size    = batchSize;
+      states.resize(targets.size());
+      for (std::size_t index = 0; index < targets.size(); index++)
+        states[index] = injectees[targets[index].injectee];
+
+      auto start = std::chrono::steady_clock::now();
+      next.store(0, std::memory_order_relaxed);
+      pending.store(workers.size(), std::memory_order_relaxed);
+      generation.fetch_add(1, std::memory_order_release);
+      generation.notify_all();
+      drain();
+      for (auto left = pending.load(std::memory_order_acquire); left; left = pending.load(std::memory_order_acquire))
+        pending.wait(left, std::memory_order_acquire);
+      timing.fanout = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+
+      for (std::size_t index = 0; index < targets.size(); index++) {
+        timing.slowest = std::max(timing.slowest, targets[index].elapsed);
+        if (targets[index].valid)
+          injectees[targets[index].injectee] = states[index];
+        else
+          injectees.erase(targets[index].injectee);
+      }
+    }
+
+    // The translation every target is sent, and the batch it came from for recording instead.
+    std::unique_ptr<detail::Scratch, detail::ScratchDeleter> scratch = detail::createScratch();
+    std::span<const KeyEventData>   keyboardEvents;
+    std::span<const MouseEventData> mouseEvents;
+    std::vector<MouseEventData>     mapped;
+    bool                            mouse    = false;
+    detail::Recorder*               recorder = nullptr;
+
+    // The targets of the current generation, and the cached validation of each.
+    std::span<BroadcastTarget>                          targets;
+    std::size_t                                         size = 0;
+    std::vector<detail::InjecteeState>                  states;
+    std::unordered_map<HandleID, detail::InjecteeState> injectees;
+
+    // Claimed by every thread for each target, so kept apart from what is only read.
+    alignas(SIMULAR_PROCESSOR_CACHE_LINE_SIZE) std::atomic<std::size_t> next{0};
+    alignas(SIMULAR_PROCESSOR_CACHE_LINE_SIZE) std::atomic<uint64_t>    generation{0};
+    std::atomic<std::size_t> pending{0};
+    std::atomic<bool>        stopping{false};
+    std::vector<std::thread> workers;
+  };
+
+  Broadcaster::Broadcaster(std::size_t workers) : pool(std::make_unique<Pool>()) {
+    pool->workers.reserve(workers);
+    for (std::size_t index = 0; index < workers; index++)
+      pool->workers.emplace_back([this] { pool->work(); });
+  }
+
+  Broadcaster::~Broadcaster() {
+    pool->stopping.store(true, std::memory_order_relaxed);
+    pool->generation.fetch_add(1, std::memory_order_release);
+    pool->generation.notify_all();
+    for (auto& worker : pool->workers)
+      worker.join();
+  }
+
+  std::size_t Broadcaster::defaultWorkers() {
+    auto threads = std::thread::hardware_concurrency();
+    return threads > 1 ? threads - 1 : 0;
+  }
+
+  BroadcastTiming Broadcaster::broadcast(std::span<BroadcastTarget> targets, std::span<const KeyEventData> data) {
+    BroadcastTiming timing;
+    auto start = std::chrono::steady_clock::now();
+
+    // Recordings keep the events themselves, so there is nothing to translate.
+    pool->recorder       = detail::activeRecorder();
+    pool->keyboardEvents = data;
+    pool->mouse          = false;
+    if (!pool->recorder)
+      detail::translateKeyboardEvents(*pool->scratch, data);
+    timing.translation = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+
+    pool->fanout(targets, data.size(), timing);
+    return timing;
+  }
+
+  BroadcastTiming Broadcaster::broadcast(std::span<BroadcastTarget> targets, std::span<const MouseEventData> data) {
+    BroadcastTiming timing;
+    auto start = std::chrono::steady_clock::now();
+
+    // Recordings keep the events themselves, so there is nothing to translate. Otherwise every
+    // target starts from an unknown cursor, since each may have been sent elsewhere in between. One
+    // translation goes to every target, so positions are always in screen space.
+    pool->recorder    = detail::activeRecorder();
+    pool->mouseEvents = data;
+    pool->mouse       = true;
+    if (!pool->recorder) {
+      detail::Cursor    cursor;
+      detail::Transform transform;
+      detail::queryTransform(nullptr, CoordinateSpace::Screen, transform);
+      detail::translateMouseEvents(*pool->scratch, cursor, detail::mapPositions(transform, data, pool->mapped));
+    }
+    timing.translation = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+
+    pool->fanout(targets, data.size(), timing);
+    return timing;
+  }
+
+  void Broadcaster::release(HandleID injectee) {
+    pool->injectees.erase(injectee);
+  }
+}
@@ -0,0 +1,74 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <vector>
+#include <reminput/compiled.hpp>
+#include "backend.hpp"
+#include "compiled.hpp"
+#include "context.hpp"
+
+namespace simular::reminput {
+  CompiledSequence::CompiledSequence(std::span<const InputEvent> events) : runs(std::make_unique<Runs>()) {
+    // The cursor is carried from one mouse run to the next, as it would be by an injector.
+    // Positions are mapped from screen space with the desktop as it is now.
+    detail::Transform           transform;
+    std::vector<MouseEventData> mapped;
+    detail::queryTransform(nullptr, CoordinateSpace::Screen, transform);
+    // Translation stops at the first record that is not valid, as injecting the events would.
+    for (std::size_t begin = 0; begin < events.size();) {
+      auto kind = events[begin].kind;
+      if (!detail::validEvent(events[begin]))
+        break;
+      if (kind == InputEvent::Kind::Wait) {
+        begin++;
+        continue;
+      }
+
+      auto& run = runs->list.emplace_back();
+      auto  end = begin;
+      for (; end < events.size(); end++) {
+        if (events[end].kind == InputEvent::Kind::Wait)
+          continue;
+        if (events[end].kind != kind || !detail::validEvent(events[end]))
+          break;
+        if (kind == InputEvent::Kind::Keyboard)
+          run.keys.push_back(events[end].keyboard());
+        else
+          run.mice.push_back(events[end].mouse());
+      }
+
+      if (kind == InputEvent::Kind::Keyboard)
+        detail::translateKeyboardEvents(*run.scratch, run.keys);
+      else
+        detail::translateMouseEvents(*run.scratch, runs->cursor, detail::mapPositions(transform, run.mice, mapped));
+      runs->size += run.keys.size() + run.mice.size();
+      begin = end;
+    }
+  }
+
+  CompiledSequence::~CompiledSequence() = default;
+  CompiledSequence::CompiledSequence(CompiledSequence&&) noexcept = default;
+  CompiledSequence& CompiledSequence::operator=(CompiledSequence&&) noexcept = default;
+
+  std::size_t CompiledSequence::size() const noexcept {
+    return runs->size;
+  }
+}
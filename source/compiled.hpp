@@ -0,0 +1,73 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/**
+ * \file
+ * \brief   What a compiled sequence holds, shared by the injector that submits it.
+ */
+#pragma once
+#include <cstddef>
+#include <vector>
+#include <reminput/compiled.hpp>
+#include "backend.hpp"
+
+namespace simular::reminput {
+  /**
+   * \brief   The translated runs of a compiled sequence.
+   */
+  struct CompiledSequence::Runs final {
+    /**
+     * \brief   Consecutive events of one kind, and their native records.
+     */
+    struct Run final {
+      /**
+       * \brief   The native records of the run, ready to submit.
+       */
+      std::unique_ptr<detail::Scratch, detail::ScratchDeleter> scratch = detail::createScratch();
+
+      /**
+       * \brief   The key events of the run, empty for a run of mouse events.
+       * \details Kept for recordings and for tracking what is held.
+       */
+      std::vector<KeyEventData> keys;
+
+      /**
+       * \brief   The mouse events of the run, empty for a run of key events.
+       */
+      std::vector<MouseEventData> mice;
+    };
+
+    /**
+     * \brief   The runs, in order.
+     */
+    std::vector<Run> list;
+
+    /**
+     * \brief   The number of events in every run together.
+     */
+    std::size_t size = 0;
+
+    /**
+     * \brief   Where the sequence leaves the cursor.
+     */
+    detail::Cursor cursor;
+  };
+}
@@ -0,0 +1,366 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <reminput/reminput.hpp>
+#include "backend.hpp"
+#include "context.hpp"
+#include "pacing.hpp"
+#include "recording.hpp"
+
+namespace simular::reminput::detail {
+  // Bumped to make every cached validation stale at once. Never zero, which means never validated.
+  static std::atomic<uint64_t> validationGeneration{1};
+
+  // Injectees invalidated one by one are stamped into a bucket picked by their handle, so a check only
+  // has to look at its own bucket, and only once anything was invalidated since it last passed. Two
+  // handles sharing a bucket at worst make the other one check again too.
+  constexpr std::size_t kInvalidationBuckets = 256;
+  static std::atomic<uint64_t>                                   invalidationCount{0};
+  static std::array<std::atomic<uint64_t>, kInvalidationBuckets> invalidationStamps{};
+
+  // Picks the bucket of a handle, mixing the bits since handles are often aligned pointers.
+  static std::atomic<uint64_t>& invalidationStamp(HandleID injectee) {
+    auto bits = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(injectee)) * 0x9E3779B97F4A7C15ull;
+    return invalidationStamps[bits >> 56];
+  }
+
+  // How long a validation is trusted for, in nanoseconds.
+  static std::atomic<int64_t> validationInterval{
+    std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::milliseconds(100)).count()
+  };
+
+  bool checkInjectee(InjecteeState& state, HandleID injectee) {
+    auto generation    = validationGeneration.load(std::memory_order_acquire);
+    auto invalidations = invalidationCount.load(std::memory_order_acquire);
+    auto now           = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()
+    ).count();
+
+    // Recorded injections never reach a window, so there is nothing to look up.
+    if (activeRecorder())
+      return injectee != nullptr;
+
+    // Trust the cached result while it is fresh and the injectee was not invalidated since.
+    if (state.generation == generation &&
+        now - state.validatedAt < validationInterval.load(std::memory_order_relaxed) &&
+        (invalidations == state.invalidations ||
+         invalidationStamp(injectee).load(std::memory_order_acquire) <= state.invalidations))
+      return true;
+
+    // The geometry is read along with the check, so it is never older than the validation.
+    if (!validateInjectee(injectee) || !queryTransform(injectee, state.space, state.transform)) {
+      staleInjectee(state);
+      return false;
+    }
+
+    state.generation    = generation;
+    state.validatedAt   = now;
+    state.invalidations = invalidations;
+    return true;
+  }
+
+  void staleInjectees() {
+    validationGeneration.fetch_add(1, std::memory_order_acq_rel);
+  }
+
+  bool makeInjecteeRoom(Context& context) {
+    if (context.injectees.size() < kMaxInjectees)
+      return true;
+
+    std::erase_if(context.injectees, [](const auto& entry) {
+      return entry.second.held.empty();
+    });
+    return context.injectees.size() < kMaxInjectees;
+  }
+
+  void trackKeyboardEvents(InjecteeState& state, std::span<const KeyEventData> data) {
+    for (const auto& event : data)
+      state.held.set(event.key, event.state == InputState::Press);
+  }
+
+  void trackMouseEvents(InjecteeState& state, std::span<const MouseEventData> data) {
+    for (const auto& event : data)
+      state.held.set(event.button, event.state == InputState::Press);
+  }
+
+  // Hands a batch to the backend, in pieces no larger than a burst while pacing is on, each waiting
+  // until it fits the budgets.
+  template <typename Event, typename Submit>
+  static std::size_t submitPaced(Context& context, InjecteeState& state, std::span<const Event> data, Submit submit) {
+    if (!pacingEnabled(context))
+      return submit(data);
+
+    auto piece    = pacingPiece(context);
+    auto accepted = std::size_t{0};
+    while (accepted < data.size()) {
+      auto part = data.subspan(accepted, std::min(piece, data.size() - accepted));
+      pace(context, state, part.size());
+      auto sent = submit(part);
+      accepted += sent;
+      if (sent < part.size())
+        break;
+    }
+
+    return accepted;
+  }
+
+  std::size_t dispatchKeyboardEvents(Context& context, InjecteeState& state, HandleID injectee, std::span<const KeyEventData> data) {
+    auto accepted = std::size_t{0};
+    if (auto* recorder = activeRecorder()) {
+      accepted = recordKeyboardEvents(*recorder, injectee, data);
+    } else {
+      // Anything short of the whole batch may mean the injectee is gone, so check it next time.
+      accepted = submitPaced(context, state, data, [&](std::span<const KeyEventData> part) {
+        translateKeyboardEvents(*context.scratch, part);
+        return submitTranslated(*context.scratch, injectee);
+      });
+      if (accepted < data.size())
+        staleInjectee(state);
+    }
+
+    trackKeyboardEvents(state, data.first(accepted));
+    return accepted;
+  }
+
+  // Submits mouse events exactly as given.
+  static std::size_t submitMouseRun(Context& context, InjecteeState& state, HandleID injectee, std::span<const MouseEventData> data) {
+    auto accepted = std::size_t{0};
+    if (auto* recorder = activeRecorder()) {
+      accepted = recordMouseEvents(*recorder, injectee, data);
+    } else {
+      // Anything short of the whole batch may mean the injectee is gone, so check it next time.
+      accepted = submitPaced(context, state, data, [&](std::span<const MouseEventData> part) {
+        translateMouseEvents(*context.scratch, state.cursor, mapPositions(state.transform, part, context.mapped));
+        return submitTranslated(*context.scratch, injectee);
+      });
+      if (accepted < data.size())
+        staleInjectee(state);
+    }
+
+    trackMouseEvents(state, data.first(accepted));
+    return accepted;
+  }
+
+  // Checks whether an event only moves the cursor, so a later move makes it pointless.
+  static bool isPureMove(const MouseEventData& event) {
+    return event.button == MouseButton::Undefined && event.scrolldy == 0;
+  }
+
+  std::size_t dispatchMouseEvents(Context& context, InjecteeState& state, HandleID injectee, std::span<const MouseEventData> data) {
+    // Pacing set to coalesce collapses moves only when the batch would otherwise wait.
+    auto throttled = context.pacing.policy == PacingPolicy::Coalesce && !activeRecorder() &&
+                     pacingEnabled(context) && pacingWouldWait(context, state, data.size());
+    if (!context.coalesceMoves && !throttled)
+      return submitMouseRun(context, state, injectee, data);
+
+    // Keep only the newest of each run of pure moves. Buttons and wheel steps break a run, so
+    // nothing is reordered around them.
+    context.moves.clear();
+    context.moveEnds.clear();
+    for (std::size_t index = 0; index < data.size(); index++) {
+      if (isPureMove(data[index]) && !context.moves.empty() && isPureMove(context.moves.back())) {
+        context.moves.back()    = data[index];
+        context.moveEnds.back() = index + 1;
+      } else {
+        context.moves.push_back(data[index]);
+        context.moveEnds.push_back(index + 1);
+      }
+    }
+
+    auto kept     = submitMouseRun(context, state, injectee, context.moves);
+    auto accepted = kept ? context.moveEnds[kept - 1] : 0;
+    context.coalescedMoves += accepted - kept;
+    if (throttled)
+      context.pacingStatistics.coalesced += accepted - kept;
+    return accepted;
+  }
+
+  // Rounds a fixed point delta plus what was left over to whole pixels, keeping the new remainder.
+  static int32_t roundSubpixels(int32_t delta, int32_t& remainder) {
+    auto total = int64_t{delta} + remainder;
+    auto whole = (total + kSubpixelScale / 2) >> kSubpixelBits;
+    remainder  = static_cast<int32_t>(total - whole * kSubpixelScale);
+    return static_cast<int32_t>(whole);
+  }
+
+  // Checks whether a motion only moves the cursor, so it can be summed with its neighbours.
+  static bool isPureMotion(const MouseMotionData& event) {
+    return event.button == MouseButton::Undefined && event.scrolldy == 0;
+  }
+
+  std::size_t dispatchMotionEvents(Context& context, InjecteeState& state, HandleID injectee, std::span<const MouseMotionData> data) {
+    // Pacing set to coalesce sums motions only when the batch would otherwise wait.
+    auto throttled = context.pacing.policy == PacingPolicy::Coalesce && !activeRecorder() &&
+                     pacingEnabled(context) && pacingWouldWait(context, state, data.size());
+    auto merge     = context.coalesceMoves || throttled;
+
+    // Round to whole pixels. A motion left with nothing to do is folded into the next one sent, and
+    // runs of pure motions are summed when merging. Buttons and wheel steps break a run.
+    auto remainderX = state.subpixelX;
+    auto remainderY = state.subpixelY;
+    context.motions.clear();
+    context.motionEnds.clear();
+    for (std::size_t index = 0; index < data.size(); index++) {
+      auto motion    = data[index];
+           motion.dx = roundSubpixels(motion.dx, remainderX);
+           motion.dy = roundSubpixels(motion.dy, remainderY);
+      if (isPureMotion(motion) && motion.dx == 0 && motion.dy == 0)
+        continue;
+
+      if (merge && isPureMotion(motion) && !context.motions.empty() && isPureMotion(context.motions.back())) {
+        context.motions.back().dx += motion.dx;
+        context.motions.back().dy += motion.dy;
+        context.motionEnds.back()  = index + 1;
+      } else {
+        context.motions.push_back(motion);
+        context.motionEnds.push_back(index + 1);
+      }
+    }
+
+    auto sent = std::size_t{0};
+    if (auto* recorder = activeRecorder()) {
+      sent = recordMotionEvents(*recorder, injectee, context.motions);
+    } else {
+      // Anything short of the whole batch may mean the injectee is gone, so check it next time.
+      sent = submitPaced(context, state, std::span<const MouseMotionData>(context.motions), [&](std::span<const MouseMotionData> part) {
+        translateMotionEvents(*context.scratch, part);
+        return submitTranslated(*context.scratch, injectee);
+      });
+      if (sent < context.motions.size())
+        staleInjectee(state);
+    }
+
+    // Motions folded away after the last one sent still count, their remainders carried over.
+    auto accepted = sent == context.motions.size() ? data.size() : (sent ? context.motionEnds[sent - 1] : 0);
+    if (accepted < data.size()) {
+      remainderX = state.subpixelX;
+      remainderY = state.subpixelY;
+      for (const auto& motion : data.first(accepted)) {
+        roundSubpixels(motion.dx, remainderX);
+        roundSubpixels(motion.dy, remainderY);
+      }
+    }
+    state.subpixelX = remainderX;
+    state.subpixelY = remainderY;
+
+    // The cursor is somewhere else now, so the next absolute move has to be sent even if repeated.
+    for (const auto& motion : std::span(context.motions).first(sent)) {
+      if (motion.dx || motion.dy) {
+        state.cursor = Cursor{};
+        break;
+      }
+    }
+    for (const auto& motion : data.first(accepted))
+      state.held.set(motion.button, motion.state == InputState::Press);
+
+    if (merge) {
+      auto folded = accepted - sent;
+      context.coalescedMoves += folded;
+      if (throttled)
+        context.pacingStatistics.coalesced += folded;
+    }
+    return accepted;
+  }
+
+  std::size_t dispatchInputState(Context& context, InjecteeState& state, HandleID injectee, const InputSet& desired, std::size_t& count) {
+    // The bits that differ are found a word at a time, then walked lowest first.
+    auto held = state.held;
+    count     = static_cast<std::size_t>(std::popcount(held.buttons ^ desired.buttons));
+    for (std::size_t word = 0; word < InputSet::kKeyWords; word++)
+      count += static_cast<std::size_t>(std::popcount(held.keys[word] ^ desired.keys[word]));
+
+    // Releases go first, so trading one modifier for another never holds both.
+    auto accepted = std::size_t{0};
+    for (auto change : { InputState::Release, InputState::Press }) {
+      const auto& side = change == InputState::Press ? desired : held;
+      context.keys.clear();
+      for (std::size_t word = 0; word < InputSet::kKeyWords; word++) {
+        for (auto bits = (held.keys[word] ^ desired.keys[word]) & side.keys[word]; bits; bits &= bits - 1) {
+          auto key = static_cast<InputKey>(word * 64 + static_cast<std::size_t>(std::countr_zero(bits)));
+          context.keys.push_back(KeyEventData { .key = key, .state = change });
+        }
+      }
+
+      context.buttons.clear();
+      for (auto bits = (held.buttons ^ desired.buttons) & side.buttons; bits; bits &= bits - 1) {
+        context.buttons.push_back(MouseMotionData {
+          .dx       = 0,
+          .dy       = 0,
+          .scrolldy = 0,
+          .button   = static_cast<MouseButton>(std::countr_zero(bits)),
+          .state    = change,
+        });
+      }
+
+      auto sent = dispatchKeyboardEvents(context, state, injectee, context.keys);
+      if (sent == context.keys.size())
+        sent += dispatchMotionEvents(context, state, injectee, context.buttons);
+      accepted += sent;
+      if (sent < context.keys.size() + context.buttons.size())
+        break;
+    }
+
+    return accepted;
+  }
+
+  std::size_t dispatchTextEvents(Context& context, InjecteeState& state, HandleID injectee, std::span<const TextStroke> data) {
+    auto accepted = std::size_t{0};
+    if (auto* recorder = activeRecorder()) {
+      accepted = recordTextEvents(*recorder, injectee, data);
+    } else {
+      // Anything short of the whole batch may mean the injectee is gone, so check it next time.
+      accepted = submitPaced(context, state, data, [&](std::span<const TextStroke> part) {
+        translateTextEvents(*context.scratch, part);
+        return submitTranslated(*context.scratch, injectee);
+      });
+      if (accepted < data.size())
+        staleInjectee(state);
+    }
+
+    // Characters typed through an input method never hold a key.
+    for (const auto& stroke : data.first(accepted))
+      if (!stroke.unicode)
+        state.held.set(stroke.key.key, stroke.key.state == InputState::Press);
+    return accepted;
+  }
+}
+
+namespace simular::reminput {
+  void setValidationInterval(std::chrono::nanoseconds interval) {
+    detail::validationInterval.store(interval.count(), std::memory_order_relaxed);
+    detail::staleInjectees();
+  }
+
+  void invalidateInjectee(HandleID injectee) {
+    // Only checks of this handle, or one sharing its bucket, are made to look again.
+    auto  stamp = detail::invalidationCount.fetch_add(1, std::memory_order_acq_rel) + 1;
+    auto& slot  = detail::invalidationStamp(injectee);
+    auto  seen  = slot.load(std::memory_order_relaxed);
+
+    // Never lower a stamp a later invalidation already raised.
+    while (seen < stamp && !slot.compare_exchange_weak(seen, stamp, std::memory_order_acq_rel)) {
+    }
+  }
+}
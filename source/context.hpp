@@ -0,0 +1,330 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/**
+ * \file
+ * \brief   The state an injection context keeps between injections.
+ */
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <reminput/reminput.hpp>
+#include "backend.hpp"
+#include "config.hpp"
+
+namespace simular::reminput::detail {
+  /**
+   * \brief   What a context remembers about a single injectee.
+   */
+  struct InjecteeState final {
+    /**
+     * \brief   The last cursor position sent to the injectee, in backend coordinates.
+     * \details Only backends read it, to skip repeated moves. It is never turned back into an event,
+     *          since it was already mapped by the transform.
+     */
+    Cursor cursor;
+
+    /**
+     * \brief   The validation generation the injectee was last found valid in, zero if never.
+     */
+    uint64_t generation = 0;
+
+    /**
+     * \brief   When the injectee was last found valid, in steady clock nanoseconds.
+     */
+    int64_t validatedAt = 0;
+
+    /**
+     * \brief   How many injectees had been invalidated one by one when this one was last found valid.
+     */
+    uint64_t invalidations = 0;
+
+    /**
+     * \brief   The keys and buttons the accepted events left held down.
+     */
+    InputSet held;
+
+    /**
+     * \brief   When the next event is due under the pacing budget, in steady clock nanoseconds.
+     */
+    int64_t pacedUntil = 0;
+
+    /**
+     * \brief   What relative motion left over below a whole pixel, in 1/`kSubpixelScale` of a pixel.
+     */
+    int32_t subpixelX = 0;
+    int32_t subpixelY = 0;
+
+    /**
+     * \brief   What the positions of mouse events sent to the injectee are relative to.
+     */
+    CoordinateSpace space = CoordinateSpace::Screen;
+
+    /**
+     * \brief   How positions map onto what the backend sends, read when the injectee was last validated.
+     */
+    Transform transform;
+  };
+
+  /**
+   * \brief     Checks a packed record before it reaches the backend tables it indexes.
+   * \details   Records can come from files and other processes, so nothing about them is trusted.
+   * \param[in] event The record.
+   * \return    False for an unknown kind, or a key, button or state past the last one.
+   */
+  constexpr bool validEvent(const InputEvent& event) {
+    switch (event.kind) {
+    case InputEvent::Kind::Keyboard:
+      return event.code < kInputKeyCount && event.state <= static_cast<uint8_t>(InputState::Release);
+    case InputEvent::Kind::Mouse:
+      return event.code <= static_cast<uint8_t>(MouseButton::Button4) && event.state <= static_cast<uint8_t>(InputState::Release);
+    case InputEvent::Kind::Wait:
+      return true;
+    }
+
+    return false;
+  }
+
+  /**
+   * \brief         Notes which keys accepted events left held down.
+   * \param[in,out] state What the context remembers about the injectee.
+   * \param[in]     data The accepted events.
+   */
+  void trackKeyboardEvents(InjecteeState& state, std::span<const KeyEventData> data);
+
+  /**
+   * \brief         Notes which buttons accepted events left held down.
+   * \param[in,out] state What the context remembers about the injectee.
+   * \param[in]     data The accepted events.
+   */
+  void trackMouseEvents(InjecteeState& state, std::span<const MouseEventData> data);
+
+  /**
+   * \brief         Checks the injectee, asking the backend only when the cached result is stale.
+   * \details       A result is stale once the validation interval passed, after any explicit
+   *                invalidation, or after a failed submission. Invalid results are never cached.
+   *                The transform of the injectee is read again along with each check. While
+   *                recording, any non-null injectee is valid.
+   * \param[in,out] state What the calling context remembers about the injectee.
+   * \param[in]     injectee The handle to check.
+   * \return        True if events can be submitted for the injectee.
+   */
+  bool checkInjectee(InjecteeState& state, HandleID injectee);
+
+  /**
+   * \brief         Marks the cached validation of an injectee as stale.
+   * \param[in,out] state What the calling context remembers about the injectee.
+   */
+  inline void staleInjectee(InjecteeState& state) {
+    state.generation = 0;
+  }
+
+  /**
+   * \brief   Marks the cached validation of every injectee in every context as stale.
+   */
+  void staleInjectees();
+
+  /**
+   * \brief   The state behind an `Injector`.
+   * \details Aligned to a cache line so that contexts used by different threads never share one.
+   */
+  struct alignas(SIMULAR_PROCESSOR_CACHE_LINE_SIZE) Context final {
+    /**
+     * \brief   The buffers batches are translated into.
+     */
+    std::unique_ptr<Scratch, ScratchDeleter> scratch = createScratch();
+
+    /**
+     * \brief   What the context remembers about each injectee.
+     */
+    std::unordered_map<HandleID, InjecteeState> injectees;
+
+    /**
+     * \brief   Whether runs of consecutive pure moves are collapsed to their newest position.
+     */
+    bool coalesceMoves = false;
+
+    /**
+     * \brief   The number of moves dropped because a newer one replaced them.
+     */
+    uint64_t coalescedMoves = 0;
+
+    /**
+     * \brief   The budget every injectee gets.
+     */
+    PacingOptions pacing;
+
+    /**
+     * \brief   The time between events and how far ahead of it a burst may run, in nanoseconds,
+     *          or zero when injectees are not paced.
+     */
+    int64_t pacingInterval  = 0;
+    int64_t pacingTolerance = 0;
+
+    /**
+     * \brief   How much pacing held the context back.
+     */
+    PacingStatistics pacingStatistics;
+
+    /**
+     * \brief   The mouse events left after coalescing.
+     */
+    std::vector<MouseEventData> moves;
+
+    /**
+     * \brief   How many of the original events each coalesced event stands for, cumulatively.
+     */
+    std::vector<std::size_t> moveEnds;
+
+    /**
+     * \brief   What the positions of mouse events are relative to, given to each new injectee.
+     */
+    CoordinateSpace space = CoordinateSpace::Screen;
+
+    /**
+     * \brief   The mouse events of a piece with their positions mapped for the backend.
+     */
+    std::vector<MouseEventData> mapped;
+
+    /**
+     * \brief   The relative motions left after rounding to whole pixels.
+     */
+    std::vector<MouseMotionData> motions;
+
+    /**
+     * \brief   How many of the original motions each one left stands for, cumulatively.
+     */
+    std::vector<std::size_t> motionEnds;
+
+    /**
+     * \brief   The strokes text is turned into.
+     */
+    std::vector<TextStroke> text;
+
+    /**
+     * \brief   How many strokes type each character of the text, cumulatively.
+     */
+    std::vector<std::size_t> textEnds;
+
+    /**
+     * \brief   The key events a run of packed records is unpacked into.
+     */
+    std::vector<KeyEventData> keys;
+
+    /**
+     * \brief   The mouse events a run of packed records is unpacked into.
+     */
+    std::vector<MouseEventData> mice;
+
+    /**
+     * \brief   How many records of the run each unpacked event accounts for, cumulatively.
+     */
+    std::vector<std::size_t> eventEnds;
+
+    /**
+     * \brief   The button changes that take the held buttons to a desired set, as motions that
+     *          never move.
+     */
+    std::vector<MouseMotionData> buttons;
+  };
+
+  /**
+   * \brief   The most injectees a context remembers.
+   * \details Handles can come from other processes through the daemon and the socket server, so
+   *          the map must not grow with every handle ever named.
+   */
+  constexpr std::size_t kMaxInjectees = 4096;
+
+  /**
+   * \brief         Makes room to remember one more injectee.
+   * \details       Once the limit is reached, every injectee that holds nothing is forgotten. Its
+   *                cursor and pacing start over if it is named again. Injectees holding keys or
+   *                buttons are kept, so releasing them still works.
+   * \param[in,out] context The context whose injectees to trim.
+   * \return        False if every remembered injectee still holds something, so no room was made.
+   */
+  bool makeInjecteeRoom(Context& context);
+
+  /**
+   * \brief         Submits a batch of key events to the log being recorded, or else to the backend.
+   * \details       The injectee is made stale when not every event was accepted.
+   * \param[in,out] context The context to translate in.
+   * \param[in,out] state What the context remembers about the injectee.
+   * \param[in]     injectee The injectee, already checked.
+   * \param[in]     data The events to submit.
+   * \return        The number of events, counted from the front of `data`, that were accepted.
+   */
+  std::size_t dispatchKeyboardEvents(Context& context, InjecteeState& state, HandleID injectee, std::span<const KeyEventData> data);
+
+  /**
+   * \brief         Submits a batch of mouse events to the log being recorded, or else to the backend.
+   * \details       The injectee is made stale when not every event was accepted. When the context
+   *                coalesces moves, each run of pure moves is submitted as its last move only, and
+   *                the dropped moves count as accepted once the move replacing them is.
+   * \param[in,out] context The context to translate in.
+   * \param[in,out] state What the context remembers about the injectee.
+   * \param[in]     injectee The injectee, already checked.
+   * \param[in]     data The events to submit.
+   * \return        The number of events, counted from the front of `data`, that were accepted.
+   */
+  std::size_t dispatchMouseEvents(Context& context, InjecteeState& state, HandleID injectee, std::span<const MouseEventData> data);
+
+  /**
+   * \brief         Submits a batch of relative motions to the log being recorded, or else to the backend.
+   * \details       Deltas are rounded to whole pixels, carrying the rest into the next motion.
+   *                Motions left with nothing to send are folded into the next one sent. When the
+   *                context coalesces moves, or pacing set to coalesce would otherwise wait, runs of
+   *                pure motions are summed into one. The remainders only move on for motions that
+   *                were accepted, and the injectee is made stale when not every motion was.
+   * \param[in,out] context The context to translate in.
+   * \param[in,out] state What the context remembers about the injectee.
+   * \param[in]     injectee The injectee, already checked.
+   * \param[in]     data The motions to submit, in 1/`kSubpixelScale` of a pixel.
+   * \return        The number of motions, counted from the front of `data`, that were accepted.
+   */
+  std::size_t dispatchMotionEvents(Context& context, InjecteeState& state, HandleID injectee, std::span<const MouseMotionData> data);
+
+  /**
+   * \brief         Submits whatever presses and releases it takes for exactly a set of keys and buttons
+   *                to be held.
+   * \details       Releases go first, keys before buttons. Buttons are sent as motions that never
+   *                move, so they change where the pointer already is, wherever that may be.
+   * \param[in,out] context The context to translate in.
+   * \param[in,out] state What the context remembers about the injectee.
+   * \param[in]     injectee The injectee, already checked.
+   * \param[in]     desired The keys and buttons that should be held afterwards.
+   * \param[out]    count The number of presses and releases it takes.
+   * \return        The number of presses and releases, in the order sent, that were accepted.
+   */
+  std::size_t dispatchInputState(Context& context, InjecteeState& state, HandleID injectee, const InputSet& desired, std::size_t& count);
+
+  /**
+   * \brief         Submits the strokes typing a text to the log being recorded, or else to the backend.
+   * \details       The injectee is made stale when not every stroke was accepted.
+   * \param[in,out] context The context to translate in.
+   * \param[in,out] state What the context remembers about the injectee.
+   * \param[in]     injectee The injectee, already checked.
+   * \param[in]     data The strokes to submit.
+   * \return        The number of strokes, counted from the front of `data`, that were accepted.
+   */
+  std::size_t dispatchTextEvents(Context& context, InjecteeState& state, HandleID injectee, std::span<const TextStroke> data);
+}
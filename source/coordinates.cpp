@@ -0,0 +1,44 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <algorithm>
+#include "coordinates.hpp"
+
+namespace simular::reminput::detail {
+  void scaleAxis(int64_t origin, int64_t pixels, int64_t span, int64_t& scale, int64_t& offset) {
+    scale  = (span << kTransformBits) / std::max<int64_t>(pixels - 1, 1);
+    offset = -origin * scale + (int64_t{1} << (kTransformBits - 1));
+  }
+
+  std::span<const MouseEventData> mapPositions(const Transform& transform, std::span<const MouseEventData> data, std::vector<MouseEventData>& mapped) {
+    if (transform.identity())
+      return data;
+
+    // Straight line code with no branches, so the compiler can vectorize it.
+    mapped.assign(data.begin(), data.end());
+    for (auto& event : mapped) {
+      event.xpos = static_cast<int32_t>((event.xpos * transform.scaleX + transform.offsetX) >> kTransformBits);
+      event.ypos = static_cast<int32_t>((event.ypos * transform.scaleY + transform.offsetY) >> kTransformBits);
+    }
+
+    return mapped;
+  }
+}
@@ -0,0 +1,79 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/**
+ * \file
+ * \brief   Maps the positions of mouse events onto the coordinates a backend sends.
+ * \details A mapping is a fixed point scale and offset on each axis, worked out once from the
+ *          geometry of an injectee and the desktop, so a batch is mapped with a multiply-add per
+ *          position instead of asking the window system about each one.
+ */
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+#include <reminput/reminput.hpp>
+
+namespace simular::reminput::detail {
+  /**
+   * \brief   The number of bits of a scale below one.
+   */
+  constexpr int kTransformBits = 16;
+
+  /**
+   * \brief   Maps a position onto backend coordinates as `(position * scale + offset) >> kTransformBits`.
+   * \details Offsets include half a unit, so the shift rounds to the nearest coordinate.
+   */
+  struct Transform final {
+    int64_t scaleX  = int64_t{1} << kTransformBits;
+    int64_t scaleY  = int64_t{1} << kTransformBits;
+    int64_t offsetX = 0;
+    int64_t offsetY = 0;
+
+    /**
+     * \brief   Checks whether the transform leaves every position as it is.
+     */
+    bool identity() const {
+      return scaleX == int64_t{1} << kTransformBits && scaleY == int64_t{1} << kTransformBits &&
+             offsetX == 0 && offsetY == 0;
+    }
+  };
+
+  /**
+   * \brief      Works out the transform that takes pixels from an origin onto an axis spanning a range.
+   * \details    Pixel `origin` lands on zero and pixel `origin + pixels - 1` on `span`.
+   * \param[in]  origin The pixel that lands on zero.
+   * \param[in]  pixels The number of pixels the axis spans.
+   * \param[in]  span The largest backend coordinate on the axis.
+   * \param[out] scale The scale of the axis.
+   * \param[out] offset The offset of the axis.
+   */
+  void scaleAxis(int64_t origin, int64_t pixels, int64_t span, int64_t& scale, int64_t& offset);
+
+  /**
+   * \brief         Maps the positions of a batch of mouse events.
+   * \param[in]     transform The transform to apply.
+   * \param[in]     data The events to map.
+   * \param[in,out] mapped Where mapped events are kept, reused between batches.
+   * \return        The events to send, which are `data` itself when the transform changes nothing.
+   */
+  std::span<const MouseEventData> mapPositions(const Transform& transform, std::span<const MouseEventData> data, std::vector<MouseEventData>& mapped);
+}
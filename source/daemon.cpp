@@ -0,0 +1,503 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <new>
+#include <string>
+#include <thread>
+#include <reminput/daemon.hpp>
+#include "config.hpp"
+#include "context.hpp"
+#if defined(SIMULAR_LINUX_PLATFORM)
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+namespace simular::reminput {
+#if defined(SIMULAR_LINUX_PLATFORM)
+  // Identifies a daemon segment and the layout of its rings.
+  constexpr char     kDaemonMagic[8] = {'R', 'E', 'M', 'D', 'A', 'E', 'M', 'N'};
+  constexpr uint32_t kDaemonVersion  = 2;
+
+  // The most events drained from one ring at a time.
+  constexpr std::size_t kDrainBatchSize = 256;
+
+  // The longest the daemon sleeps, so that rings of clients that died without closing are noticed.
+  constexpr long kSleepNanoseconds = 100000000;
+
+  // Atomics in shared memory must not hide a lock that only one process knows about.
+  static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free);
+
+  // What a ring is being used for.
+  enum RingState : uint32_t {
+    kRingFree,
+    kRingOpen,
+    kRingClosed,
+  };
+
+  // Sits at the front of the segment, followed by the rings.
+  struct SharedHeader final {
+    char     magic[8];
+    uint32_t version;
+    uint32_t clients;
+    uint64_t capacity;
+    uint64_t ringSize;
+    std::atomic<uint64_t> connections;
+
+    // The process of the daemon serving the segment, so another daemon can tell whether it is alive.
+    std::atomic<int32_t> daemon;
+
+    // Clients bump the doorbell to wake a daemon sleeping on it.
+    alignas(SIMULAR_PROCESSOR_CACHE_LINE_SIZE) std::atomic<uint32_t> doorbell;
+    std::atomic<uint32_t> sleeping;
+  };
+
+  // An event in a ring. Handles are only names to the daemon, so they are sent as integers.
+  struct SharedRecord final {
+    uint64_t   injectee;
+    InputEvent event;
+  };
+  static_assert(sizeof(SharedRecord) == 24);
+
+  // The front of a ring, followed by its records. Only the client moves the head and only the
+  // daemon moves the tail, each on its own cache line.
+  struct SharedRing final {
+    alignas(SIMULAR_PROCESSOR_CACHE_LINE_SIZE) std::atomic<uint32_t> state;
+    std::atomic<int32_t> owner;
+    alignas(SIMULAR_PROCESSOR_CACHE_LINE_SIZE) std::atomic<uint64_t> head;
+    alignas(SIMULAR_PROCESSOR_CACHE_LINE_SIZE) std::atomic<uint64_t> tail;
+
+    SharedRecord* records() {
+      return reinterpret_cast<SharedRecord*>(this + 1);
+    }
+  };
+
+  // Finds a ring of the segment. The size is passed in rather than read from the header, since
+  // any process that maps the segment can change that.
+  static SharedRing* ringAt(SharedHeader* header, std::size_t ringSize, std::size_t index) {
+    auto* first = reinterpret_cast<char*>(header) + sizeof(SharedHeader);
+    return reinterpret_cast<SharedRing*>(first + index * ringSize);
+  }
+
+  // Waits on or wakes a word shared between processes.
+  static long futex(std::atomic<uint32_t>& word, int operation, uint32_t value, const timespec* timeout) {
+    return syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), operation, value, timeout, nullptr, 0);
+  }
+
+  struct InjectionDaemon::Segment {
+    // Moves what one ring holds into batches, one per run of events for the same injectee.
+    std::size_t drain(SharedRing& ring) {
+      auto tail  = ring.tail.load(std::memory_order_relaxed);
+      auto head  = ring.head.load(std::memory_order_acquire);
+      auto count = static_cast<std::size_t>(std::min<uint64_t>(head - tail, kDrainBatchSize));
+      if (!count)
+        return 0;
+
+      // Copy the records out and hand the space back before the slow part. Clients can write
+      // anything into their ring, so records the backends cannot index are dropped as failed.
+      auto* records = ring.records();
+      auto  kept    = std::size_t{0};
+      for (std::size_t index = 0; index < count; index++) {
+        const auto& record = records[(tail + index) & mask];
+        injectees[kept]    = record.injectee;
+        events[kept]       = record.event;
+        kept += detail::validEvent(events[kept]);
+      }
+      ring.tail.store(tail + count, std::memory_order_release);
+      failed.fetch_add(count - kept, std::memory_order_relaxed);
+
+      for (std::size_t begin = 0; begin < kept;) {
+        auto end = begin + 1;
+        while (end < kept && injectees[end] == injectees[begin])
+          end++;
+        auto result = injector.tryInjectEvents(reinterpret_cast<HandleID>(injectees[begin]),
+                                               std::span(events.data() + begin, end - begin));
+        submitted.fetch_add(result.accepted, std::memory_order_relaxed);
+        failed.fetch_add(end - begin - result.accepted, std::memory_order_relaxed);
+        begin = end;
+      }
+
+      return count;
+    }
+
+    // Gives a ring back once its client is gone and everything it sent was drained.
+    void recycle(SharedRing& ring) {
+      if (ring.head.load(std::memory_order_acquire) != ring.tail.load(std::memory_order_relaxed))
+        return;
+      ring.head.store(0, std::memory_order_relaxed);
+      ring.tail.store(0, std::memory_order_relaxed);
+      ring.owner.store(0, std::memory_order_relaxed);
+      ring.state.store(kRingFree, std::memory_order_release);
+    }
+
+    // Closes the rings of clients that died without closing them.
+    void reap() {
+      for (std::size_t index = 0; index < clients; index++) {
+        auto* ring = ringAt(header, ringSize, index);
+        if (ring->state.load(std::memory_order_acquire) != kRingOpen)
+          continue;
+        auto owner = ring->owner.load(std::memory_order_relaxed);
+        if (owner > 0 && kill(owner, 0) != 0 && errno == ESRCH)
+          ring->state.store(kRingClosed, std::memory_order_release);
+      }
+    }
+
+    std::string   name;
+    SharedHeader* header   = nullptr;
+    std::size_t   length   = 0;
+    std::size_t   clients  = 0;
+    std::size_t   ringSize = 0;
+    uint64_t      mask     = 0;
+    std::size_t   spins    = 0;
+
+    // Only touched by the thread draining.
+    Injector                                 injector;
+    std::array<uint64_t, kDrainBatchSize>   injectees;
+    std::array<InputEvent, kDrainBatchSize> events;
+
+    std::atomic<bool>     stopping{false};
+    std::atomic<uint64_t> submitted{0};
+    std::atomic<uint64_t> failed{0};
+  };
+
+  // Checks whether a process is still running, counting one we may not signal as running.
+  static bool processAlive(int32_t pid) {
+    return pid > 0 && (kill(pid, 0) == 0 || errno != ESRCH);
+  }
+
+  // Checks whether an existing segment was left by a daemon of this layout that is gone. Anything
+  // else, a live daemon or a segment that is not ours, is left alone.
+  static bool abandonedSegment(const char* name) {
+    int fd = shm_open(name, O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0)
+      return errno == ENOENT;
+
+    struct stat status{};
+    void* view = MAP_FAILED;
+    if (fstat(fd, &status) == 0 && status.st_size >= static_cast<off_t>(sizeof(SharedHeader)))
+      view = mmap(nullptr, sizeof(SharedHeader), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED)
+      return false;
+
+    auto* header    = static_cast<const SharedHeader*>(view);
+    auto  abandoned = std::memcmp(header->magic, kDaemonMagic, sizeof(header->magic)) == 0 &&
+                      header->version == kDaemonVersion &&
+                      !processAlive(header->daemon.load(std::memory_order_relaxed));
+    munmap(view, sizeof(SharedHeader));
+    return abandoned;
+  }
+
+  InjectionDaemon::InjectionDaemon(const DaemonOptions& options) : segment(std::make_unique<Segment>()) {
+    auto capacity = std::bit_ceil(std::max<std::size_t>(options.capacity, 2));
+    auto clients  = std::max<std::size_t>(options.clients, 1);
+    auto ringSize = (sizeof(SharedRing) + capacity * sizeof(SharedRecord) + SIMULAR_PROCESSOR_CACHE_LINE_SIZE - 1) /
+                    SIMULAR_PROCESSOR_CACHE_LINE_SIZE * SIMULAR_PROCESSOR_CACHE_LINE_SIZE;
+    auto length   = sizeof(SharedHeader) + clients * ringSize;
+
+    // A segment left by a daemon that died is replaced, since its clients are gone with it. One
+    // served by a live daemon is never taken away from it.
+    int fd = shm_open(options.name, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    if (fd < 0 && errno == EEXIST && abandonedSegment(options.name)) {
+      shm_unlink(options.name);
+      fd = shm_open(options.name, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    }
+    if (fd < 0)
+      return;
+
+    void* view = MAP_FAILED;
+    if (ftruncate(fd, static_cast<off_t>(length)) == 0)
+      view = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED) {
+      shm_unlink(options.name);
+      return;
+    }
+
+    // The fresh segment is zeroed, so only the atomics need constructing over it.
+    auto* header = new (view) SharedHeader{};
+    std::memcpy(header->magic, kDaemonMagic, sizeof(header->magic));
+    header->version  = kDaemonVersion;
+    header->clients  = static_cast<uint32_t>(clients);
+    header->capacity = capacity;
+    header->ringSize = ringSize;
+    header->daemon.store(static_cast<int32_t>(getpid()), std::memory_order_relaxed);
+    for (std::size_t index = 0; index < clients; index++)
+      new (ringAt(header, ringSize, index)) SharedRing{};
+
+    // The layout is kept here too, since clients can write to the header.
+    segment->name     = options.name;
+    segment->header   = header;
+    segment->length   = length;
+    segment->clients  = clients;
+    segment->ringSize = ringSize;
+    segment->mask     = capacity - 1;
+    segment->spins    = options.spins;
+  }
+
+  InjectionDaemon::~InjectionDaemon() {
+    if (!segment->header)
+      return;
+    munmap(segment->header, segment->length);
+    shm_unlink(segment->name.c_str());
+  }
+
+  bool InjectionDaemon::valid() const {
+    return segment->header != nullptr;
+  }
+
+  std::size_t InjectionDaemon::poll() {
+    auto* header  = segment->header;
+    auto  drained = std::size_t{0};
+    if (!header)
+      return 0;
+
+    for (std::size_t index = 0; index < segment->clients; index++) {
+      auto* ring  = ringAt(header, segment->ringSize, index);
+      auto  state = ring->state.load(std::memory_order_acquire);
+      if (state == kRingFree)
+        continue;
+      drained += segment->drain(*ring);
+      if (state == kRingClosed)
+        segment->recycle(*ring);
+    }
+
+    return drained;
+  }
+
+  void InjectionDaemon::run() {
+    auto* header = segment->header;
+    if (!header)
+      return;
+
+    auto idle = std::size_t{0};
+    while (true) {
+      if (poll()) {
+        idle = 0;
+        continue;
+      }
+      if (segment->stopping.load(std::memory_order_acquire))
+        break;
+      // Spin for a while, yielding in case a client waits for the same core.
+      if (++idle < segment->spins) {
+        std::this_thread::yield();
+        continue;
+      }
+
+      // Announce the sleep, then look once more so a client that missed it is not stranded.
+      segment->reap();
+      auto rung = header->doorbell.load(std::memory_order_acquire);
+      header->sleeping.store(1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (!poll() && !segment->stopping.load(std::memory_order_relaxed)) {
+        timespec timeout { .tv_sec = 0, .tv_nsec = kSleepNanoseconds };
+        futex(header->doorbell, FUTEX_WAIT, rung, &timeout);
+      }
+      header->sleeping.store(0, std::memory_order_relaxed);
+      idle = 0;
+    }
+  }
+
+  void InjectionDaemon::stop() {
+    segment->stopping.store(true, std::memory_order_release);
+    if (auto* header = segment->header) {
+      header->doorbell.fetch_add(1, std::memory_order_release);
+      futex(header->doorbell, FUTEX_WAKE, INT_MAX, nullptr);
+    }
+  }
+
+  DaemonStatistics InjectionDaemon::statistics() const {
+    return DaemonStatistics {
+      .submitted   = segment->submitted.load(std::memory_order_relaxed),
+      .failed      = segment->failed.load(std::memory_order_relaxed),
+      .connections = segment->header ? segment->header->connections.load(std::memory_order_relaxed) : 0,
+    };
+  }
+
+  struct DaemonClient::Ring {
+    SharedHeader* header = nullptr;
+    SharedRing*   ring   = nullptr;
+    std::size_t   length = 0;
+    uint64_t      mask   = 0;
+
+    // The tail as last read, so a ring that is not full is written without touching the daemon's line.
+    uint64_t      cachedTail = 0;
+  };
+
+  DaemonClient::DaemonClient(const char* name) : ring(std::make_unique<Ring>()) {
+    int fd = shm_open(name, O_RDWR | O_CLOEXEC, 0);
+    if (fd < 0)
+      return;
+
+    struct stat status{};
+    void* view = MAP_FAILED;
+    if (fstat(fd, &status) == 0 && status.st_size >= static_cast<off_t>(sizeof(SharedHeader)))
+      view = mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED)
+      return;
+
+    // Only trust segments of this layout that are as long as they claim, reading the layout once
+    // since other clients can write to the header too.
+    auto* header   = static_cast<SharedHeader*>(view);
+    auto  length   = static_cast<std::size_t>(status.st_size);
+    auto  clients  = std::size_t{header->clients};
+    auto  capacity = header->capacity;
+    auto  ringSize = header->ringSize;
+    if (std::memcmp(header->magic, kDaemonMagic, sizeof(header->magic)) != 0 ||
+        header->version != kDaemonVersion ||
+        !std::has_single_bit(capacity) ||
+        ringSize < sizeof(SharedRing) ||
+        (ringSize - sizeof(SharedRing)) / sizeof(SharedRecord) < capacity ||
+        (length - sizeof(SharedHeader)) / ringSize < clients) {
+      munmap(view, length);
+      return;
+    }
+
+    // Claim the first free ring.
+    for (std::size_t index = 0; index < clients; index++) {
+      auto* shared = ringAt(header, static_cast<std::size_t>(ringSize), index);
+      auto  state  = uint32_t{kRingFree};
+      if (shared->state.compare_exchange_strong(state, kRingOpen, std::memory_order_acq_rel)) {
+        shared->owner.store(static_cast<int32_t>(getpid()), std::memory_order_relaxed);
+        header->connections.fetch_add(1, std::memory_order_relaxed);
+        ring->ring = shared;
+        break;
+      }
+    }
+
+    if (!ring->ring) {
+      munmap(view, length);
+      return;
+    }
+
+    ring->header = header;
+    ring->length = length;
+    ring->mask   = capacity - 1;
+  }
+
+  DaemonClient::~DaemonClient() {
+    if (!ring->ring)
+      return;
+    ring->ring->state.store(kRingClosed, std::memory_order_release);
+    munmap(ring->header, ring->length);
+  }
+
+  bool DaemonClient::connected() const {
+    return ring->ring != nullptr;
+  }
+
+  bool DaemonClient::enqueue(HandleID injectee, const KeyEventData& data) {
+    auto event = InputEvent::fromKeyboard(data);
+    return enqueue(injectee, std::span(&event, 1)) == 1;
+  }
+
+  bool DaemonClient::enqueue(HandleID injectee, const MouseEventData& data) {
+    auto event = InputEvent::fromMouse(data);
+    return enqueue(injectee, std::span(&event, 1)) == 1;
+  }
+
+  std::size_t DaemonClient::enqueue(HandleID injectee, std::span<const InputEvent> data) {
+    auto* shared = ring->ring;
+    if (!shared)
+      return 0;
+
+    // Only reread the tail when the cached one says the ring is full.
+    auto head     = shared->head.load(std::memory_order_relaxed);
+    auto capacity = ring->mask + 1;
+    if (head - ring->cachedTail + data.size() > capacity)
+      ring->cachedTail = shared->tail.load(std::memory_order_acquire);
+    auto count = static_cast<std::size_t>(std::min<uint64_t>(data.size(), capacity - (head - ring->cachedTail)));
+    if (!count)
+      return 0;
+
+    auto* records = shared->records();
+    for (std::size_t index = 0; index < count; index++) {
+      auto& record    = records[(head + index) & ring->mask];
+      record.injectee = reinterpret_cast<uint64_t>(injectee);
+      record.event    = data[index];
+    }
+    shared->head.store(head + count, std::memory_order_release);
+
+    // Only ring the doorbell for a daemon that said it was going to sleep.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    auto* header = ring->header;
+    if (header->sleeping.load(std::memory_order_relaxed)) {
+      header->doorbell.fetch_add(1, std::memory_order_release);
+      futex(header->doorbell, FUTEX_WAKE, 1, nullptr);
+    }
+
+    return count;
+  }
+#else
+  struct InjectionDaemon::Segment {};
+  struct DaemonClient::Ring {};
+
+  InjectionDaemon::InjectionDaemon(const DaemonOptions&) : segment(std::make_unique<Segment>()) {}
+  InjectionDaemon::~InjectionDaemon() = default;
+
+  bool InjectionDaemon::valid() const {
+    return false;
+  }
+
+  std::size_t InjectionDaemon::poll() {
+    return 0;
+  }
+
+  void InjectionDaemon::run() {}
+  void InjectionDaemon::stop() {}
+
+  DaemonStatistics InjectionDaemon::statistics() const {
+    return DaemonStatistics { .submitted = 0, .failed = 0, .connections = 0 };
+  }
+
+  DaemonClient::DaemonClient(const char*) : ring(std::make_unique<Ring>()) {}
+  DaemonClient::~DaemonClient() = default;
+
+  bool DaemonClient::connected() const {
+    return false;
+  }
+
+  bool DaemonClient::enqueue(HandleID, const KeyEventData&) {
+    return false;
+  }
+
+  bool DaemonClient::enqueue(HandleID, const MouseEventData&) {
+    return false;
+  }
+
+  std::size_t DaemonClient::enqueue(HandleID, std::span<const InputEvent>) {
+    return 0;
+  }
+#endif
+}
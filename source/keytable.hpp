@@ -0,0 +1,171 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/**
+ * \file
+ * \brief   The native code of every key on every platform, in one table.
+ * \details Each backend builds its lookup table from its own column, so adding a key is one new
+ *          row here, and a row out of step with `InputKey` fails to compile.
+ */
+#pragma once
+#include <cstddef>
+#include <reminput/reminput.hpp>
+
+// Expands `KEY(name, windows, evdev, keysym)` once per key, in the order of `InputKey`. The columns
+// are the Windows virtual-key code, the Linux input event code, and the X keysym. Only the column a
+// backend expands is ever evaluated, so each may name constants the others' headers lack.
+#define REMINPUT_KEY_TABLE(KEY) \
+  KEY(Undefined,    0,             KEY_RESERVED,   NoSymbol       ) \
+  KEY(A,            0x41,          KEY_A,          XK_a           ) \
+  KEY(B,            0x42,          KEY_B,          XK_b           ) \
+  KEY(C,            0x43,          KEY_C,          XK_c           ) \
+  KEY(D,            0x44,          KEY_D,          XK_d           ) \
+  KEY(E,            0x45,          KEY_E,          XK_e           ) \
+  KEY(F,            0x46,          KEY_F,          XK_f           ) \
+  KEY(G,            0x47,          KEY_G,          XK_g           ) \
+  KEY(H,            0x48,          KEY_H,          XK_h           ) \
+  KEY(I,            0x49,          KEY_I,          XK_i           ) \
+  KEY(J,            0x4A,          KEY_J,          XK_j           ) \
+  KEY(K,            0x4B,          KEY_K,          XK_k           ) \
+  KEY(L,            0x4C,          KEY_L,          XK_l           ) \
+  KEY(M,            0x4D,          KEY_M,          XK_m           ) \
+  KEY(N,            0x4E,          KEY_N,          XK_n           ) \
+  KEY(O,            0x4F,          KEY_O,          XK_o           ) \
+  KEY(P,            0x50,          KEY_P,          XK_p           ) \
+  KEY(Q,            0x51,          KEY_Q,          XK_q           ) \
+  KEY(R,            0x52,          KEY_R,          XK_r           ) \
+  KEY(S,            0x53,          KEY_S,          XK_s           ) \
+  KEY(T,            0x54,          KEY_T,          XK_t           ) \
+  KEY(U,            0x55,          KEY_U,          XK_u           ) \
+  KEY(V,            0x56,          KEY_V,          XK_v           ) \
+  KEY(W,            0x57,          KEY_W,          XK_w           ) \
+  KEY(X,            0x58,          KEY_X,          XK_x           ) \
+  KEY(Y,            0x59,          KEY_Y,          XK_y           ) \
+  KEY(Z,            0x5A,          KEY_Z,          XK_z           ) \
+  KEY(NumBar0,      0x30,          KEY_0,          XK_0           ) \
+  KEY(NumBar1,      0x31,          KEY_1,          XK_1           ) \
+  KEY(NumBar2,      0x32,          KEY_2,          XK_2           ) \
+  KEY(NumBar3,      0x33,          KEY_3,          XK_3           ) \
+  KEY(NumBar4,      0x34,          KEY_4,          XK_4           ) \
+  KEY(NumBar5,      0x35,          KEY_5,          XK_5           ) \
+  KEY(NumBar6,      0x36,          KEY_6,          XK_6           ) \
+  KEY(NumBar7,      0x37,          KEY_7,          XK_7           ) \
+  KEY(NumBar8,      0x38,          KEY_8,          XK_8           ) \
+  KEY(NumBar9,      0x39,          KEY_9,          XK_9           ) \
+  KEY(NumPad0,      VK_NUMPAD0,    KEY_KP0,        XK_KP_0        ) \
+  KEY(NumPad1,      VK_NUMPAD1,    KEY_KP1,        XK_KP_1        ) \
+  KEY(NumPad2,      VK_NUMPAD2,    KEY_KP2,        XK_KP_2        ) \
+  KEY(NumPad3,      VK_NUMPAD3,    KEY_KP3,        XK_KP_3        ) \
+  KEY(NumPad4,      VK_NUMPAD4,    KEY_KP4,        XK_KP_4        ) \
+  KEY(NumPad5,      VK_NUMPAD5,    KEY_KP5,        XK_KP_5        ) \
+  KEY(NumPad6,      VK_NUMPAD6,    KEY_KP6,        XK_KP_6        ) \
+  KEY(NumPad7,      VK_NUMPAD7,    KEY_KP7,        XK_KP_7        ) \
+  KEY(NumPad8,      VK_NUMPAD8,    KEY_KP8,        XK_KP_8        ) \
+  KEY(NumPad9,      VK_NUMPAD9,    KEY_KP9,        XK_KP_9        ) \
+  KEY(NumLock,      VK_NUMLOCK,    KEY_NUMLOCK,    XK_Num_Lock    ) \
+  KEY(NumPadSlash,  VK_DIVIDE,     KEY_KPSLASH,    XK_KP_Divide   ) \
+  KEY(NumPadMul,    VK_MULTIPLY,   KEY_KPASTERISK, XK_KP_Multiply ) \
+  KEY(NumPadAdd,    VK_ADD,        KEY_KPPLUS,     XK_KP_Add      ) \
+  KEY(NumPadSub,    VK_SUBTRACT,   KEY_KPMINUS,    XK_KP_Subtract ) \
+  KEY(NumPadDot,    VK_DECIMAL,    KEY_KPDOT,      XK_KP_Decimal  ) \
+  KEY(NumPadEnter,  VK_RETURN,     KEY_KPENTER,    XK_KP_Enter    ) \
+  KEY(LeftShift,    VK_LSHIFT,     KEY_LEFTSHIFT,  XK_Shift_L     ) \
+  KEY(LeftControl,  VK_LCONTROL,   KEY_LEFTCTRL,   XK_Control_L   ) \
+  KEY(LeftAlt,      VK_LMENU,      KEY_LEFTALT,    XK_Alt_L       ) \
+  KEY(LeftSuper,    VK_LWIN,       KEY_LEFTMETA,   XK_Super_L     ) \
+  KEY(RightShift,   VK_RSHIFT,     KEY_RIGHTSHIFT, XK_Shift_R     ) \
+  KEY(RightControl, VK_RCONTROL,   KEY_RIGHTCTRL,  XK_Control_R   ) \
+  KEY(RightAlt,     VK_RMENU,      KEY_RIGHTALT,   XK_Alt_R       ) \
+  KEY(RightSuper,   VK_RWIN,       KEY_RIGHTMETA,  XK_Super_R     ) \
+  KEY(ArrowUp,      VK_UP,         KEY_UP,         XK_Up          ) \
+  KEY(ArrowRight,   VK_RIGHT,      KEY_RIGHT,      XK_Right       ) \
+  KEY(ArrowDown,    VK_DOWN,       KEY_DOWN,       XK_Down        ) \
+  KEY(ArrowLeft,    VK_LEFT,       KEY_LEFT,       XK_Left        ) \
+  KEY(Enter,        VK_RETURN,     KEY_ENTER,      XK_Return      ) \
+  KEY(Backspace,    VK_BACK,       KEY_BACKSPACE,  XK_BackSpace   ) \
+  KEY(Insert,       VK_INSERT,     KEY_INSERT,     XK_Insert      ) \
+  KEY(Home,         VK_HOME,       KEY_HOME,       XK_Home        ) \
+  KEY(PageUp,       VK_PRIOR,      KEY_PAGEUP,     XK_Prior       ) \
+  KEY(PageDown,     VK_NEXT,       KEY_PAGEDOWN,   XK_Next        ) \
+  KEY(Delete,       VK_DELETE,     KEY_DELETE,     XK_Delete      ) \
+  KEY(End,          VK_END,        KEY_END,        XK_End         ) \
+  KEY(PrintScreen,  VK_SNAPSHOT,   KEY_SYSRQ,      XK_Print       ) \
+  KEY(ScrollLock,   VK_SCROLL,     KEY_SCROLLLOCK, XK_Scroll_Lock ) \
+  KEY(Pause,        VK_PAUSE,      KEY_PAUSE,      XK_Pause       ) \
+  KEY(CapsLock,     VK_CAPITAL,    KEY_CAPSLOCK,   XK_Caps_Lock   ) \
+  KEY(Tab,          VK_TAB,        KEY_TAB,        XK_Tab         ) \
+  KEY(Escape,       VK_ESCAPE,     KEY_ESC,        XK_Escape      ) \
+  KEY(Space,        VK_SPACE,      KEY_SPACE,      XK_space       ) \
+  KEY(Grave,        VK_OEM_3,      KEY_GRAVE,      XK_grave       ) \
+  KEY(Minus,        VK_OEM_MINUS,  KEY_MINUS,      XK_minus       ) \
+  KEY(Equal,        VK_OEM_PLUS,   KEY_EQUAL,      XK_equal       ) \
+  KEY(LBracket,     VK_OEM_4,      KEY_LEFTBRACE,  XK_bracketleft ) \
+  KEY(RBracket,     VK_OEM_6,      KEY_RIGHTBRACE, XK_bracketright) \
+  KEY(Backslash,    VK_OEM_5,      KEY_BACKSLASH,  XK_backslash   ) \
+  KEY(Semicolon,    VK_OEM_1,      KEY_SEMICOLON,  XK_semicolon   ) \
+  KEY(Apostrophe,   VK_OEM_7,      KEY_APOSTROPHE, XK_apostrophe  ) \
+  KEY(Comma,        VK_OEM_COMMA,  KEY_COMMA,      XK_comma       ) \
+  KEY(Period,       VK_OEM_PERIOD, KEY_DOT,        XK_period      ) \
+  KEY(ForwardSlash, VK_OEM_2,      KEY_SLASH,      XK_slash       ) \
+  KEY(F1,           VK_F1,         KEY_F1,         XK_F1          ) \
+  KEY(F2,           VK_F2,         KEY_F2,         XK_F2          ) \
+  KEY(F3,           VK_F3,         KEY_F3,         XK_F3          ) \
+  KEY(F4,           VK_F4,         KEY_F4,         XK_F4          ) \
+  KEY(F5,           VK_F5,         KEY_F5,         XK_F5          ) \
+  KEY(F6,           VK_F6,         KEY_F6,         XK_F6          ) \
+  KEY(F7,           VK_F7,         KEY_F7,         XK_F7          ) \
+  KEY(F8,           VK_F8,         KEY_F8,         XK_F8          ) \
+  KEY(F9,           VK_F9,         KEY_F9,         XK_F9          ) \
+  KEY(F10,          VK_F10,        KEY_F10,        XK_F10         ) \
+  KEY(F11,          VK_F11,        KEY_F11,        XK_F11         ) \
+  KEY(F12,          VK_F12,        KEY_F12,        XK_F12         ) \
+  KEY(F13,          VK_F13,        KEY_F13,        XK_F13         ) \
+  KEY(F14,          VK_F14,        KEY_F14,        XK_F14         ) \
+  KEY(F15,          VK_F15,        KEY_F15,        XK_F15         ) \
+  KEY(F16,          VK_F16,        KEY_F16,        XK_F16         ) \
+  KEY(F17,          VK_F17,        KEY_F17,        XK_F17         ) \
+  KEY(F18,          VK_F18,        KEY_F18,        XK_F18         ) \
+  KEY(F19,          VK_F19,        KEY_F19,        XK_F19         ) \
+  KEY(F20,          VK_F20,        KEY_F20,        XK_F20         ) \
+  KEY(F21,          VK_F21,        KEY_F21,        XK_F21         ) \
+  KEY(F22,          VK_F22,        KEY_F22,        XK_F22         ) \
+  KEY(F23,          VK_F23,        KEY_F23,        XK_F23         ) \
+  KEY(F24,          VK_F24,        KEY_F24,        XK_F24         )
+
+namespace simular::reminput::detail {
+#define REMINPUT_KEY_TABLE_ORDER(name, windows, evdev, keysym) InputKey::name,
+  // The keys of the table, in row order.
+  constexpr InputKey kKeyTableOrder[] = { REMINPUT_KEY_TABLE(REMINPUT_KEY_TABLE_ORDER) };
+#undef REMINPUT_KEY_TABLE_ORDER
+
+  // Checks that row i of the table describes key i.
+  constexpr bool keyTableInOrder() {
+    if (std::size(kKeyTableOrder) != kInputKeyCount)
+      return false;
+    for (std::size_t index = 0; index < kInputKeyCount; index++) {
+      if (kKeyTableOrder[index] != static_cast<InputKey>(index))
+        return false;
+    }
+
+    return true;
+  }
+  static_assert(keyTableInOrder(), "REMINPUT_KEY_TABLE must have one row per InputKey, in order");
+}
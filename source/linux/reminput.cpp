@@ -0,0 +1,317 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <reminput/reminput.hpp>
+#include <reminput/uinput.hpp>
+#include "../backend.hpp"
+#include "../config.hpp"
+#include "../keytable.hpp"
+#include "../profiling.hpp"
+#if defined(SIMULAR_LINUX_PLATFORM) && !defined(REMINPUT_X11_BACKEND)
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <linux/input.h>
+#include <linux/uinput.h>
+
+namespace simular::reminput {
+  // Maps linux input event key codes to our Input keys.
+#define REMINPUT_EVDEV_CODE(name, windows, evdev, keysym) evdev,
+  constexpr std::array<uint16_t, kInputKeyCount> kInputKeyMap { REMINPUT_KEY_TABLE(REMINPUT_EVDEV_CODE) };
+#undef REMINPUT_EVDEV_CODE
+
+  // Maps linux input event button codes to our mouse buttons.
+  constexpr std::array<uint16_t, 6> kMouseButtonMap {
+    0, // Button undefined.
+    BTN_LEFT, BTN_RIGHT, BTN_MIDDLE, BTN_SIDE, BTN_EXTRA,
+  };
+
+  // The device every injection is written to, opened on first use. The options point into the
+  // strings kept beside them, so callers need not keep theirs alive.
+  static std::mutex       deviceMutex;
+  static std::atomic<int> deviceDescriptor{-1};
+  static UInputOptions    deviceOptions;
+  static std::string      devicePath = deviceOptions.path;
+  static std::string      deviceName = deviceOptions.name;
+
+  // Writers between loading the descriptor and finishing with it, so a replaced device is only
+  // closed once none of them can still be writing to it.
+  static std::atomic<int> deviceWriters{0};
+
+  // Creates the virtual keyboard and mouse, returning its descriptor or -1 on failure.
+  static int createDevice(const UInputOptions& options) {
+    auto descriptor = open(options.path, O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+    if (descriptor < 0)
+      return -1;
+
+    // Declare every event the device can produce.
+    auto ok = ioctl(descriptor, UI_SET_EVBIT, EV_SYN) == 0 &&
+              ioctl(descriptor, UI_SET_EVBIT, EV_KEY) == 0 &&
+              ioctl(descriptor, UI_SET_EVBIT, EV_REL) == 0 &&
+              ioctl(descriptor, UI_SET_EVBIT, EV_ABS) == 0 &&
+              ioctl(descriptor, UI_SET_RELBIT, REL_X) == 0 &&
+              ioctl(descriptor, UI_SET_RELBIT, REL_Y) == 0 &&
+              ioctl(descriptor, UI_SET_RELBIT, REL_WHEEL) == 0 &&
+              ioctl(descriptor, UI_SET_ABSBIT, ABS_X) == 0 &&
+              ioctl(descriptor, UI_SET_ABSBIT, ABS_Y) == 0;
+    for (auto code : kInputKeyMap)
+      ok = ok && (code == 0 || ioctl(descriptor, UI_SET_KEYBIT, code) == 0);
+    for (auto code : kMouseButtonMap)
+      ok = ok && (code == 0 || ioctl(descriptor, UI_SET_KEYBIT, code) == 0);
+
+    // Describe the device itself.
+    uinput_setup setup{};
+    setup.id.bustype = BUS_VIRTUAL;
+    setup.id.vendor  = 0x5347;
+    setup.id.product = 0x0001;
+    std::strncpy(setup.name, options.name, UINPUT_MAX_NAME_SIZE - 1);
+    ok = ok && ioctl(descriptor, UI_DEV_SETUP, &setup) == 0;
+
+    // Absolute axes span the screen so positions can be sent in screen space.
+    uinput_abs_setup axisX{};
+    axisX.code               = ABS_X;
+    axisX.absinfo.maximum    = std::max(options.width - 1, 0);
+    uinput_abs_setup axisY{};
+    axisY.code               = ABS_Y;
+    axisY.absinfo.maximum    = std::max(options.height - 1, 0);
+    ok = ok && ioctl(descriptor, UI_ABS_SETUP, &axisX) == 0 &&
+               ioctl(descriptor, UI_ABS_SETUP, &axisY) == 0 &&
+               ioctl(descriptor, UI_DEV_CREATE) == 0;
+
+    if (!ok) {
+      close(descriptor);
+      return -1;
+    }
+
+    return descriptor;
+  }
+
+  // Returns the device descriptor, opening the device if this is the first use.
+  static int acquireDevice() {
+    auto descriptor = deviceDescriptor.load(std::memory_order_acquire);
+    if (descriptor >= 0)
+      return descriptor;
+
+    std::lock_guard lock(deviceMutex);
+    descriptor = deviceDescriptor.load(std::memory_order_relaxed);
+    if (descriptor < 0) {
+      descriptor = createDevice(deviceOptions);
+      deviceDescriptor.store(descriptor, std::memory_order_release);
+    }
+
+    return descriptor;
+  }
+
+  // Swaps the device for another, destroying the previous one once no writer can still use it.
+  // Writers that start after the swap load the new descriptor, so only those already counted
+  // are waited for.
+  static void replaceDevice(int descriptor) {
+    auto previous = deviceDescriptor.exchange(descriptor, std::memory_order_seq_cst);
+    if (previous >= 0) {
+      while (deviceWriters.load(std::memory_order_seq_cst) != 0)
+        std::this_thread::yield();
+      ioctl(previous, UI_DEV_DESTROY);
+      close(previous);
+    }
+  }
+
+  void configureUInputDevice(const UInputOptions& options) {
+    std::lock_guard lock(deviceMutex);
+    devicePath         = options.path;
+    deviceName         = options.name;
+    deviceOptions      = options;
+    deviceOptions.path = devicePath.c_str();
+    deviceOptions.name = deviceName.c_str();
+    replaceDevice(-1);
+  }
+
+  void attachUInputDevice(int descriptor) {
+    std::lock_guard lock(deviceMutex);
+    replaceDevice(descriptor);
+  }
+
+  void closeUInputDevice() {
+    std::lock_guard lock(deviceMutex);
+    replaceDevice(-1);
+  }
+
+  // Appends a single input event record.
+  static void appendEvent(std::vector<input_event>& events, uint16_t type, uint16_t code, int32_t value) {
+    input_event event{};
+    event.type  = type;
+    event.code  = code;
+    event.value = value;
+    events.push_back(event);
+  }
+
+  // Writes the whole buffer in as few calls as possible and returns how many events were accepted.
+  static std::size_t writeEvents(const std::vector<input_event>& events, const std::vector<std::size_t>& ends) {
+    REMINPUT_PROFILE_STAGE(Submit);
+    if (acquireDevice() < 0)
+      return 0;
+
+    // Count this writer before loading the descriptor again, so the device cannot be closed
+    // under it. A device closed since it was opened above accepts nothing.
+    deviceWriters.fetch_add(1, std::memory_order_seq_cst);
+    auto descriptor = deviceDescriptor.load(std::memory_order_seq_cst);
+    if (descriptor < 0) {
+      deviceWriters.fetch_sub(1, std::memory_order_release);
+      return 0;
+    }
+
+    const auto* bytes = reinterpret_cast<const char*>(events.data());
+    auto total        = events.size() * sizeof(input_event);
+    auto written      = std::size_t{0};
+    while (written < total) {
+      auto result = write(descriptor, bytes + written, total - written);
+      if (result < 0 && errno == EINTR)
+        continue;
+      if (result <= 0)
+        break;
+      written += static_cast<std::size_t>(result);
+    }
+    deviceWriters.fetch_sub(1, std::memory_order_release);
+
+    // An event only counts as accepted when all of its records were written.
+    auto records = written / sizeof(input_event);
+    return static_cast<std::size_t>(std::upper_bound(ends.begin(), ends.end(), records) - ends.begin());
+  }
+}
+
+namespace simular::reminput::detail {
+  // Buffers reused between batches so that steady state injection does not allocate.
+  struct Scratch final {
+    std::vector<input_event> events;
+    std::vector<std::size_t> ends;
+  };
+
+  void ScratchDeleter::operator()(Scratch* scratch) const {
+    delete scratch;
+  }
+
+  std::unique_ptr<Scratch, ScratchDeleter> createScratch() {
+    return std::unique_ptr<Scratch, ScratchDeleter>(new Scratch());
+  }
+
+  const char* const kInvalidInjecteeMessage = "Injectee is not a valid session handle.";
+
+  bool validateInjectee(HandleID injectee) {
+    // The device is shared, so the handle only has to name someone.
+    return injectee != nullptr;
+  }
+
+  bool queryTransform(HandleID, CoordinateSpace, Transform& transform) {
+    // A session spans the screen the device was set up with, so positions are sent as they are.
+    transform = Transform{};
+    return true;
+  }
+
+  void translateKeyboardEvents(Scratch& scratch, std::span<const KeyEventData> data) {
+    // Each event gets its own report so that presses and releases are never merged.
+    REMINPUT_PROFILE_STAGE(Translate);
+    scratch.events.clear();
+    scratch.ends.clear();
+    for (const auto& event : data) {
+      appendEvent(scratch.events, EV_KEY, kInputKeyMap[static_cast<std::size_t>(event.key)],
+                  event.state == InputState::Press ? 1 : 0);
+      appendEvent(scratch.events, EV_SYN, SYN_REPORT, 0);
+      scratch.ends.push_back(scratch.events.size());
+    }
+  }
+
+  void translateMouseEvents(Scratch& scratch, Cursor& cursor, std::span<const MouseEventData> data) {
+    // Each event gets its own report so that presses and releases are never merged.
+    REMINPUT_PROFILE_STAGE(Translate);
+    scratch.events.clear();
+    scratch.ends.clear();
+    for (const auto& event : data) {
+      // Check if mouse moved.
+      if (cursor.x != event.xpos)
+        appendEvent(scratch.events, EV_ABS, ABS_X, event.xpos);
+      if (cursor.y != event.ypos)
+        appendEvent(scratch.events, EV_ABS, ABS_Y, event.ypos);
+      cursor.x = event.xpos;
+      cursor.y = event.ypos;
+
+      // Check if wheel was scrolled.
+      if (event.scrolldy)
+        appendEvent(scratch.events, EV_REL, REL_WHEEL, event.scrolldy);
+
+      // Check for button clicks.
+      if (auto code = kMouseButtonMap[static_cast<std::size_t>(event.button)])
+        appendEvent(scratch.events, EV_KEY, code, event.state == InputState::Press ? 1 : 0);
+
+      appendEvent(scratch.events, EV_SYN, SYN_REPORT, 0);
+      scratch.ends.push_back(scratch.events.size());
+    }
+  }
+
+  void translateMotionEvents(Scratch& scratch, std::span<const MouseMotionData> data) {
+    // Each motion gets its own report, so a button goes with the move it was given with.
+    REMINPUT_PROFILE_STAGE(Translate);
+    scratch.events.clear();
+    scratch.ends.clear();
+    for (const auto& event : data) {
+      if (event.dx)
+        appendEvent(scratch.events, EV_REL, REL_X, event.dx);
+      if (event.dy)
+        appendEvent(scratch.events, EV_REL, REL_Y, event.dy);
+      if (event.scrolldy)
+        appendEvent(scratch.events, EV_REL, REL_WHEEL, event.scrolldy);
+      if (auto code = kMouseButtonMap[static_cast<std::size_t>(event.button)])
+        appendEvent(scratch.events, EV_KEY, code, event.state == InputState::Press ? 1 : 0);
+
+      appendEvent(scratch.events, EV_SYN, SYN_REPORT, 0);
+      scratch.ends.push_back(scratch.events.size());
+    }
+  }
+
+  // A virtual keyboard can only press keys, so text is limited to what the keys can type.
+  const bool kUnicodeText = false;
+
+  void translateTextEvents(Scratch& scratch, std::span<const TextStroke> data) {
+    REMINPUT_PROFILE_STAGE(Translate);
+    scratch.events.clear();
+    scratch.ends.clear();
+    for (const auto& stroke : data) {
+      appendEvent(scratch.events, EV_KEY, kInputKeyMap[static_cast<std::size_t>(stroke.key.key)],
+                  stroke.key.state == InputState::Press ? 1 : 0);
+      appendEvent(scratch.events, EV_SYN, SYN_REPORT, 0);
+      scratch.ends.push_back(scratch.events.size());
+    }
+  }
+
+  std::size_t submitTranslated(const Scratch& scratch, HandleID) {
+    // The kernel serializes writes to the device, so concurrent submissions never interleave.
+    return writeEvents(scratch.events, scratch.ends);
+  }
+}
+
+#endif
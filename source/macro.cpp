@@ -0,0 +1,180 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <reminput/macro.hpp>
+#include "config.hpp"
+#include "context.hpp"
+#if defined(SIMULAR_WINDOWS_PLATFORM)
+#define UNICODE 1
+#define _UNICODE 1
+#define WIN32_LEAN_AND_MEAN 1
+#define VC_EXTRALEAN 1
+#include <windows.h>
+#elif defined(SIMULAR_POSIX_PLATFORM)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace simular::reminput {
+  // Identifies a macro and the layout of its records.
+  constexpr char     kMacroMagic[8] = {'R', 'E', 'M', 'M', 'A', 'C', 'R', 'O'};
+  constexpr uint32_t kMacroVersion  = 1;
+
+  // Sits at the front of a macro, followed by its records.
+  struct MacroHeader final {
+    char     magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+    uint64_t count;
+    uint64_t reserved;
+  };
+  static_assert(sizeof(MacroHeader) == 32);
+
+  // Headers and records are written and mapped as they are in memory, and the format is little-endian.
+  static_assert(std::endian::native == std::endian::little, "macro files are only readable on little-endian platforms");
+
+  uint32_t MacroWriter::split(std::chrono::nanoseconds delay) {
+    constexpr auto kLongest = std::numeric_limits<uint32_t>::max();
+    auto remaining = static_cast<uint64_t>(std::max<int64_t>(delay.count(), 0));
+    while (remaining > kLongest) {
+      entries.push_back(MacroRecord::wait(kLongest));
+      remaining -= kLongest;
+    }
+
+    return static_cast<uint32_t>(remaining);
+  }
+
+  void MacroWriter::key(std::chrono::nanoseconds delay, const KeyEventData& data) {
+    auto rest = split(delay);
+    entries.push_back(MacroRecord::fromKeyboard(data, rest));
+  }
+
+  void MacroWriter::mouse(std::chrono::nanoseconds delay, const MouseEventData& data) {
+    auto rest = split(delay);
+    entries.push_back(MacroRecord::fromMouse(data, rest));
+  }
+
+  std::span<const MacroRecord> MacroWriter::records() const {
+    return entries;
+  }
+
+  bool MacroWriter::save(const char* path) const {
+    MacroHeader header{};
+    std::memcpy(header.magic, kMacroMagic, sizeof(header.magic));
+    header.version    = kMacroVersion;
+    header.recordSize = sizeof(MacroRecord);
+    header.count      = entries.size();
+
+    auto* file = std::fopen(path, "wb");
+    if (!file)
+      return false;
+
+    auto written = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   std::fwrite(entries.data(), sizeof(MacroRecord), entries.size(), file) == entries.size();
+    return std::fclose(file) == 0 && written;
+  }
+
+  MacroFile::MacroFile(const char* path) {
+#if defined(SIMULAR_WINDOWS_PLATFORM)
+    auto file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+      return;
+
+    // The view keeps the file alive, so neither handle is needed once it is mapped.
+    LARGE_INTEGER size{};
+    if (GetFileSizeEx(file, &size) && size.QuadPart >= static_cast<LONGLONG>(sizeof(MacroHeader))) {
+      if (auto section = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr)) {
+        if (auto* view = MapViewOfFile(section, FILE_MAP_READ, 0, 0, 0)) {
+          mapping = view;
+          length  = static_cast<std::size_t>(size.QuadPart);
+        }
+        CloseHandle(section);
+      }
+    }
+    CloseHandle(file);
+#elif defined(SIMULAR_POSIX_PLATFORM)
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+      return;
+
+    // The mapping keeps the file alive, so the descriptor is not needed once it is mapped.
+    auto size = lseek(fd, 0, SEEK_END);
+    if (size >= static_cast<off_t>(sizeof(MacroHeader))) {
+      auto* view = mmap(nullptr, static_cast<std::size_t>(size), PROT_READ, MAP_PRIVATE, fd, 0);
+      if (view != MAP_FAILED) {
+        mapping = view;
+        length  = static_cast<std::size_t>(size);
+      }
+    }
+    close(fd);
+#else
+    static_cast<void>(path);
+#endif
+
+    // Only trust macros of this layout that are as long as they claim, and whose every record
+    // could have been written by a MacroWriter.
+    auto* header = static_cast<const MacroHeader*>(mapping);
+    if (header &&
+        std::memcmp(header->magic, kMacroMagic, sizeof(header->magic)) == 0 &&
+        header->version == kMacroVersion &&
+        header->recordSize == sizeof(MacroRecord) &&
+        header->count <= (length - sizeof(MacroHeader)) / sizeof(MacroRecord)) {
+      auto* first = reinterpret_cast<const MacroRecord*>(header + 1);
+      auto* last  = first + header->count;
+      if (std::all_of(first, last, detail::validEvent)) {
+        entries = first;
+        count   = static_cast<std::size_t>(header->count);
+      }
+    }
+  }
+
+  MacroFile::~MacroFile() {
+    if (!mapping)
+      return;
+#if defined(SIMULAR_WINDOWS_PLATFORM)
+    UnmapViewOfFile(mapping);
+#elif defined(SIMULAR_POSIX_PLATFORM)
+    munmap(const_cast<void*>(mapping), length);
+#endif
+  }
+
+  bool MacroFile::valid() const {
+    return entries != nullptr;
+  }
+
+  std::span<const MacroRecord> MacroFile::records() const {
+    return std::span(entries, count);
+  }
+
+  std::size_t replayMacro(Injector& injector, HandleID injectee, std::span<const MacroRecord> records) {
+    // Records are already in the form the injector takes, so only the waits need leaving out.
+    auto accepted = injector.injectEvents(injectee, records);
+    return static_cast<std::size_t>(std::count_if(records.begin(), records.begin() + accepted, [](const MacroRecord& record) {
+      return record.kind != MacroRecord::Kind::Wait;
+    }));
+  }
+}
@@ -0,0 +1,143 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <reminput/reminput.hpp>
+#include "config.hpp"
+#include "context.hpp"
+#include "pacing.hpp"
+
+namespace simular::reminput::detail {
+  // The budget of the process: the time between events and how far ahead of it a burst may run,
+  // zero when there is no limit, and when the next event is due. The due time is the only thing
+  // injecting threads write, so it gets a cache line of its own.
+  static std::atomic<int64_t>  globalInterval{0};
+  static std::atomic<int64_t>  globalTolerance{0};
+  static std::atomic<uint32_t> globalBurst{0};
+  alignas(SIMULAR_PROCESSOR_CACHE_LINE_SIZE) static std::atomic<int64_t> globalDue{0};
+
+  // Reads the steady clock in nanoseconds.
+  static int64_t steadyNow() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()
+    ).count();
+  }
+
+  // Sleeps until the given steady clock time, in nanoseconds.
+  static void sleepUntilNanoseconds(int64_t at) {
+    sleepUntil(std::chrono::steady_clock::time_point(
+      std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::nanoseconds(at))
+    ));
+  }
+
+  // Works out the time between events for a rate, and how far ahead of it a burst may run.
+  static void budgetOf(uint32_t rate, uint32_t burst, int64_t& interval, int64_t& tolerance) {
+    interval  = rate ? std::max<int64_t>(1000000000 / rate, 1) : 0;
+    tolerance = interval * (std::max<uint32_t>(burst, 1) - 1);
+  }
+
+  // Returns when the last of the events fits a budget whose next event is due at the given time.
+  static int64_t fitsAt(int64_t due, int64_t now, std::size_t count, int64_t interval, int64_t tolerance) {
+    return std::max(due, now) + static_cast<int64_t>(count) * interval - interval - tolerance;
+  }
+
+  void configurePacing(Context& context, const PacingOptions& options) {
+    context.pacing = options;
+    budgetOf(options.rate, options.burst, context.pacingInterval, context.pacingTolerance);
+    for (auto& [injectee, state] : context.injectees)
+      state.pacedUntil = 0;
+  }
+
+  bool pacingEnabled(const Context& context) {
+    return context.pacingInterval || globalInterval.load(std::memory_order_relaxed);
+  }
+
+  std::size_t pacingPiece(const Context& context) {
+    auto piece = std::numeric_limits<std::size_t>::max();
+    if (context.pacingInterval)
+      piece = std::max<uint32_t>(context.pacing.burst, 1);
+    if (globalInterval.load(std::memory_order_relaxed))
+      piece = std::min<std::size_t>(piece, std::max<uint32_t>(globalBurst.load(std::memory_order_relaxed), 1));
+    return piece;
+  }
+
+  bool pacingWouldWait(const Context& context, const InjecteeState& state, std::size_t count) {
+    auto now = steadyNow();
+    if (context.pacingInterval &&
+        fitsAt(state.pacedUntil, now, count, context.pacingInterval, context.pacingTolerance) > now)
+      return true;
+
+    auto interval = globalInterval.load(std::memory_order_relaxed);
+    return interval &&
+      fitsAt(globalDue.load(std::memory_order_relaxed), now, count, interval, globalTolerance.load(std::memory_order_relaxed)) > now;
+  }
+
+  // Takes room for the events from the budget of the process, returning when they fit it.
+  static int64_t reserveGlobally(int64_t now, std::size_t count) {
+    auto interval = globalInterval.load(std::memory_order_relaxed);
+    if (!interval)
+      return now;
+
+    // Room is taken by moving the due time past the events, so it is never handed out twice.
+    auto due  = globalDue.load(std::memory_order_relaxed);
+    auto next = int64_t{0};
+    do {
+      next = std::max(due, now) + static_cast<int64_t>(count) * interval;
+    } while (!globalDue.compare_exchange_weak(due, next, std::memory_order_relaxed));
+    return next - interval - globalTolerance.load(std::memory_order_relaxed);
+  }
+
+  void pace(Context& context, InjecteeState& state, std::size_t count) {
+    auto now     = steadyNow();
+    auto fitsAll = reserveGlobally(now, count);
+    if (context.pacingInterval) {
+      fitsAll          = std::max(fitsAll, fitsAt(state.pacedUntil, now, count, context.pacingInterval, context.pacingTolerance));
+      state.pacedUntil = std::max(state.pacedUntil, now) + static_cast<int64_t>(count) * context.pacingInterval;
+    }
+    if (fitsAll <= now)
+      return;
+
+    context.pacingStatistics.throttled++;
+    context.pacingStatistics.delayed += std::chrono::nanoseconds(fitsAll - now);
+    sleepUntilNanoseconds(fitsAll);
+  }
+
+  void paceGlobally(std::size_t count) {
+    auto now     = steadyNow();
+    auto fitsAll = reserveGlobally(now, count);
+    if (fitsAll > now)
+      sleepUntilNanoseconds(fitsAll);
+  }
+}
+
+namespace simular::reminput {
+  void setGlobalPacing(uint32_t rate, uint32_t burst) {
+    int64_t interval, tolerance;
+    detail::budgetOf(rate, burst, interval, tolerance);
+    detail::globalTolerance.store(tolerance, std::memory_order_relaxed);
+    detail::globalBurst.store(burst, std::memory_order_relaxed);
+    detail::globalDue.store(0, std::memory_order_relaxed);
+    detail::globalInterval.store(interval, std::memory_order_relaxed);
+  }
+}
@@ -0,0 +1,84 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/**
+ * \file
+ * \brief   Holds injections back to the budgets set for each injectee and for the process.
+ * \details Budgets are kept as the time the next event is due, as in the generic cell rate
+ *          algorithm, so a budget is a single number to update. Those of injectees live in the
+ *          context, used by one thread at a time, and the one of the process in an atomic.
+ */
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <reminput/reminput.hpp>
+#include "context.hpp"
+
+namespace simular::reminput::detail {
+  /**
+   * \brief         Sets the budget every injectee of a context gets, starting each afresh.
+   * \param[in,out] context The context to pace.
+   * \param[in]     options The budget.
+   */
+  void configurePacing(Context& context, const PacingOptions& options);
+
+  /**
+   * \brief     Checks whether injections through the context are paced at all.
+   * \param[in] context The context about to inject.
+   */
+  bool pacingEnabled(const Context& context);
+
+  /**
+   * \brief     Returns the most events to submit at once, so that batches do not burst past a budget.
+   * \param[in] context The context about to inject.
+   */
+  std::size_t pacingPiece(const Context& context);
+
+  /**
+   * \brief     Checks whether submitting events now would have to wait, without using up any budget.
+   * \param[in] context The context about to inject.
+   * \param[in] state What the context remembers about the injectee.
+   * \param[in] count The number of events.
+   */
+  bool pacingWouldWait(const Context& context, const InjecteeState& state, std::size_t count);
+
+  /**
+   * \brief         Takes room for events from the budgets of the injectee and of the process,
+   *                waiting until there is enough.
+   * \param[in,out] context The context about to inject, whose counters note any wait.
+   * \param[in,out] state What the context remembers about the injectee.
+   * \param[in]     count The number of events.
+   */
+  void pace(Context& context, InjecteeState& state, std::size_t count);
+
+  /**
+   * \brief     Takes room for events from the budget of the process only, waiting until there is enough.
+   * \param[in] count The number of events.
+   */
+  void paceGlobally(std::size_t count);
+
+  /**
+   * \brief     Sleeps on the most precise timer the platform has, possibly waking a little late.
+   * \details   Defined alongside the scheduler, which waits on it too.
+   * \param[in] target When to wake.
+   */
+  void sleepUntil(std::chrono::steady_clock::time_point target);
+}
@@ -0,0 +1,93 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <new>
+#include <reminput/profiling.hpp>
+#include "profiling.hpp"
+
+namespace simular::reminput::detail {
+  // Every record ever made. Records are never freed, only handed to new threads.
+  static std::atomic<ThreadProfile*> profiles{nullptr};
+
+  // Marks the record of a thread as free for adoption when the thread exits.
+  struct ThreadProfileOwner final {
+    ThreadProfile* profile = nullptr;
+
+    ~ThreadProfileOwner() {
+      if (profile)
+        profile->active.store(false, std::memory_order_release);
+    }
+  };
+
+  // Where a thread records when no record could be allocated for it. It is never snapshot, so
+  // what lands in it is dropped rather than thrown from the noexcept paths being timed.
+  static ThreadProfile discarded;
+
+  // Adopts a record left by an exited thread, or registers a new one, returning null if memory ran out.
+  static ThreadProfile* claimProfile() noexcept {
+    for (auto* profile = profiles.load(std::memory_order_acquire); profile; profile = profile->next) {
+      auto active = false;
+      if (profile->active.compare_exchange_strong(active, true, std::memory_order_acq_rel))
+        return profile;
+    }
+
+    auto* profile = new (std::nothrow) ThreadProfile();
+    if (!profile)
+      return nullptr;
+    profile->next = profiles.load(std::memory_order_relaxed);
+    while (!profiles.compare_exchange_weak(profile->next, profile, std::memory_order_release, std::memory_order_relaxed));
+    return profile;
+  }
+
+  ThreadProfile& threadProfile() noexcept {
+    thread_local ThreadProfileOwner owner;
+    if (!owner.profile)
+      owner.profile = claimProfile();
+    return owner.profile ? *owner.profile : discarded;
+  }
+}
+
+namespace simular::reminput {
+  ProfileSnapshot profileSnapshot() {
+    ProfileSnapshot snapshot;
+    for (auto* profile = detail::profiles.load(std::memory_order_acquire); profile; profile = profile->next) {
+      for (std::size_t stage = 0; stage < kProfileStageCount; stage++) {
+        for (std::size_t bucket = 0; bucket < LatencyHistogram::kBucketCount; bucket++)
+          snapshot.stages[stage].counts[bucket] += profile->stages[stage][bucket].load(std::memory_order_relaxed);
+      }
+      snapshot.requested += profile->requested.load(std::memory_order_relaxed);
+      snapshot.accepted  += profile->accepted.load(std::memory_order_relaxed);
+    }
+
+    return snapshot;
+  }
+
+  void resetProfile() {
+    for (auto* profile = detail::profiles.load(std::memory_order_acquire); profile; profile = profile->next) {
+      for (auto& stage : profile->stages) {
+        for (auto& bucket : stage)
+          bucket.store(0, std::memory_order_relaxed);
+      }
+      profile->requested.store(0, std::memory_order_relaxed);
+      profile->accepted.store(0, std::memory_order_relaxed);
+    }
+  }
+}
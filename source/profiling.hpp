@@ -0,0 +1,106 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/**
+ * \file
+ * \brief   The instrumentation points used inside the library.
+ * \details These expand to nothing unless the library is built with `BUILD_PROFILING`.
+ */
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <reminput/profiling.hpp>
+#include "config.hpp"
+
+namespace simular::reminput::detail {
+  /**
+   * \brief   What a single thread has recorded.
+   * \details Only the owning thread writes, so updates are plain loads and stores of atomics
+   *          rather than read-modify-writes, and snapshots can still read them safely. Records
+   *          outlive their thread and are adopted by later threads.
+   */
+  struct alignas(SIMULAR_PROCESSOR_CACHE_LINE_SIZE) ThreadProfile final {
+    std::array<std::array<std::atomic<uint64_t>, LatencyHistogram::kBucketCount>, kProfileStageCount> stages{};
+    std::atomic<uint64_t> requested{0};
+    std::atomic<uint64_t> accepted{0};
+    std::atomic<bool>     active{true};
+    ThreadProfile*        next = nullptr;
+  };
+
+  /**
+   * \brief   Returns the record of the calling thread, registering one on first use.
+   * \details Never throws, since it runs inside noexcept injections and destructors. If no record
+   *          can be allocated, what the thread records is dropped and registering is tried again
+   *          on its next use.
+   */
+  ThreadProfile& threadProfile() noexcept;
+
+  // Adds to a counter that only the calling thread writes.
+  inline void bump(std::atomic<uint64_t>& counter, uint64_t amount) {
+    counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+  }
+
+  /**
+   * \brief   Times the enclosing scope as a stage.
+   */
+  class StageTimer final {
+  public:
+    explicit StageTimer(ProfileStage stage)
+      : stage(stage), start(std::chrono::steady_clock::now()) {}
+
+    ~StageTimer() {
+      auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+      auto bucket  = LatencyHistogram::bucketOf(static_cast<uint64_t>(elapsed.count()));
+      bump(threadProfile().stages[static_cast<std::size_t>(stage)][bucket], 1);
+    }
+
+    StageTimer(const StageTimer&) = delete;
+    StageTimer& operator=(const StageTimer&) = delete;
+
+  private:
+    ProfileStage                          stage;
+    std::chrono::steady_clock::time_point start;
+  };
+
+  /**
+   * \brief   Counts events asked for and events accepted.
+   */
+  inline void countEvents(std::size_t requested, std::size_t accepted) {
+    auto& profile = threadProfile();
+    bump(profile.requested, requested);
+    bump(profile.accepted, accepted);
+  }
+}
+
+#if defined(REMINPUT_PROFILING)
+#  define REMINPUT_PROFILE_CONCAT_INNER(a, b) a##b
+#  define REMINPUT_PROFILE_CONCAT(a, b) REMINPUT_PROFILE_CONCAT_INNER(a, b)
+#  define REMINPUT_PROFILE_STAGE(stage) \
+     ::simular::reminput::detail::StageTimer REMINPUT_PROFILE_CONCAT(stageTimer, __LINE__)(::simular::reminput::ProfileStage::stage)
+#  define REMINPUT_PROFILE_COUNT(requested, accepted) \
+     ::simular::reminput::detail::countEvents(requested, accepted)
+#else
+#  define REMINPUT_PROFILE_STAGE(stage)
+#  define REMINPUT_PROFILE_COUNT(requested, accepted)
+#endif
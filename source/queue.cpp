@@ -0,0 +1,298 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <reminput/queue.hpp>
+#include "backend.hpp"
+#include "context.hpp"
+#include "profiling.hpp"
+#include "config.hpp"
+
+namespace simular::reminput {
+  // The most events the dispatcher hands to the backend at once.
+  constexpr std::size_t kDispatchBatchSize = 256;
+
+  // A bounded multi-producer ring, after Dmitry Vyukov's design. Each cell carries a sequence that
+  // tells producers and consumers whose turn it is, so neither side ever takes a lock. Producers
+  // may also consume, which is how the drop oldest policy makes room.
+  struct AsyncInjector::Queue {
+    struct Cell {
+      std::atomic<uint64_t> sequence;
+      QueuedEvent           event;
+    };
+
+    Queue(std::size_t capacity, QueuePolicy policy)
+      : cells(std::make_unique<Cell[]>(capacity)), mask(capacity - 1), policy(policy) {
+      for (std::size_t index = 0; index < capacity; index++)
+        cells[index].sequence.store(index, std::memory_order_relaxed);
+    }
+
+    // Claims the next free cell and publishes the event into it, failing if the ring is full.
+    bool tryPush(const QueuedEvent& event) {
+      auto position = enqueuePosition.load(std::memory_order_relaxed);
+      while (true) {
+        auto& cell      = cells[position & mask];
+        auto sequence   = cell.sequence.load(std::memory_order_acquire);
+        auto difference = static_cast<int64_t>(sequence - position);
+        if (difference == 0) {
+          if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+            cell.event = event;
+            cell.sequence.store(position + 1, std::memory_order_release);
+            return true;
+          }
+        } else if (difference < 0) {
+          return false;
+        } else {
+          position = enqueuePosition.load(std::memory_order_relaxed);
+        }
+      }
+    }
+
+    // Takes the oldest published event, failing if there is none.
+    bool tryPop(QueuedEvent& event) {
+      auto position = dequeuePosition.load(std::memory_order_relaxed);
+      while (true) {
+        auto& cell      = cells[position & mask];
+        auto sequence   = cell.sequence.load(std::memory_order_acquire);
+        auto difference = static_cast<int64_t>(sequence - (position + 1));
+        if (difference == 0) {
+          if (dequeuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+            event = cell.event;
+            cell.sequence.store(position + mask + 1, std::memory_order_release);
+            return true;
+          }
+        } else if (difference < 0) {
+          return false;
+        } else {
+          position = dequeuePosition.load(std::memory_order_relaxed);
+        }
+      }
+    }
+
+    // Enqueues following the policy for a full ring.
+    bool push(const QueuedEvent& event) {
+      while (true) {
+        // Read the epoch first, so a batch freed after a failed attempt is never missed.
+        auto epoch = freedEpoch.load(std::memory_order_acquire);
+        if (tryPush(event))
+          break;
+
+        QueuedEvent oldest;
+        switch (policy) {
+        case QueuePolicy::Fail:
+          dropped.fetch_add(1, std::memory_order_relaxed);
+          return false;
+        case QueuePolicy::DropOldest:
+          if (tryPop(oldest)) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            complete(1);
+          }
+          break;
+        case QueuePolicy::Block:
+          freedEpoch.wait(epoch, std::memory_order_acquire);
+          break;
+        }
+      }
+
+      notifyDispatcher();
+      return true;
+    }
+
+    // Checks whether the oldest event has been published.
+    bool hasPublished() const {
+      auto position = dequeuePosition.load(std::memory_order_relaxed);
+      return cells[position & mask].sequence.load(std::memory_order_acquire) == position + 1;
+    }
+
+    // Wakes the dispatcher if it went to sleep before seeing what was just changed. The fence
+    // pairs with the one the dispatcher issues after announcing its sleep.
+    void notifyDispatcher() {
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (sleeping.load(std::memory_order_relaxed)) {
+        sleeping.store(false, std::memory_order_relaxed);
+        sleeping.notify_one();
+      }
+    }
+
+    // Marks events as handled, releasing anyone flushing.
+    void complete(uint64_t count) {
+      completed.fetch_add(count, std::memory_order_release);
+      completed.notify_all();
+    }
+
+    // Submits a run of events that share an injectee and kind.
+    void submit(std::span<const QueuedEvent> run) {
+      auto injectee = run.front().injectee;
+      auto found    = context.injectees.find(injectee);
+      auto known    = found != context.injectees.end() || detail::makeInjecteeRoom(context);
+      auto& state   = context.injectees[injectee];
+      auto accepted = std::size_t{0};
+      auto valid    = false;
+      auto merged   = context.coalescedMoves;
+      if (known) {
+        REMINPUT_PROFILE_STAGE(Validate);
+        valid = detail::checkInjectee(state, injectee);
+      }
+      if (valid) {
+        if (run.front().data.kind == InputEvent::Kind::Keyboard) {
+          keyboardScratch.clear();
+          for (const auto& event : run)
+            keyboardScratch.push_back(event.data.keyboard());
+          accepted = detail::dispatchKeyboardEvents(context, state, injectee, keyboardScratch);
+        } else {
+          mouseScratch.clear();
+          for (const auto& event : run)
+            mouseScratch.push_back(event.data.mouse());
+          accepted = detail::dispatchMouseEvents(context, state, injectee, mouseScratch);
+        }
+      }
+
+      if (!valid)
+        context.injectees.erase(injectee);
+
+      // Moves replaced by a newer one were never injected, so they are not counted as submitted.
+      merged = context.coalescedMoves - merged;
+      REMINPUT_PROFILE_COUNT(run.size(), accepted);
+      submitted.fetch_add(accepted - merged, std::memory_order_relaxed);
+      failed.fetch_add(run.size() - accepted, std::memory_order_relaxed);
+      if (merged)
+        coalesced.fetch_add(merged, std::memory_order_relaxed);
+    }
+
+    // Splits a drained batch into runs the backend can take in one call each.
+    void dispatch(std::span<const QueuedEvent> batch) {
+      context.coalesceMoves = coalesceMoves.load(std::memory_order_relaxed);
+      for (std::size_t begin = 0; begin < batch.size();) {
+        auto end = begin + 1;
+        while (end < batch.size() && batch[end].injectee == batch[begin].injectee &&
+               batch[end].data.kind == batch[begin].data.kind)
+          end++;
+        submit(batch.subspan(begin, end - begin));
+        begin = end;
+      }
+    }
+
+    // The dispatcher thread, which drains the ring until stopped and empty.
+    void run() {
+      std::vector<QueuedEvent> batch;
+      batch.reserve(kDispatchBatchSize);
+      keyboardScratch.reserve(kDispatchBatchSize);
+      mouseScratch.reserve(kDispatchBatchSize);
+
+      while (true) {
+        QueuedEvent event;
+        batch.clear();
+        while (batch.size() < kDispatchBatchSize && tryPop(event))
+          batch.push_back(event);
+
+        if (!batch.empty()) {
+          // Let blocked producers retry before the slow part.
+          freedEpoch.fetch_add(1, std::memory_order_release);
+          freedEpoch.notify_all();
+          dispatch(batch);
+          complete(batch.size());
+          continue;
+        }
+
+        if (stopping.load(std::memory_order_acquire))
+          break;
+
+        // Announce the sleep, then look once more so a producer that missed it is not stranded.
+        sleeping.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!hasPublished() && !stopping.load(std::memory_order_relaxed))
+          sleeping.wait(true, std::memory_order_acquire);
+        sleeping.store(false, std::memory_order_relaxed);
+      }
+    }
+
+    std::unique_ptr<Cell[]> cells;
+    std::size_t             mask;
+    QueuePolicy             policy;
+
+    // Positions are kept on their own cache lines, since producers and the dispatcher hammer them.
+    alignas(SIMULAR_PROCESSOR_CACHE_LINE_SIZE) std::atomic<uint64_t> enqueuePosition{0};
+    alignas(SIMULAR_PROCESSOR_CACHE_LINE_SIZE) std::atomic<uint64_t> dequeuePosition{0};
+    alignas(SIMULAR_PROCESSOR_CACHE_LINE_SIZE) std::atomic<uint64_t> completed{0};
+    std::atomic<uint64_t> freedEpoch{0};
+    std::atomic<bool>     sleeping{false};
+    std::atomic<bool>     stopping{false};
+
+    // Counters, mostly written by the dispatcher.
+    alignas(SIMULAR_PROCESSOR_CACHE_LINE_SIZE) std::atomic<uint64_t> submitted{0};
+    std::atomic<uint64_t> failed{0};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<uint64_t> coalesced{0};
+    std::atomic<bool>     coalesceMoves{false};
+
+    // Only touched by the dispatcher.
+    detail::Context             context;
+    std::vector<KeyEventData>   keyboardScratch;
+    std::vector<MouseEventData> mouseScratch;
+    std::thread                 dispatcher;
+  };
+
+  AsyncInjector::AsyncInjector(std::size_t capacity, QueuePolicy policy)
+    : queue(std::make_unique<Queue>(std::bit_ceil(std::max<std::size_t>(capacity, 2)), policy)) {
+    queue->dispatcher = std::thread([this] { queue->run(); });
+  }
+
+  AsyncInjector::~AsyncInjector() {
+    queue->stopping.store(true, std::memory_order_relaxed);
+    queue->notifyDispatcher();
+    queue->dispatcher.join();
+  }
+
+  bool AsyncInjector::enqueue(HandleID injectee, const KeyEventData& data) {
+    return queue->push(QueuedEvent { .injectee = injectee, .data = InputEvent::fromKeyboard(data) });
+  }
+
+  bool AsyncInjector::enqueue(HandleID injectee, const MouseEventData& data) {
+    return queue->push(QueuedEvent { .injectee = injectee, .data = InputEvent::fromMouse(data) });
+  }
+
+  void AsyncInjector::setMoveCoalescing(bool enabled) {
+    queue->coalesceMoves.store(enabled, std::memory_order_relaxed);
+  }
+
+  void AsyncInjector::flush() {
+    auto target = queue->enqueuePosition.load(std::memory_order_acquire);
+    auto done   = queue->completed.load(std::memory_order_acquire);
+    while (done < target) {
+      queue->completed.wait(done, std::memory_order_acquire);
+      done = queue->completed.load(std::memory_order_acquire);
+    }
+  }
+
+  AsyncStatistics AsyncInjector::statistics() const {
+    return AsyncStatistics {
+      .submitted = queue->submitted.load(std::memory_order_relaxed),
+      .failed    = queue->failed.load(std::memory_order_relaxed),
+      .dropped   = queue->dropped.load(std::memory_order_relaxed),
+      .coalesced = queue->coalesced.load(std::memory_order_relaxed),
+    };
+  }
+}
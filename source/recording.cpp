@@ -0,0 +1,346 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <vector>
+#include <reminput/recording.hpp>
+#include "config.hpp"
+#include "context.hpp"
+#include "recording.hpp"
+#if defined(SIMULAR_POSIX_PLATFORM)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace simular::reminput::detail {
+  // Identifies a log and the layout of its records.
+  constexpr char     kRecordingMagic[8] = {'R', 'E', 'M', 'I', 'N', 'L', 'O', 'G'};
+  constexpr uint32_t kRecordingVersion  = 1;
+
+  // Sits at the front of the log, followed by the ring of records.
+  struct alignas(64) RecordingHeader final {
+    char     magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+    uint64_t capacity;
+    uint64_t position;
+  };
+  static_assert(sizeof(RecordingHeader) == 64);
+
+  struct Recorder final {
+    RecordingHeader* header;
+    RecordedEvent*   records;
+    std::size_t      length;
+    uint64_t         mask;
+    std::chrono::steady_clock::time_point started;
+  };
+
+  // The log injections are diverted into, if any.
+  static std::atomic<Recorder*> recorder{nullptr};
+
+  // Logs that were stopped, unmapped only at exit since a thread may still be appending to them.
+  static std::mutex             retiredMutex;
+  static std::vector<Recorder*> retired;
+
+  Recorder* activeRecorder() {
+    return recorder.load(std::memory_order_acquire);
+  }
+
+  // Claims the next records in the ring for a batch, returning the position of the first.
+  static uint64_t claimRecords(Recorder& log, std::size_t count) {
+    return std::atomic_ref(log.header->position).fetch_add(count, std::memory_order_relaxed);
+  }
+
+  // Marks a record as being written before any of it is overwritten, so a reader that copies it
+  // meanwhile finds the sequence changed. The fence keeps the fields from being written first.
+  static void beginRecord(RecordedEvent& record) {
+    std::atomic_ref(record.sequence).store(0, std::memory_order_release);
+    std::atomic_thread_fence(std::memory_order_release);
+  }
+
+  // Publishes a filled record, so readers can tell it from one still being written.
+  static void publishRecord(RecordedEvent& record, uint64_t position) {
+    std::atomic_ref(record.sequence).store(position + 1, std::memory_order_release);
+  }
+
+  // Returns the nanoseconds since the log was started.
+  static uint64_t recordingTime(const Recorder& log) {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - log.started
+    ).count());
+  }
+
+  std::size_t recordKeyboardEvents(Recorder& log, HandleID injectee, std::span<const KeyEventData> data) {
+    auto position  = claimRecords(log, data.size());
+    auto timestamp = recordingTime(log);
+    for (const auto& event : data) {
+      auto& record = log.records[position & log.mask];
+      beginRecord(record);
+      record.timestamp = timestamp;
+      record.injectee  = reinterpret_cast<uintptr_t>(injectee);
+      record.xpos      = 0;
+      record.ypos      = 0;
+      record.kind      = RecordedEvent::Kind::Keyboard;
+      record.code      = static_cast<uint8_t>(event.key);
+      record.state     = static_cast<uint8_t>(event.state);
+      record.scrolldy  = 0;
+      record.reserved  = 0;
+      publishRecord(record, position++);
+    }
+
+    return data.size();
+  }
+
+  std::size_t recordMouseEvents(Recorder& log, HandleID injectee, std::span<const MouseEventData> data) {
+    auto position  = claimRecords(log, data.size());
+    auto timestamp = recordingTime(log);
+    for (const auto& event : data) {
+      auto& record = log.records[position & log.mask];
+      beginRecord(record);
+      record.timestamp = timestamp;
+      record.injectee  = reinterpret_cast<uintptr_t>(injectee);
+      record.xpos      = event.xpos;
+      record.ypos      = event.ypos;
+      record.kind      = RecordedEvent::Kind::Mouse;
+      record.code      = static_cast<uint8_t>(event.button);
+      record.state     = static_cast<uint8_t>(event.state);
+      record.scrolldy  = event.scrolldy;
+      record.reserved  = 0;
+      publishRecord(record, position++);
+    }
+
+    return data.size();
+  }
+
+  std::size_t recordMotionEvents(Recorder& log, HandleID injectee, std::span<const MouseMotionData> data) {
+    auto position  = claimRecords(log, data.size());
+    auto timestamp = recordingTime(log);
+    for (const auto& motion : data) {
+      auto& record = log.records[position & log.mask];
+      beginRecord(record);
+      record.timestamp = timestamp;
+      record.injectee  = reinterpret_cast<uintptr_t>(injectee);
+      record.xpos      = motion.dx;
+      record.ypos      = motion.dy;
+      record.kind      = RecordedEvent::Kind::Motion;
+      record.code      = static_cast<uint8_t>(motion.button);
+      record.state     = static_cast<uint8_t>(motion.state);
+      record.scrolldy  = motion.scrolldy;
+      record.reserved  = 0;
+      publishRecord(record, position++);
+    }
+
+    return data.size();
+  }
+
+  std::size_t recordTextEvents(Recorder& log, HandleID injectee, std::span<const TextStroke> data) {
+    auto position  = claimRecords(log, data.size());
+    auto timestamp = recordingTime(log);
+    for (const auto& stroke : data) {
+      auto& record = log.records[position & log.mask];
+      beginRecord(record);
+      record.timestamp = timestamp;
+      record.injectee  = reinterpret_cast<uintptr_t>(injectee);
+      record.xpos      = static_cast<int32_t>(stroke.unicode);
+      record.ypos      = 0;
+      record.kind      = stroke.unicode ? RecordedEvent::Kind::Unicode : RecordedEvent::Kind::Keyboard;
+      record.code      = static_cast<uint8_t>(stroke.key.key);
+      record.state     = static_cast<uint8_t>(stroke.key.state);
+      record.scrolldy  = 0;
+      record.reserved  = 0;
+      publishRecord(record, position++);
+    }
+
+    return data.size();
+  }
+
+  // Unmaps every retired log when the process exits.
+  static struct RetiredRecorders final {
+    ~RetiredRecorders() {
+      std::lock_guard lock(retiredMutex);
+      for (auto* log : retired) {
+#if defined(SIMULAR_POSIX_PLATFORM)
+        munmap(log->header, log->length);
+#endif
+        delete log;
+      }
+      retired.clear();
+    }
+  } retiredRecorders;
+
+  // Starts recording into the log named by the environment, if any.
+  static struct EnvironmentRecording final {
+    EnvironmentRecording() {
+      if (const char* path = std::getenv("REMINPUT_RECORD"); path && *path)
+        startRecording(RecordingOptions{.path = path});
+    }
+  } environmentRecording;
+}
+
+namespace simular::reminput {
+  bool startRecording(const RecordingOptions& options) {
+    stopRecording();
+#if defined(SIMULAR_POSIX_PLATFORM)
+    // Size the ring to a power of two so positions wrap with a mask.
+    auto capacity = std::bit_ceil(options.capacity ? options.capacity : std::size_t{1});
+    auto length   = sizeof(detail::RecordingHeader) + capacity * sizeof(RecordedEvent);
+
+    int fd = open(options.path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+      return false;
+
+    // The mapping keeps the file alive, so the descriptor is only needed to size it.
+    void* mapping = MAP_FAILED;
+    if (ftruncate(fd, static_cast<off_t>(length)) == 0)
+      mapping = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+      return false;
+
+    auto* header = static_cast<detail::RecordingHeader*>(mapping);
+    std::memcpy(header->magic, detail::kRecordingMagic, sizeof(header->magic));
+    header->version    = detail::kRecordingVersion;
+    header->recordSize = sizeof(RecordedEvent);
+    header->capacity   = capacity;
+    header->position   = 0;
+
+    auto* log = new detail::Recorder{
+      .header  = header,
+      .records = reinterpret_cast<RecordedEvent*>(header + 1),
+      .length  = length,
+      .mask    = capacity - 1,
+      .started = std::chrono::steady_clock::now(),
+    };
+
+    // Validation means something else while recording, so drop what was cached.
+    detail::recorder.store(log, std::memory_order_release);
+    detail::staleInjectees();
+    return true;
+#else
+    static_cast<void>(options);
+    return false;
+#endif
+  }
+
+  void stopRecording() {
+    auto* log = detail::recorder.exchange(nullptr, std::memory_order_acq_rel);
+    if (!log)
+      return;
+
+#if defined(SIMULAR_POSIX_PLATFORM)
+    msync(log->header, log->length, MS_ASYNC);
+#endif
+    {
+      std::lock_guard lock(detail::retiredMutex);
+      detail::retired.push_back(log);
+    }
+    detail::staleInjectees();
+  }
+
+  bool isRecording() {
+    return detail::activeRecorder() != nullptr;
+  }
+
+  RecordingLog::RecordingLog(const char* path) {
+#if defined(SIMULAR_POSIX_PLATFORM)
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+      return;
+
+    auto size = lseek(fd, 0, SEEK_END);
+    if (size >= static_cast<off_t>(sizeof(detail::RecordingHeader))) {
+      auto* view = mmap(nullptr, static_cast<std::size_t>(size), PROT_READ, MAP_SHARED, fd, 0);
+      if (view != MAP_FAILED) {
+        mapping = view;
+        length  = static_cast<std::size_t>(size);
+      }
+    }
+    close(fd);
+
+    // Only trust logs of this layout that are as long as they claim.
+    auto* header = static_cast<const detail::RecordingHeader*>(mapping);
+    if (header &&
+        std::memcmp(header->magic, detail::kRecordingMagic, sizeof(header->magic)) == 0 &&
+        header->version == detail::kRecordingVersion &&
+        header->recordSize == sizeof(RecordedEvent) &&
+        std::has_single_bit(header->capacity) &&
+        header->capacity <= (length - sizeof(detail::RecordingHeader)) / sizeof(RecordedEvent))
+      records = reinterpret_cast<const RecordedEvent*>(header + 1);
+#else
+    static_cast<void>(path);
+#endif
+  }
+
+  RecordingLog::~RecordingLog() {
+#if defined(SIMULAR_POSIX_PLATFORM)
+    if (mapping)
+      munmap(const_cast<void*>(mapping), length);
+#endif
+  }
+
+  bool RecordingLog::valid() const {
+    return records != nullptr;
+  }
+
+  uint64_t RecordingLog::appended() const {
+    if (!records)
+      return 0;
+    auto* header = static_cast<const detail::RecordingHeader*>(mapping);
+    return std::atomic_ref(const_cast<uint64_t&>(header->position)).load(std::memory_order_acquire);
+  }
+
+  std::size_t RecordingLog::size() const {
+    auto* header = static_cast<const detail::RecordingHeader*>(mapping);
+    return records ? static_cast<std::size_t>(std::min(appended(), header->capacity)) : 0;
+  }
+
+  const RecordedEvent& RecordingLog::operator[](std::size_t index) const {
+    // Records older than one ring behind the newest have been overwritten.
+    auto* header = static_cast<const detail::RecordingHeader*>(mapping);
+    auto  newest = appended();
+    auto  oldest = newest - std::min(newest, header->capacity);
+    return records[(oldest + index) & (header->capacity - 1)];
+  }
+
+  bool RecordingLog::read(std::size_t index, RecordedEvent& event) const {
+    if (!records)
+      return false;
+    auto* header   = static_cast<const detail::RecordingHeader*>(mapping);
+    auto  newest   = appended();
+    auto  position = newest - std::min(newest, header->capacity) + index;
+    auto& record   = records[position & (header->capacity - 1)];
+
+    // The copy is only whole if the record held this position before and after it was taken.
+    std::atomic_ref sequence(const_cast<uint64_t&>(record.sequence));
+    if (sequence.load(std::memory_order_acquire) != position + 1)
+      return false;
+    std::memcpy(&event, &record, sizeof(event));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return sequence.load(std::memory_order_relaxed) == position + 1;
+  }
+}
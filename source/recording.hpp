@@ -0,0 +1,78 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/**
+ * \file
+ * \brief   The recording sink that injections are diverted into instead of the backend.
+ */
+#pragma once
+#include <cstddef>
+#include <span>
+#include <reminput/reminput.hpp>
+#include "backend.hpp"
+
+namespace simular::reminput::detail {
+  /**
+   * \brief   A log being recorded into, defined by the recording sink.
+   */
+  struct Recorder;
+
+  /**
+   * \brief   Returns the log being recorded into, or null when injections go to the backend.
+   */
+  Recorder* activeRecorder();
+
+  /**
+   * \brief     Appends a batch of key events to the log.
+   * \param[in] recorder The log to append to.
+   * \param[in] injectee The injectee the events were sent to.
+   * \param[in] data The events to append.
+   * \return    The number of events appended, which is always all of them.
+   */
+  std::size_t recordKeyboardEvents(Recorder& recorder, HandleID injectee, std::span<const KeyEventData> data);
+
+  /**
+   * \brief     Appends a batch of mouse events to the log.
+   * \param[in] recorder The log to append to.
+   * \param[in] injectee The injectee the events were sent to.
+   * \param[in] data The events to append.
+   * \return    The number of events appended, which is always all of them.
+   */
+  std::size_t recordMouseEvents(Recorder& recorder, HandleID injectee, std::span<const MouseEventData> data);
+
+  /**
+   * \brief     Appends a batch of relative motions to the log.
+   * \param[in] recorder The log to append to.
+   * \param[in] injectee The injectee the motions were sent to.
+   * \param[in] data The motions to append, with deltas already rounded to whole pixels.
+   * \return    The number of motions appended, which is always all of them.
+   */
+  std::size_t recordMotionEvents(Recorder& recorder, HandleID injectee, std::span<const MouseMotionData> data);
+
+  /**
+   * \brief     Appends the strokes typing a text to the log.
+   * \param[in] recorder The log to append to.
+   * \param[in] injectee The injectee the strokes were sent to.
+   * \param[in] data The strokes to append.
+   * \return    The number of strokes appended, which is always all of them.
+   */
+  std::size_t recordTextEvents(Recorder& recorder, HandleID injectee, std::span<const TextStroke> data);
+}
@@ -0,0 +1,493 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
+#include <reminput/reminput.hpp>
+#include "backend.hpp"
+#include "compiled.hpp"
+#include "config.hpp"
+#include "context.hpp"
+#include "pacing.hpp"
+#include "profiling.hpp"
+#include "recording.hpp"
+#include "text.hpp"
+
+namespace simular::reminput {
+  Injector::Injector() : context(std::make_unique<detail::Context>()) {}
+  Injector::~Injector() = default;
+  Injector::Injector(Injector&&) noexcept = default;
+  Injector& Injector::operator=(Injector&&) noexcept = default;
+
+  // The most events of a mixed batch unpacked at once, so the buffers they are unpacked into stay
+  // the same small size however long the batches are.
+  constexpr std::size_t kUnpackedRunSize = 1024;
+
+  // Describes how much of a batch of the given size the platform accepted.
+  static InjectResult resultOf(std::size_t accepted, std::size_t size) noexcept {
+    if (accepted == size)
+      return InjectResult { .status = InjectStatus::Ok, .accepted = accepted };
+    return InjectResult { .status = accepted ? InjectStatus::Partial : InjectStatus::BackendFailure, .accepted = accepted };
+  }
+
+  // Turns a result back into the count the throwing functions return, throwing for a bad injectee.
+  static std::size_t unwrap(const InjectResult& result) {
+    if (result.status == InjectStatus::InvalidInjectee) {
+#if defined(SIMULAR_NO_EXCEPTIONS) || defined(SIMULAR_NO_UNWIND)
+      std::fprintf(stderr, "%s\n", detail::kInvalidInjecteeMessage);
+      std::abort();
+#else
+      throw std::runtime_error(detail::kInvalidInjecteeMessage);
+#endif
+    }
+
+    return result.accepted;
+  }
+
+  // Runs an injection for the functions that never throw. Running out of memory while growing the
+  // buffers fails the injection, and since some events may have gone out uncounted, every injectee
+  // is checked again before the next one.
+  template <typename Inject>
+  static InjectResult guarded(detail::Context& context, Inject inject) noexcept {
+#if defined(SIMULAR_NO_EXCEPTIONS) || defined(SIMULAR_NO_UNWIND)
+    (void)context;
+    return inject();
+#else
+    try {
+      return inject();
+    } catch (const std::bad_alloc&) {
+      for (auto& [injectee, state] : context.injectees)
+        detail::staleInjectee(state);
+      return InjectResult { .status = InjectStatus::BackendFailure, .accepted = 0 };
+    }
+#endif
+  }
+
+  // Checks the injectee once for a whole batch, or not at all while the last check is fresh. An
+  // injectee is only remembered once it passed, so rejecting one allocates nothing. Remembering
+  // one may throw, which `guarded` turns into a failed injection.
+  static detail::InjecteeState* checkedInjectee(detail::Context& context, HandleID injectee) {
+    REMINPUT_PROFILE_STAGE(Validate);
+    auto found = context.injectees.find(injectee);
+    if (found != context.injectees.end()) {
+      if (detail::checkInjectee(found->second, injectee))
+        return &found->second;
+      context.injectees.erase(found);
+      return nullptr;
+    }
+
+    detail::InjecteeState state;
+                          state.space = context.space;
+    if (!detail::checkInjectee(state, injectee) || !detail::makeInjecteeRoom(context))
+      return nullptr;
+    return &context.injectees.emplace(injectee, state).first->second;
+  }
+
+  void Injector::injectKeyboardEvent(HandleID injectee, const KeyEventData& data) {
+    unwrap(tryInjectKeyboardEvents(injectee, std::span(&data, 1)));
+  }
+
+  std::size_t Injector::injectKeyboardEvents(HandleID injectee, std::span<const KeyEventData> data) {
+    return unwrap(tryInjectKeyboardEvents(injectee, data));
+  }
+
+  void Injector::injectMouseEvent(HandleID injectee, const MouseEventData& data) {
+    unwrap(tryInjectMouseEvents(injectee, std::span(&data, 1)));
+  }
+
+  std::size_t Injector::injectMouseEvents(HandleID injectee, std::span<const MouseEventData> data) {
+    return unwrap(tryInjectMouseEvents(injectee, data));
+  }
+
+  void Injector::injectMouseMotion(HandleID injectee, const MouseMotionData& data) {
+    unwrap(tryInjectMouseMotions(injectee, std::span(&data, 1)));
+  }
+
+  std::size_t Injector::injectMouseMotions(HandleID injectee, std::span<const MouseMotionData> data) {
+    return unwrap(tryInjectMouseMotions(injectee, data));
+  }
+
+  std::size_t Injector::injectText(HandleID injectee, std::u8string_view text) {
+    return unwrap(tryInjectText(injectee, text));
+  }
+
+  std::size_t Injector::injectEvents(HandleID injectee, std::span<const InputEvent> data) {
+    return unwrap(tryInjectEvents(injectee, data));
+  }
+
+  std::size_t Injector::setInputState(HandleID injectee, const InputSet& desired) {
+    return unwrap(trySetInputState(injectee, desired));
+  }
+
+  std::size_t Injector::releaseAll(HandleID injectee) {
+    return unwrap(trySetInputState(injectee, InputSet{}));
+  }
+
+  std::size_t Injector::injectSequence(HandleID injectee, const CompiledSequence& sequence) {
+    return unwrap(tryInjectSequence(injectee, sequence));
+  }
+
+  InjectResult Injector::tryInjectKeyboardEvent(HandleID injectee, const KeyEventData& data) noexcept {
+    return tryInjectKeyboardEvents(injectee, std::span(&data, 1));
+  }
+
+  InjectResult Injector::tryInjectKeyboardEvents(HandleID injectee, std::span<const KeyEventData> data) noexcept {
+    return guarded(*context, [&] {
+      auto* state = checkedInjectee(*context, injectee);
+      if (!state)
+        return InjectResult { .status = InjectStatus::InvalidInjectee, .accepted = 0 };
+
+      auto accepted = detail::dispatchKeyboardEvents(*context, *state, injectee, data);
+      REMINPUT_PROFILE_COUNT(data.size(), accepted);
+      return resultOf(accepted, data.size());
+    });
+  }
+
+  InjectResult Injector::tryInjectMouseEvent(HandleID injectee, const MouseEventData& data) noexcept {
+    return tryInjectMouseEvents(injectee, std::span(&data, 1));
+  }
+
+  InjectResult Injector::tryInjectMouseEvents(HandleID injectee, std::span<const MouseEventData> data) noexcept {
+    return guarded(*context, [&] {
+      auto* state = checkedInjectee(*context, injectee);
+      if (!state)
+        return InjectResult { .status = InjectStatus::InvalidInjectee, .accepted = 0 };
+
+      auto accepted = detail::dispatchMouseEvents(*context, *state, injectee, data);
+      REMINPUT_PROFILE_COUNT(data.size(), accepted);
+      return resultOf(accepted, data.size());
+    });
+  }
+
+  InjectResult Injector::tryInjectMouseMotion(HandleID injectee, const MouseMotionData& data) noexcept {
+    return tryInjectMouseMotions(injectee, std::span(&data, 1));
+  }
+
+  InjectResult Injector::tryInjectMouseMotions(HandleID injectee, std::span<const MouseMotionData> data) noexcept {
+    return guarded(*context, [&] {
+      auto* state = checkedInjectee(*context, injectee);
+      if (!state)
+        return InjectResult { .status = InjectStatus::InvalidInjectee, .accepted = 0 };
+
+      auto accepted = detail::dispatchMotionEvents(*context, *state, injectee, data);
+      REMINPUT_PROFILE_COUNT(data.size(), accepted);
+      return resultOf(accepted, data.size());
+    });
+  }
+
+  InjectResult Injector::tryInjectText(HandleID injectee, std::u8string_view text) noexcept {
+    return guarded(*context, [&] {
+      auto* state = checkedInjectee(*context, injectee);
+      if (!state)
+        return InjectResult { .status = InjectStatus::InvalidInjectee, .accepted = 0 };
+
+      // Recordings keep characters without a key whatever the platform could do with them.
+      auto unicode = detail::kUnicodeText || detail::activeRecorder();
+      auto complete = detail::buildTextStrokes(text, unicode, context->text, context->textEnds);
+      auto accepted = detail::dispatchTextEvents(*context, *state, injectee, context->text);
+      REMINPUT_PROFILE_COUNT(context->text.size(), accepted);
+
+      // A character only counts as typed when all of its strokes were accepted, and text cut short
+      // at a character no key types was only typed in part however the strokes went.
+      auto result     = resultOf(accepted, context->text.size());
+      if (!complete && result.status == InjectStatus::Ok)
+        result.status = InjectStatus::Partial;
+      result.accepted = static_cast<std::size_t>(
+        std::upper_bound(context->textEnds.begin(), context->textEnds.end(), accepted) - context->textEnds.begin()
+      );
+      return result;
+    });
+  }
+
+  InjectResult Injector::tryInjectEvents(HandleID injectee, std::span<const InputEvent> data) noexcept {
+    return guarded(*context, [&] {
+      auto* state = checkedInjectee(*context, injectee);
+      if (!state)
+        return InjectResult { .status = InjectStatus::InvalidInjectee, .accepted = 0 };
+
+      std::size_t accepted = 0;
+      while (accepted < data.size()) {
+        auto kind = data[accepted].kind;
+        if (!detail::validEvent(data[accepted]))
+          break;
+        if (kind == InputEvent::Kind::Wait) {
+          accepted++;
+          continue;
+        }
+
+        // Unpack a run of the same kind, waits included, remembering which record each event was.
+        // A bad record ends the run, and the batch once the events before it are sent.
+        context->keys.clear();
+        context->mice.clear();
+        context->eventEnds.clear();
+        if (kind == InputEvent::Kind::Keyboard)
+          context->keys.reserve(kUnpackedRunSize);
+        else
+          context->mice.reserve(kUnpackedRunSize);
+        context->eventEnds.reserve(kUnpackedRunSize);
+        auto end = accepted;
+        for (; end < data.size() && context->eventEnds.size() < kUnpackedRunSize; end++) {
+          if (data[end].kind == InputEvent::Kind::Wait)
+            continue;
+          if (data[end].kind != kind || !detail::validEvent(data[end]))
+            break;
+          if (kind == InputEvent::Kind::Keyboard)
+            context->keys.push_back(data[end].keyboard());
+          else
+            context->mice.push_back(data[end].mouse());
+          context->eventEnds.push_back(end + 1);
+        }
+
+        auto count = context->eventEnds.size();
+        auto sent  = kind == InputEvent::Kind::Keyboard ?
+          detail::dispatchKeyboardEvents(*context, *state, injectee, context->keys) :
+          detail::dispatchMouseEvents(*context, *state, injectee, context->mice);
+        REMINPUT_PROFILE_COUNT(count, sent);
+        if (sent < count) {
+          accepted = sent ? context->eventEnds[sent - 1] : accepted;
+          break;
+        }
+        accepted = end;
+      }
+
+      // A batch stopped at a bad record is cut short, even if nothing before it was sent.
+      if (accepted < data.size() && !detail::validEvent(data[accepted]))
+        return InjectResult { .status = InjectStatus::Partial, .accepted = accepted };
+      return resultOf(accepted, data.size());
+    });
+  }
+
+  InjectResult Injector::trySetInputState(HandleID injectee, const InputSet& desired) noexcept {
+    return guarded(*context, [&] {
+      auto* state = checkedInjectee(*context, injectee);
+      if (!state)
+        return InjectResult { .status = InjectStatus::InvalidInjectee, .accepted = 0 };
+
+      auto count    = std::size_t{0};
+      auto accepted = detail::dispatchInputState(*context, *state, injectee, desired, count);
+      REMINPUT_PROFILE_COUNT(count, accepted);
+      return resultOf(accepted, count);
+    });
+  }
+
+  InjectResult Injector::tryInjectSequence(HandleID injectee, const CompiledSequence& sequence) noexcept {
+    return guarded(*context, [&] {
+      auto* state = checkedInjectee(*context, injectee);
+      if (!state)
+        return InjectResult { .status = InjectStatus::InvalidInjectee, .accepted = 0 };
+
+      // Recordings keep the events themselves, so the native records are left alone.
+      auto* recorder = detail::activeRecorder();
+      auto  accepted = std::size_t{0};
+      auto  moved    = false;
+      for (const auto& run : sequence.runs->list) {
+        auto count = run.keys.size() + run.mice.size();
+        auto sent  = std::size_t{0};
+        if (recorder && run.mice.empty()) {
+          sent = detail::recordKeyboardEvents(*recorder, injectee, run.keys);
+        } else if (recorder) {
+          sent = detail::recordMouseEvents(*recorder, injectee, run.mice);
+        } else {
+          // Runs were translated whole, so each waits for room for all of its events at once.
+          if (detail::pacingEnabled(*context))
+            detail::pace(*context, *state, count);
+          sent = detail::submitTranslated(*run.scratch, injectee);
+        }
+
+        if (run.mice.empty()) {
+          detail::trackKeyboardEvents(*state, std::span(run.keys).first(sent));
+        } else {
+          detail::trackMouseEvents(*state, std::span(run.mice).first(sent));
+          moved = true;
+        }
+
+        REMINPUT_PROFILE_COUNT(count, sent);
+        accepted += sent;
+        if (sent < count) {
+          // Anything short of the whole run may mean the injectee is gone, so check it next time.
+          detail::staleInjectee(*state);
+          break;
+        }
+      }
+
+      // The cursor is only known to be where the sequence left it if every move went out.
+      if (moved)
+        state->cursor = accepted == sequence.size() ? sequence.runs->cursor : detail::Cursor{};
+      return resultOf(accepted, sequence.size());
+    });
+  }
+
+  std::size_t Injector::releaseAll() noexcept {
+    // Walk the injectees in place, so nothing is allocated. One found invalid is forgotten, which
+    // only invalidates its own entry.
+    std::size_t released = 0;
+    for (auto entry = context->injectees.begin(); entry != context->injectees.end();) {
+      auto  injectee = entry->first;
+      auto& state    = entry->second;
+      if (state.held.empty()) {
+        ++entry;
+        continue;
+      }
+
+      if (!detail::checkInjectee(state, injectee)) {
+        entry = context->injectees.erase(entry);
+        continue;
+      }
+
+      released += guarded(*context, [&] {
+        auto count    = std::size_t{0};
+        auto accepted = detail::dispatchInputState(*context, state, injectee, InputSet{}, count);
+        REMINPUT_PROFILE_COUNT(count, accepted);
+        return resultOf(accepted, count);
+      }).accepted;
+      ++entry;
+    }
+
+    return released;
+  }
+
+  InputSet Injector::heldInputs(HandleID injectee) const {
+    auto found = context->injectees.find(injectee);
+    return found != context->injectees.end() ? found->second.held : InputSet{};
+  }
+
+  void Injector::setMoveCoalescing(bool enabled) {
+    context->coalesceMoves = enabled;
+  }
+
+  uint64_t Injector::coalescedMoves() const {
+    return context->coalescedMoves;
+  }
+
+  void Injector::setCoordinateSpace(CoordinateSpace space) {
+    // Checking each injectee again reads its transform in the new space.
+    context->space = space;
+    for (auto& [injectee, state] : context->injectees) {
+      state.space = space;
+      detail::staleInjectee(state);
+    }
+  }
+
+  void Injector::setPacing(const PacingOptions& options) {
+    detail::configurePacing(*context, options);
+  }
+
+  PacingStatistics Injector::pacingStatistics() const {
+    return context->pacingStatistics;
+  }
+
+  void Injector::release(HandleID injectee) {
+    context->injectees.erase(injectee);
+  }
+
+  // The context behind the free functions, one per thread so they never contend.
+  static Injector& defaultInjector() {
+    thread_local Injector injector;
+    return injector;
+  }
+
+  void injectKeyboardEvent(HandleID injectee, const KeyEventData& data) {
+    defaultInjector().injectKeyboardEvent(injectee, data);
+  }
+
+  std::size_t injectKeyboardEvents(HandleID injectee, std::span<const KeyEventData> data) {
+    return defaultInjector().injectKeyboardEvents(injectee, data);
+  }
+
+  void injectMouseEvent(HandleID injectee, const MouseEventData& data) {
+    defaultInjector().injectMouseEvent(injectee, data);
+  }
+
+  std::size_t injectMouseEvents(HandleID injectee, std::span<const MouseEventData> data) {
+    return defaultInjector().injectMouseEvents(injectee, data);
+  }
+
+  void injectMouseMotion(HandleID injectee, const MouseMotionData& data) {
+    defaultInjector().injectMouseMotion(injectee, data);
+  }
+
+  std::size_t injectMouseMotions(HandleID injectee, std::span<const MouseMotionData> data) {
+    return defaultInjector().injectMouseMotions(injectee, data);
+  }
+
+  std::size_t injectText(HandleID injectee, std::u8string_view text) {
+    return defaultInjector().injectText(injectee, text);
+  }
+
+  std::size_t injectEvents(HandleID injectee, std::span<const InputEvent> data) {
+    return defaultInjector().injectEvents(injectee, data);
+  }
+
+  std::size_t setInputState(HandleID injectee, const InputSet& desired) {
+    return defaultInjector().setInputState(injectee, desired);
+  }
+
+  std::size_t releaseAll(HandleID injectee) {
+    return defaultInjector().releaseAll(injectee);
+  }
+
+  std::size_t injectSequence(HandleID injectee, const CompiledSequence& sequence) {
+    return defaultInjector().injectSequence(injectee, sequence);
+  }
+
+  InjectResult tryInjectKeyboardEvent(HandleID injectee, const KeyEventData& data) noexcept {
+    return defaultInjector().tryInjectKeyboardEvent(injectee, data);
+  }
+
+  InjectResult tryInjectKeyboardEvents(HandleID injectee, std::span<const KeyEventData> data) noexcept {
+    return defaultInjector().tryInjectKeyboardEvents(injectee, data);
+  }
+
+  InjectResult tryInjectMouseEvent(HandleID injectee, const MouseEventData& data) noexcept {
+    return defaultInjector().tryInjectMouseEvent(injectee, data);
+  }
+
+  InjectResult tryInjectMouseEvents(HandleID injectee, std::span<const MouseEventData> data) noexcept {
+    return defaultInjector().tryInjectMouseEvents(injectee, data);
+  }
+
+  InjectResult tryInjectMouseMotion(HandleID injectee, const MouseMotionData& data) noexcept {
+    return defaultInjector().tryInjectMouseMotion(injectee, data);
+  }
+
+  InjectResult tryInjectMouseMotions(HandleID injectee, std::span<const MouseMotionData> data) noexcept {
+    return defaultInjector().tryInjectMouseMotions(injectee, data);
+  }
+
+  InjectResult tryInjectText(HandleID injectee, std::u8string_view text) noexcept {
+    return defaultInjector().tryInjectText(injectee, text);
+  }
+
+  InjectResult tryInjectEvents(HandleID injectee, std::span<const InputEvent> data) noexcept {
+    return defaultInjector().tryInjectEvents(injectee, data);
+  }
+
+  InjectResult trySetInputState(HandleID injectee, const InputSet& desired) noexcept {
+    return defaultInjector().trySetInputState(injectee, desired);
+  }
+
+  InjectResult tryInjectSequence(HandleID injectee, const CompiledSequence& sequence) noexcept {
+    return defaultInjector().tryInjectSequence(injectee, sequence);
+  }
+}
@@ -0,0 +1,228 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <thread>
+#include <reminput/scheduler.hpp>
+#include "config.hpp"
+#include "pacing.hpp"
+#if defined(SIMULAR_X86_PROCESSOR) || defined(SIMULAR_X64_PROCESSOR)
+#include <immintrin.h>
+#endif
+#if defined(SIMULAR_WINDOWS_PLATFORM)
+#define UNICODE 1
+#define _UNICODE 1
+#define WIN32_LEAN_AND_MEAN 1
+#define VC_EXTRALEAN 1
+#include <windows.h>
+#elif defined(SIMULAR_LINUX_PLATFORM)
+#include <sys/prctl.h>
+#include <time.h>
+#endif
+
+namespace simular::reminput {
+  // How many due events are injected as one batch at most.
+  constexpr std::size_t kPlayBatchSize = 256;
+
+  // Tells the processor the thread is spinning, so it can save power and yield to a sibling.
+  static void relax() {
+#if defined(SIMULAR_X86_PROCESSOR) || defined(SIMULAR_X64_PROCESSOR)
+    _mm_pause();
+#elif (defined(SIMULAR_ARM32_PROCESSOR) || defined(SIMULAR_ARM64_PROCESSOR)) && defined(__GNUC__)
+    __asm__ __volatile__("yield");
+#endif
+  }
+
+#if defined(SIMULAR_WINDOWS_PLATFORM)
+  // A high resolution waitable timer for each thread, since Sleep rounds up to the system tick.
+  struct WaitableTimer final {
+    HANDLE handle = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+
+    ~WaitableTimer() {
+      if (handle)
+        CloseHandle(handle);
+    }
+  };
+#endif
+
+  void detail::sleepUntil(std::chrono::steady_clock::time_point target) {
+#if defined(SIMULAR_WINDOWS_PLATFORM)
+    thread_local WaitableTimer timer;
+    auto remaining = target - std::chrono::steady_clock::now();
+    if (!timer.handle) {
+      std::this_thread::sleep_until(target);
+    } else if (remaining.count() > 0) {
+      // Negative due times are relative, in units of 100 nanoseconds.
+      LARGE_INTEGER due{};
+      due.QuadPart = -static_cast<LONGLONG>(std::chrono::duration_cast<std::chrono::nanoseconds>(remaining).count() / 100);
+      if (SetWaitableTimer(timer.handle, &due, 0, nullptr, nullptr, FALSE))
+        WaitForSingleObject(timer.handle, INFINITE);
+    }
+#elif defined(SIMULAR_LINUX_PLATFORM)
+    // The default slack of 50 microseconds would be spun away on every wait.
+    thread_local bool slackLowered = false;
+    if (!slackLowered) {
+      prctl(PR_SET_TIMERSLACK, 1UL, 0UL, 0UL, 0UL);
+      slackLowered = true;
+    }
+
+    // The steady clock is CLOCK_MONOTONIC on Linux, so its time points can be slept on directly.
+    auto since = std::chrono::duration_cast<std::chrono::nanoseconds>(target.time_since_epoch()).count();
+    timespec deadline{};
+    deadline.tv_sec  = static_cast<time_t>(since / 1000000000);
+    deadline.tv_nsec = static_cast<long>(since % 1000000000);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr) == EINTR) {}
+#else
+    std::this_thread::sleep_until(target);
+#endif
+  }
+
+  // Plays timed events of one kind, batching the ones that are due together.
+  template <typename Event, typename Inject>
+  static std::size_t playTimed(Scheduler& scheduler, LatencyHistogram& lateness, std::span<const Event> events, Inject inject) {
+    std::array<decltype(Event::data), kPlayBatchSize> batch;
+    auto start  = std::chrono::steady_clock::now();
+    auto played = std::size_t{0};
+
+    for (std::size_t next = 0; next < events.size();) {
+      auto now   = scheduler.waitUntil(start + events[next].at);
+      auto count = std::size_t{0};
+      for (; next < events.size() && count < kPlayBatchSize && start + events[next].at <= now; next++) {
+        lateness.record(static_cast<uint64_t>((now - (start + events[next].at)).count()));
+        batch[count++] = events[next].data;
+      }
+
+      auto accepted = inject(std::span(batch.data(), count));
+      played += accepted;
+      if (accepted < count)
+        break;
+    }
+
+    return played;
+  }
+
+  Scheduler::Scheduler(const SchedulerOptions& options)
+    : budget(std::max<int64_t>(options.spinBudget.count(), 0)),
+      overshootDeviation(budget / 4) {}
+
+  void Scheduler::setSpinBudget(std::chrono::nanoseconds spinBudget) {
+    budget = std::max<int64_t>(spinBudget.count(), 0);
+  }
+
+  std::chrono::nanoseconds Scheduler::spinBudget() const {
+    return std::chrono::nanoseconds(budget);
+  }
+
+  void Scheduler::learn(int64_t overshoot) {
+    // Smoothed like a retransmission timer, so one slow wake-up does not double the spinning.
+    auto error          = std::max<int64_t>(overshoot, 0) - overshootMean;
+    overshootMean      += error / 8;
+    overshootDeviation += ((error < 0 ? -error : error) - overshootDeviation) / 4;
+  }
+
+  std::chrono::steady_clock::time_point Scheduler::waitUntil(std::chrono::steady_clock::time_point deadline) {
+    // Wake early by about as much as the timer tends to be late, but never by more than the budget.
+    auto window = std::chrono::nanoseconds(std::min(budget, overshootMean + 4 * overshootDeviation));
+    auto now    = std::chrono::steady_clock::now();
+    if (deadline - now > window) {
+      auto target = deadline - window;
+      detail::sleepUntil(target);
+      now = std::chrono::steady_clock::now();
+      learn(std::chrono::duration_cast<std::chrono::nanoseconds>(now - target).count());
+    }
+
+    while (now < deadline) {
+      relax();
+      now = std::chrono::steady_clock::now();
+    }
+
+    return now;
+  }
+
+  void Scheduler::calibrate(std::size_t samples) {
+    for (std::size_t sample = 0; sample < samples; sample++) {
+      auto target = std::chrono::steady_clock::now() + std::chrono::milliseconds(1);
+      detail::sleepUntil(target);
+      learn(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - target).count());
+    }
+  }
+
+  std::size_t Scheduler::play(Injector& injector, HandleID injectee, std::span<const TimedKeyEvent> events) {
+    return playTimed(*this, latenessHistogram, events, [&](std::span<const KeyEventData> batch) {
+      return injector.injectKeyboardEvents(injectee, batch);
+    });
+  }
+
+  std::size_t Scheduler::play(Injector& injector, HandleID injectee, std::span<const TimedMouseEvent> events) {
+    return playTimed(*this, latenessHistogram, events, [&](std::span<const MouseEventData> batch) {
+      return injector.injectMouseEvents(injectee, batch);
+    });
+  }
+
+  std::size_t Scheduler::play(Injector& injector, HandleID injectee, std::span<const MacroRecord> records) {
+    auto start  = std::chrono::steady_clock::now();
+    auto offset = std::chrono::nanoseconds(0);
+    auto played = std::size_t{0};
+
+    for (std::size_t next = 0; next < records.size();) {
+      // Waits only move the deadline on.
+      offset += std::chrono::nanoseconds(records[next].delay);
+      if (records[next].kind == MacroRecord::Kind::Wait) {
+        next++;
+        continue;
+      }
+
+      // Take this record and any following ones that are already due, whatever their kind, since
+      // the injector takes packed records as they are.
+      auto now   = waitUntil(start + offset);
+      auto begin = next;
+      latenessHistogram.record(static_cast<uint64_t>((now - (start + offset)).count()));
+      for (next++; next < records.size(); next++) {
+        auto following = offset + std::chrono::nanoseconds(records[next].delay);
+        if (start + following > now)
+          break;
+        offset = following;
+        if (records[next].kind != MacroRecord::Kind::Wait)
+          latenessHistogram.record(static_cast<uint64_t>((now - (start + offset)).count()));
+      }
+
+      auto batch    = records.subspan(begin, next - begin);
+      auto accepted = injector.injectEvents(injectee, batch);
+      played += static_cast<std::size_t>(std::count_if(batch.begin(), batch.begin() + accepted, [](const MacroRecord& record) {
+        return record.kind != MacroRecord::Kind::Wait;
+      }));
+      if (accepted < batch.size())
+        break;
+    }
+
+    return played;
+  }
+
+  const LatencyHistogram& Scheduler::lateness() const {
+    return latenessHistogram;
+  }
+
+  void Scheduler::resetLateness() {
+    latenessHistogram = LatencyHistogram();
+  }
+}
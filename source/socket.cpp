@@ -0,0 +1,704 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <reminput/socket.hpp>
+#include "config.hpp"
+#include "context.hpp"
+#if defined(SIMULAR_LINUX_PLATFORM)
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/un.h>
+#include <unistd.h>
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#endif
+#if defined(IORING_RECV_MULTISHOT) && defined(SYS_io_uring_setup)
+#define REMINPUT_IO_URING 1
+#endif
+#endif
+
+namespace simular::reminput {
+#if defined(SIMULAR_LINUX_PLATFORM)
+  // What a completion or readiness notification is for, kept in the top bits of its tag.
+  enum : uint64_t {
+    kTagAccept = 1ull << 32,
+    kTagWake   = 2ull << 32,
+    kTagReceive = 3ull << 32,
+    kTagMask   = ~0ull << 32,
+  };
+
+  // The most readiness notifications handled per wait in the epoll fallback.
+  constexpr int kEpollBatchSize = 64;
+
+  // A client, and the part of a frame it sent that has not been completed yet.
+  struct Connection final {
+    int                    fd      = -1;
+    bool                   closing = false;
+    std::vector<std::byte> pending;
+
+    // Only used by io_uring where the kernel cannot pick buffers itself, kept when the slot is reused.
+    std::vector<std::byte> receive;
+  };
+
+#if defined(REMINPUT_IO_URING)
+  // The rings of an io_uring instance, set up with raw system calls.
+  struct IoUring final {
+    ~IoUring() {
+      reset();
+    }
+
+    // Tears the rings down, leaving the instance as if it was never set up.
+    void reset() {
+      if (bufferRing)
+        munmap(bufferRing, bufferRingSize);
+      if (sqes)
+        munmap(sqes, sqesSize);
+      if (cqRing && cqRing != sqRing)
+        munmap(cqRing, cqRingSize);
+      if (sqRing)
+        munmap(sqRing, sqRingSize);
+      if (fd >= 0)
+        close(fd);
+      bufferRing = nullptr;
+      sqes       = nullptr;
+      cqRing     = nullptr;
+      sqRing     = nullptr;
+      fd         = -1;
+    }
+
+    // Creates the rings, returning false where io_uring is unavailable.
+    bool setup(unsigned entries, unsigned completions) {
+      io_uring_params params{};
+      params.flags      = IORING_SETUP_CQSIZE;
+      params.cq_entries = completions;
+      fd = static_cast<int>(syscall(SYS_io_uring_setup, entries, &params));
+      if (fd < 0)
+        return false;
+
+      sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+      cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+      if (params.features & IORING_FEAT_SINGLE_MMAP)
+        sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+      sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+      if (sqRing == MAP_FAILED) {
+        sqRing = nullptr;
+        return false;
+      }
+      cqRing = sqRing;
+      if (!(params.features & IORING_FEAT_SINGLE_MMAP)) {
+        cqRing = mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (cqRing == MAP_FAILED) {
+          cqRing = nullptr;
+          return false;
+        }
+      }
+      sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+      sqes = static_cast<io_uring_sqe*>(mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+      if (sqes == MAP_FAILED) {
+        sqes = nullptr;
+        return false;
+      }
+
+      auto* sq = static_cast<char*>(sqRing);
+      auto* cq = static_cast<char*>(cqRing);
+      sqHead  = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+      sqTail  = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+      sqMask  = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+      sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+      sqSize  = params.sq_entries;
+      cqHead  = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+      cqTail  = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+      cqMask  = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+      cqes    = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+      return true;
+    }
+
+    // Registers a ring of provided buffers and checks that receives pick from it, returning false
+    // where the kernel does not support it.
+    bool provideBuffers(std::byte* buffers, std::size_t bufferSize, unsigned bufferCount) {
+      // Every buffer starts out in the ring the kernel picks receive buffers from.
+      bufferRingSize = bufferCount * sizeof(io_uring_buf);
+      auto* ring = mmap(nullptr, bufferRingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (ring == MAP_FAILED)
+        return false;
+      bufferRing = static_cast<io_uring_buf_ring*>(ring);
+
+      io_uring_buf_reg registration{};
+      registration.ring_addr    = reinterpret_cast<uint64_t>(bufferRing);
+      registration.ring_entries = bufferCount;
+      registration.bgid         = 0;
+      if (syscall(SYS_io_uring_register, fd, IORING_REGISTER_PBUF_RING, &registration, 1) != 0)
+        return false;
+
+      this->buffers    = buffers;
+      this->bufferSize = bufferSize;
+      bufferMask       = bufferCount - 1;
+      for (unsigned id = 0; id < bufferCount; id++)
+        provide(static_cast<uint16_t>(id));
+
+      // Some kernels accept the registration yet fail every receive with ENOBUFS, so receive a
+      // byte through a socket pair before relying on it.
+      int pair[2];
+      if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, pair) != 0)
+        return false;
+      auto byte  = std::byte{0};
+      auto works = write(pair[1], &byte, 1) == 1;
+      if (works) {
+        auto* entry = next();
+        entry->opcode    = IORING_OP_RECV;
+        entry->fd        = pair[0];
+        entry->flags     = IOSQE_BUFFER_SELECT;
+        entry->buf_group = 0;
+        enter(1);
+
+        auto head       = *cqHead;
+        auto completion = cqes[head & cqMask];
+        std::atomic_ref(*cqHead).store(head + 1, std::memory_order_release);
+        works = completion.res == 1 && (completion.flags & IORING_CQE_F_BUFFER);
+        if (works)
+          provide(static_cast<uint16_t>(completion.flags >> IORING_CQE_BUFFER_SHIFT));
+      }
+      close(pair[0]);
+      close(pair[1]);
+      return works;
+    }
+
+    // Hands a buffer back to the kernel once its data was consumed.
+    void provide(uint16_t id) {
+      auto& entry = bufferRing->bufs[bufferTail & bufferMask];
+      entry.addr  = reinterpret_cast<uint64_t>(buffers + id * bufferSize);
+      entry.len   = static_cast<uint32_t>(bufferSize);
+      entry.bid   = id;
+      bufferTail++;
+      std::atomic_ref(bufferRing->tail).store(bufferTail, std::memory_order_release);
+    }
+
+    // Returns a cleared entry to fill, submitting what is queued first if the ring is full.
+    io_uring_sqe* next() {
+      if (*sqTail - std::atomic_ref(*sqHead).load(std::memory_order_acquire) == sqSize)
+        enter(0);
+      auto  tail  = *sqTail;
+      auto* entry = &sqes[tail & sqMask];
+      std::memset(entry, 0, sizeof(*entry));
+      sqArray[tail & sqMask] = tail & sqMask;
+      std::atomic_ref(*sqTail).store(tail + 1, std::memory_order_release);
+      queued++;
+      return entry;
+    }
+
+    // Submits what is queued and waits for at least the given number of completions.
+    void enter(unsigned wait) {
+      auto result = syscall(SYS_io_uring_enter, fd, queued, wait, wait ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+      if (result >= 0)
+        queued -= std::min<unsigned>(queued, static_cast<unsigned>(result));
+    }
+
+    int          fd      = -1;
+    void*        sqRing  = nullptr;
+    void*        cqRing  = nullptr;
+    std::size_t  sqRingSize = 0;
+    std::size_t  cqRingSize = 0;
+    io_uring_sqe* sqes   = nullptr;
+    std::size_t  sqesSize = 0;
+    unsigned*    sqHead  = nullptr;
+    unsigned*    sqTail  = nullptr;
+    unsigned*    sqArray = nullptr;
+    unsigned     sqMask  = 0;
+    unsigned     sqSize  = 0;
+    unsigned     queued  = 0;
+    unsigned*    cqHead  = nullptr;
+    unsigned*    cqTail  = nullptr;
+    unsigned     cqMask  = 0;
+    io_uring_cqe* cqes   = nullptr;
+
+    io_uring_buf_ring* bufferRing     = nullptr;
+    std::size_t        bufferRingSize = 0;
+    std::byte*         buffers        = nullptr;
+    std::size_t        bufferSize     = 0;
+    uint16_t           bufferTail     = 0;
+    unsigned           bufferMask     = 0;
+  };
+#endif
+
+  struct SocketServer::Loop {
+    // Checks and injects one whole frame.
+    bool deliver(const std::byte* frame) {
+      FrameHeader header;
+      std::memcpy(&header, frame, sizeof(header));
+      const auto* records = frame + sizeof(header);
+
+      // Records are only read in place when they are aligned, which they are unless a receive
+      // split the stream at an odd offset.
+      const InputEvent* events = reinterpret_cast<const InputEvent*>(records);
+      if (reinterpret_cast<uintptr_t>(records) % alignof(InputEvent) != 0) {
+        std::memcpy(aligned.data(), records, header.count * sizeof(InputEvent));
+        events = aligned.data();
+      }
+
+      for (uint32_t index = 0; index < header.count; index++)
+        if (!detail::validEvent(events[index]))
+          return false;
+
+      frames.fetch_add(1, std::memory_order_relaxed);
+      if (!header.count)
+        return true;
+      auto result = injector.tryInjectEvents(reinterpret_cast<HandleID>(header.injectee), std::span(events, header.count));
+      submitted.fetch_add(result.accepted, std::memory_order_relaxed);
+      failed.fetch_add(header.count - result.accepted, std::memory_order_relaxed);
+      return true;
+    }
+
+    // Reads the size of a frame from its header, or zero if the header is malformed.
+    static std::size_t frameSize(const std::byte* data) {
+      FrameHeader header;
+      std::memcpy(&header, data, sizeof(header));
+      if (header.flags != 0 || header.count > kMaxFrameEvents)
+        return 0;
+      return sizeof(header) + header.count * sizeof(InputEvent);
+    }
+
+    // Injects every frame a receive completed, keeping what is left of the last one for later.
+    bool consume(Connection& connection, const std::byte* data, std::size_t size) {
+      auto& pending = connection.pending;
+      if (!pending.empty()) {
+        // Finish the header, then the frame, started by an earlier receive.
+        auto take = std::min(sizeof(FrameHeader) - std::min(sizeof(FrameHeader), pending.size()), size);
+        pending.insert(pending.end(), data, data + take);
+        data += take;
+        size -= take;
+        if (pending.size() < sizeof(FrameHeader))
+          return true;
+
+        auto total = frameSize(pending.data());
+        if (!total)
+          return false;
+        take = std::min(total - pending.size(), size);
+        pending.insert(pending.end(), data, data + take);
+        data += take;
+        size -= take;
+        if (pending.size() < total)
+          return true;
+        if (!deliver(pending.data()))
+          return false;
+        pending.clear();
+      }
+
+      while (size >= sizeof(FrameHeader)) {
+        auto total = frameSize(data);
+        if (!total)
+          return false;
+        if (size < total)
+          break;
+        if (!deliver(data))
+          return false;
+        data += total;
+        size -= total;
+      }
+
+      pending.insert(pending.end(), data, data + size);
+      return true;
+    }
+
+    // Takes a slot for a new client, or closes it when there is no room.
+    int open(int fd) {
+      connectionCount.fetch_add(1, std::memory_order_relaxed);
+      if (freeSlots.empty()) {
+        close(fd);
+        rejected.fetch_add(1, std::memory_order_relaxed);
+        return -1;
+      }
+
+      auto slot = freeSlots.back();
+      freeSlots.pop_back();
+      connections[slot].fd      = fd;
+      connections[slot].closing = false;
+      connections[slot].pending.clear();
+      return static_cast<int>(slot);
+    }
+
+    // Closes a client and frees its slot.
+    void release(uint32_t slot) {
+      close(connections[slot].fd);
+      connections[slot].fd = -1;
+      connections[slot].pending.clear();
+      freeSlots.push_back(slot);
+    }
+
+#if defined(REMINPUT_IO_URING)
+    // Queues an accept, which keeps accepting where multishot accepts are supported.
+    void armAccept() {
+      auto* entry = uring.next();
+      entry->opcode      = IORING_OP_ACCEPT;
+      entry->fd          = listener;
+      entry->accept_flags = SOCK_CLOEXEC;
+      entry->ioprio      = multishotAccept ? IORING_ACCEPT_MULTISHOT : 0;
+      entry->user_data   = kTagAccept;
+    }
+
+    // Queues a receive into a provided buffer, which keeps receiving where multishot is supported,
+    // or else into the buffer of the connection.
+    void armReceive(uint32_t slot) {
+      auto& connection = connections[slot];
+      auto* entry      = uring.next();
+      entry->opcode    = IORING_OP_RECV;
+      entry->fd        = connection.fd;
+      entry->user_data = kTagReceive | slot;
+      if (providedBuffers) {
+        entry->flags     = IOSQE_BUFFER_SELECT;
+        entry->buf_group = 0;
+        entry->ioprio    = multishotReceive ? IORING_RECV_MULTISHOT : 0;
+      } else {
+        connection.receive.resize(bufferSize);
+        entry->addr = reinterpret_cast<uint64_t>(connection.receive.data());
+        entry->len  = static_cast<uint32_t>(connection.receive.size());
+      }
+    }
+
+    // Queues a read of the wake-up counter.
+    void armWake() {
+      auto* entry = uring.next();
+      entry->opcode    = IORING_OP_READ;
+      entry->fd        = wake;
+      entry->addr      = reinterpret_cast<uint64_t>(&wakeCount);
+      entry->len       = sizeof(wakeCount);
+      entry->user_data = kTagWake;
+    }
+
+    void completeAccept(const io_uring_cqe& completion) {
+      if (completion.res == -EINVAL && multishotAccept) {
+        multishotAccept = false;
+        armAccept();
+        return;
+      }
+
+      if (completion.res >= 0) {
+        auto slot = open(completion.res);
+        if (slot >= 0)
+          armReceive(static_cast<uint32_t>(slot));
+      }
+      if (!(completion.flags & IORING_CQE_F_MORE))
+        armAccept();
+    }
+
+    void completeReceive(const io_uring_cqe& completion) {
+      auto  slot       = static_cast<uint32_t>(completion.user_data & ~kTagMask);
+      auto& connection = connections[slot];
+      auto  more       = (completion.flags & IORING_CQE_F_MORE) != 0;
+
+      if (completion.res > 0) {
+        auto  id   = static_cast<uint16_t>(completion.flags >> IORING_CQE_BUFFER_SHIFT);
+        auto  size = static_cast<std::size_t>(completion.res);
+        auto* data = (completion.flags & IORING_CQE_F_BUFFER) ? uring.buffers + id * uring.bufferSize : connection.receive.data();
+        if (!connection.closing && !consume(connection, data, size)) {
+          // Stop receiving, and close once the kernel is done with the connection.
+          rejected.fetch_add(1, std::memory_order_relaxed);
+          connection.closing = true;
+          shutdown(connection.fd, SHUT_RDWR);
+        }
+        if (completion.flags & IORING_CQE_F_BUFFER)
+          uring.provide(id);
+      } else if (completion.res == -EINVAL && multishotReceive) {
+        multishotReceive = false;
+      } else if (completion.res != -ENOBUFS) {
+        connection.closing = true;
+      }
+
+      if (more)
+        return;
+      if (connection.closing)
+        release(slot);
+      else
+        armReceive(slot);
+    }
+
+    void runUring() {
+      armAccept();
+      armWake();
+      while (!stopping.load(std::memory_order_acquire)) {
+        uring.enter(1);
+        auto head = *uring.cqHead;
+        auto tail = std::atomic_ref(*uring.cqTail).load(std::memory_order_acquire);
+        for (; head != tail; head++) {
+          const auto& completion = uring.cqes[head & uring.cqMask];
+          switch (completion.user_data & kTagMask) {
+          case kTagAccept:
+            completeAccept(completion);
+            break;
+          case kTagReceive:
+            completeReceive(completion);
+            break;
+          case kTagWake:
+            armWake();
+            break;
+          }
+        }
+        std::atomic_ref(*uring.cqHead).store(head, std::memory_order_release);
+      }
+    }
+#endif
+
+    void runEpoll() {
+      epoll_event ready[kEpollBatchSize];
+      while (!stopping.load(std::memory_order_acquire)) {
+        auto count = epoll_wait(epoll, ready, kEpollBatchSize, -1);
+        for (int index = 0; index < count; index++) {
+          auto tag = ready[index].data.u64;
+          if (tag == kTagAccept) {
+            // Take every waiting client.
+            int fd;
+            while ((fd = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+              auto slot = open(fd);
+              if (slot < 0)
+                continue;
+              epoll_event interest{};
+              interest.events   = EPOLLIN | EPOLLRDHUP;
+              interest.data.u64 = kTagReceive | static_cast<uint64_t>(slot);
+              epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &interest);
+            }
+          } else if (tag == kTagWake) {
+            uint64_t value;
+            while (read(wake, &value, sizeof(value)) > 0)
+              continue;
+          } else {
+            // Read until the socket is drained, closing it on end of stream or a bad frame.
+            auto slot = static_cast<uint32_t>(tag & ~kTagMask);
+            auto& connection = connections[slot];
+            while (true) {
+              auto received = recv(connection.fd, receive.data(), receive.size(), 0);
+              if (received > 0) {
+                if (consume(connection, receive.data(), static_cast<std::size_t>(received)))
+                  continue;
+                rejected.fetch_add(1, std::memory_order_relaxed);
+              } else if (received < 0 && (errno == EAGAIN || errno == EINTR)) {
+                break;
+              }
+              release(slot);
+              break;
+            }
+          }
+        }
+      }
+    }
+
+    std::string path;
+    int         listener = -1;
+    int         wake     = -1;
+    int         epoll    = -1;
+
+    // Only touched by the thread serving.
+    std::vector<Connection>   connections;
+    std::vector<uint32_t>     freeSlots;
+    std::vector<InputEvent>   aligned = std::vector<InputEvent>(kMaxFrameEvents);
+    std::vector<std::byte>    receive;
+    Injector                  injector;
+#if defined(REMINPUT_IO_URING)
+    IoUring                   uring;
+    std::unique_ptr<std::byte[]> buffers;
+    std::size_t               bufferSize       = 0;
+    bool                      usingUring       = false;
+    bool                      providedBuffers  = false;
+    bool                      multishotAccept  = true;
+    bool                      multishotReceive = true;
+    uint64_t                  wakeCount        = 0;
+#endif
+
+    std::atomic<bool>     stopping{false};
+    std::atomic<uint64_t> frames{0};
+    std::atomic<uint64_t> submitted{0};
+    std::atomic<uint64_t> failed{0};
+    std::atomic<uint64_t> rejected{0};
+    std::atomic<uint64_t> connectionCount{0};
+  };
+
+  // Where a server listens when it is not given a path: the runtime directory of the user, which
+  // only they can write to, or a name of their own in /tmp where there is none.
+  static std::string defaultSocketPath() {
+    if (auto* runtime = std::getenv("XDG_RUNTIME_DIR"); runtime && *runtime)
+      return std::string(runtime) + "/reminputd.sock";
+    return "/tmp/reminputd-" + std::to_string(getuid()) + ".sock";
+  }
+
+  // Whether a socket at the address is left by a server that is gone. Only a refused connection
+  // to a socket says so, anything else may be a live server or a file that is not ours to remove.
+  static bool abandonedSocket(const sockaddr_un& address) {
+    struct stat status{};
+    if (lstat(address.sun_path, &status) != 0 || !S_ISSOCK(status.st_mode))
+      return false;
+    auto probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (probe < 0)
+      return false;
+    auto refused = connect(probe, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 && errno == ECONNREFUSED;
+    close(probe);
+    return refused;
+  }
+
+  SocketServer::SocketServer(const SocketServerOptions& options) : loop(std::make_unique<Loop>()) {
+    auto path = options.path ? std::string(options.path) : defaultSocketPath();
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path))
+      return;
+    std::strcpy(address.sun_path, path.c_str());
+
+    auto listener = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listener < 0)
+      return;
+    auto bound = bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+
+    // A socket left by a server that died is replaced, one that another server answers on is not.
+    if (!bound && errno == EADDRINUSE && abandonedSocket(address) && unlink(path.c_str()) == 0)
+      bound = bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+    if (!bound || listen(listener, SOMAXCONN) != 0) {
+      close(listener);
+      return;
+    }
+
+    loop->path     = std::move(path);
+    loop->listener = listener;
+    loop->wake     = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    auto slots     = std::max<std::size_t>(options.connections, 1);
+    loop->connections.resize(slots);
+    loop->freeSlots.reserve(slots);
+    for (auto slot = slots; slot > 0; slot--)
+      loop->freeSlots.push_back(static_cast<uint32_t>(slot - 1));
+
+    auto bufferSize = std::max<std::size_t>(options.bufferSize, sizeof(FrameHeader));
+#if defined(REMINPUT_IO_URING)
+    if (!options.forceEpoll) {
+      // Every connection can have a receive and a close outstanding, and the completion ring may
+      // not be smaller than the submission ring.
+      constexpr std::size_t kEntries = 256;
+      auto bufferCount = std::bit_ceil(std::clamp<std::size_t>(options.bufferCount, 1, 1 << 15));
+      auto completions = std::bit_ceil(std::max({ slots * 2, bufferCount, kEntries }));
+      loop->bufferSize = bufferSize;
+      loop->usingUring = loop->uring.setup(kEntries, static_cast<unsigned>(completions));
+      if (loop->usingUring) {
+        loop->buffers         = std::make_unique<std::byte[]>(bufferCount * bufferSize);
+        loop->providedBuffers = loop->uring.provideBuffers(loop->buffers.get(), bufferSize, static_cast<unsigned>(bufferCount));
+        if (!loop->providedBuffers)
+          loop->buffers.reset();
+        return;
+      }
+      loop->uring.reset();
+    }
+#endif
+
+    loop->receive.resize(bufferSize);
+    loop->epoll = epoll_create1(EPOLL_CLOEXEC);
+    epoll_event interest{};
+    interest.events   = EPOLLIN;
+    interest.data.u64 = kTagAccept;
+    epoll_ctl(loop->epoll, EPOLL_CTL_ADD, listener, &interest);
+    interest.data.u64 = kTagWake;
+    epoll_ctl(loop->epoll, EPOLL_CTL_ADD, loop->wake, &interest);
+  }
+
+  SocketServer::~SocketServer() {
+    for (auto& connection : loop->connections)
+      if (connection.fd >= 0)
+        close(connection.fd);
+#if defined(REMINPUT_IO_URING)
+    // The rings go before the buffers the kernel may still be writing into.
+    loop->uring.reset();
+#endif
+    if (loop->epoll >= 0)
+      close(loop->epoll);
+    if (loop->wake >= 0)
+      close(loop->wake);
+    if (loop->listener >= 0) {
+      close(loop->listener);
+      unlink(loop->path.c_str());
+    }
+  }
+
+  bool SocketServer::valid() const {
+    return loop->listener >= 0;
+  }
+
+  bool SocketServer::usingIoUring() const {
+#if defined(REMINPUT_IO_URING)
+    return loop->usingUring;
+#else
+    return false;
+#endif
+  }
+
+  void SocketServer::run() {
+    if (loop->listener < 0)
+      return;
+#if defined(REMINPUT_IO_URING)
+    if (loop->usingUring)
+      return loop->runUring();
+#endif
+    loop->runEpoll();
+  }
+
+  void SocketServer::stop() {
+    loop->stopping.store(true, std::memory_order_release);
+    uint64_t one = 1;
+    if (loop->wake >= 0)
+      static_cast<void>(write(loop->wake, &one, sizeof(one)));
+  }
+
+  SocketStatistics SocketServer::statistics() const {
+    return SocketStatistics {
+      .frames      = loop->frames.load(std::memory_order_relaxed),
+      .submitted   = loop->submitted.load(std::memory_order_relaxed),
+      .failed      = loop->failed.load(std::memory_order_relaxed),
+      .rejected    = loop->rejected.load(std::memory_order_relaxed),
+      .connections = loop->connectionCount.load(std::memory_order_relaxed),
+    };
+  }
+#else
+  struct SocketServer::Loop {};
+
+  SocketServer::SocketServer(const SocketServerOptions&) : loop(std::make_unique<Loop>()) {}
+  SocketServer::~SocketServer() = default;
+
+  bool SocketServer::valid() const {
+    return false;
+  }
+
+  bool SocketServer::usingIoUring() const {
+    return false;
+  }
+
+  void SocketServer::run() {}
+  void SocketServer::stop() {}
+
+  SocketStatistics SocketServer::statistics() const {
+    return SocketStatistics { .frames = 0, .submitted = 0, .failed = 0, .rejected = 0, .connections = 0 };
+  }
+#endif
+}
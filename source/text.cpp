@@ -0,0 +1,94 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "text.hpp"
+
+namespace simular::reminput::detail {
+  // Stands in for bytes that are not well-formed UTF-8.
+  constexpr char32_t kReplacementCharacter = 0xFFFD;
+
+  // Decodes the code point at the front of the text and advances past it.
+  static char32_t decodeCodepoint(std::u8string_view& text) {
+    auto lead = static_cast<unsigned char>(text.front());
+    auto size = lead < 0x80 ? 1 : (lead >> 5) == 0x6 ? 2 : (lead >> 4) == 0xE ? 3 : (lead >> 3) == 0x1E ? 4 : 0;
+    if (size == 0 || text.size() < static_cast<std::size_t>(size)) {
+      text.remove_prefix(1);
+      return kReplacementCharacter;
+    }
+
+    auto codepoint = static_cast<char32_t>(size == 1 ? lead : lead & (0x7F >> size));
+    for (int index = 1; index < size; index++) {
+      auto next = static_cast<unsigned char>(text[index]);
+      if ((next & 0xC0) != 0x80) {
+        text.remove_prefix(1);
+        return kReplacementCharacter;
+      }
+      codepoint = (codepoint << 6) | (next & 0x3F);
+    }
+
+    // Reject overlong forms, surrogates and anything past the last plane.
+    constexpr char32_t kSmallest[] = { 0, 0, 0x80, 0x800, 0x10000 };
+    text.remove_prefix(static_cast<std::size_t>(size));
+    if (codepoint < kSmallest[size] || (codepoint >= 0xD800 && codepoint <= 0xDFFF) || codepoint > 0x10FFFF)
+      return kReplacementCharacter;
+    return codepoint;
+  }
+
+  bool buildTextStrokes(std::u8string_view text, bool unicode, std::vector<TextStroke>& strokes, std::vector<std::size_t>& ends) {
+    strokes.clear();
+    ends.clear();
+
+    auto shifted  = false;
+    auto complete = true;
+    while (!text.empty()) {
+      auto codepoint = decodeCodepoint(text);
+      auto stroke    = codepoint < kCharacterStrokes.size() ? kCharacterStrokes[codepoint] : CharacterStroke();
+      if (stroke.key != InputKey::Undefined) {
+        // Only touch shift when the character needs the other state than the one held.
+        if (stroke.shift != shifted) {
+          strokes.push_back({ .key = { InputKey::LeftShift, stroke.shift ? InputState::Press : InputState::Release } });
+          shifted = stroke.shift;
+        }
+        strokes.push_back({ .key = { stroke.key, InputState::Press } });
+        strokes.push_back({ .key = { stroke.key, InputState::Release } });
+      } else if (unicode) {
+        // A code point is typed as it is, so shift must not still be held.
+        if (shifted) {
+          strokes.push_back({ .key = { InputKey::LeftShift, InputState::Release } });
+          shifted = false;
+        }
+        strokes.push_back({ .key = { InputKey::Undefined, InputState::Press }, .unicode = codepoint });
+      } else {
+        complete = false;
+        break;
+      }
+      ends.push_back(strokes.size());
+    }
+
+    // Never leave shift held, counting its release as part of the last character.
+    if (shifted) {
+      strokes.push_back({ .key = { InputKey::LeftShift, InputState::Release } });
+      ends.back() = strokes.size();
+    }
+
+    return complete;
+  }
+}
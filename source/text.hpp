@@ -0,0 +1,103 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+/**
+ * \file
+ * \brief   Turns text into the key strokes that type it.
+ */
+#pragma once
+#include <array>
+#include <cstddef>
+#include <string_view>
+#include <vector>
+#include <reminput/reminput.hpp>
+#include "backend.hpp"
+
+namespace simular::reminput::detail {
+  /**
+   * \brief   The key that types a character, and whether shift has to be held for it.
+   */
+  struct CharacterStroke final {
+    InputKey key   = InputKey::Undefined;
+    bool     shift = false;
+  };
+
+  /**
+   * \brief   Builds the table of the ASCII characters a US keyboard types, indexed by character.
+   * \details Characters no key types are left undefined. Caps lock is assumed to be off.
+   */
+  constexpr std::array<CharacterStroke, 128> makeCharacterStrokes() {
+    std::array<CharacterStroke, 128> strokes{};
+    for (char offset = 0; offset < 26; offset++) {
+      auto key = static_cast<InputKey>(static_cast<int>(InputKey::A) + offset);
+      strokes['a' + offset] = { key, false };
+      strokes['A' + offset] = { key, true };
+    }
+
+    // The number row, and the symbols above it from 0 to 9.
+    constexpr std::string_view kShiftedDigits = ")!@#$%^&*(";
+    for (char offset = 0; offset < 10; offset++) {
+      auto key = static_cast<InputKey>(static_cast<int>(InputKey::NumBar0) + offset);
+      strokes['0' + offset]           = { key, false };
+      strokes[kShiftedDigits[offset]] = { key, true };
+    }
+
+    strokes[' ']  = { InputKey::Space, false };
+    strokes['\n'] = { InputKey::Enter, false };
+    strokes['\t'] = { InputKey::Tab, false };
+    strokes['`']  = { InputKey::Grave, false };        strokes['~'] = { InputKey::Grave, true };
+    strokes['-']  = { InputKey::Minus, false };        strokes['_'] = { InputKey::Minus, true };
+    strokes['=']  = { InputKey::Equal, false };        strokes['+'] = { InputKey::Equal, true };
+    strokes['[']  = { InputKey::LBracket, false };     strokes['{'] = { InputKey::LBracket, true };
+    strokes[']']  = { InputKey::RBracket, false };     strokes['}'] = { InputKey::RBracket, true };
+    strokes['\\'] = { InputKey::Backslash, false };    strokes['|'] = { InputKey::Backslash, true };
+    strokes[';']  = { InputKey::Semicolon, false };    strokes[':'] = { InputKey::Semicolon, true };
+    strokes['\''] = { InputKey::Apostrophe, false };   strokes['"'] = { InputKey::Apostrophe, true };
+    strokes[',']  = { InputKey::Comma, false };        strokes['<'] = { InputKey::Comma, true };
+    strokes['.']  = { InputKey::Period, false };       strokes['>'] = { InputKey::Period, true };
+    strokes['/']  = { InputKey::ForwardSlash, false }; strokes['?'] = { InputKey::ForwardSlash, true };
+    return strokes;
+  }
+
+  /**
+   * \brief   The key stroke of each ASCII character.
+   */
+  inline constexpr auto kCharacterStrokes = makeCharacterStrokes();
+
+  static_assert(kCharacterStrokes['Q'].key == InputKey::Q && kCharacterStrokes['Q'].shift);
+  static_assert(kCharacterStrokes['9'].key == InputKey::NumBar9 && !kCharacterStrokes['9'].shift);
+  static_assert(kCharacterStrokes['('].key == InputKey::NumBar9 && kCharacterStrokes['('].shift);
+
+  /**
+   * \brief      Turns text into the fewest strokes that type it.
+   * \details    Shift is pressed only when the next character needs it and it is not held already,
+   *             and released only when a character does not need it, before a code point stroke,
+   *             or at the end. Characters no key types become a code point stroke when `unicode` is
+   *             set; otherwise the strokes stop before the first of them. Malformed UTF-8 is typed
+   *             as U+FFFD.
+   * \param[in]  text The UTF-8 text to type.
+   * \param[in]  unicode Whether code point strokes can be used.
+   * \param[out] strokes The strokes, replacing what was there.
+   * \param[out] ends How many strokes type each character, cumulatively, one entry per character.
+   * \return     False if the strokes stop before the end of the text.
+   */
+  bool buildTextStrokes(std::u8string_view text, bool unicode, std::vector<TextStroke>& strokes, std::vector<std::size_t>& ends);
+}
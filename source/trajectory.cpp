@@ -0,0 +1,178 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <reminput/trajectory.hpp>
+
+namespace simular::reminput {
+  // How many points are evaluated together, sized to stay on the stack and in the L1 cache.
+  constexpr std::size_t kTrajectoryChunkSize = 64;
+
+  // Everything about a path that does not change from point to point.
+  struct TrajectoryPath final {
+    TrajectoryModel model;
+    float startX, startY, deltaX, deltaY;
+    float control1X, control1Y, control2X, control2Y;
+    float normalX, normalY;
+    float amplitude, frequency1, frequency2, phase1, phase2;
+  };
+
+  // Mixes a seed into well distributed bits, as splitmix64 does.
+  static uint64_t mixSeed(uint64_t& state) {
+    auto value = (state += 0x9E3779B97F4A7C15ull);
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+    return value ^ (value >> 31);
+  }
+
+  // Returns a float in [0, 1) from the seed.
+  static float unitFloat(uint64_t& state) {
+    return static_cast<float>(mixSeed(state) >> 40) * (1.0f / static_cast<float>(1 << 24));
+  }
+
+  static TrajectoryPath preparePath(const TrajectoryOptions& options) {
+    TrajectoryPath path{};
+    path.model  = options.model;
+    path.startX = static_cast<float>(options.startX);
+    path.startY = static_cast<float>(options.startY);
+    path.deltaX = static_cast<float>(options.endX) - path.startX;
+    path.deltaY = static_cast<float>(options.endY) - path.startY;
+
+    // The left-hand normal, as long as the path, so offsets scale with the distance moved.
+    path.normalX = -path.deltaY;
+    path.normalY =  path.deltaX;
+
+    // Controls at a third and two thirds of the way, pushed out along the normal.
+    path.control1X = path.startX + path.deltaX / 3.0f + path.normalX * options.curvature;
+    path.control1Y = path.startY + path.deltaY / 3.0f + path.normalY * options.curvature;
+    path.control2X = path.startX + path.deltaX * 2.0f / 3.0f + path.normalX * options.curvature;
+    path.control2Y = path.startY + path.deltaY * 2.0f / 3.0f + path.normalY * options.curvature;
+
+    // The wobble is two slow sines, in pixels, so it is measured against the unit normal.
+    auto length     = std::hypot(path.deltaX, path.deltaY);
+    auto state      = options.seed;
+    path.amplitude  = length > 0.0f ? options.noise / length : 0.0f;
+    path.frequency1 = std::numbers::pi_v<float> * (1.0f + 2.0f * unitFloat(state));
+    path.frequency2 = std::numbers::pi_v<float> * (3.0f + 4.0f * unitFloat(state));
+    path.phase1     = 2.0f * std::numbers::pi_v<float> * unitFloat(state);
+    path.phase2     = 2.0f * std::numbers::pi_v<float> * unitFloat(state);
+    return path;
+  }
+
+  // Evaluates a chunk of points at the given fractions of the duration, one model per loop so that
+  // each loop is a straight run of arithmetic the compiler can vectorize.
+  static void evaluateChunk(const TrajectoryPath& path, const float* tau, float* x, float* y, std::size_t count) {
+    float progress[kTrajectoryChunkSize];
+    for (std::size_t index = 0; index < count; index++) {
+      auto t = tau[index];
+      progress[index] = t * t * t * (10.0f + t * (-15.0f + t * 6.0f));
+    }
+
+    switch (path.model) {
+    case TrajectoryModel::Bezier:
+      for (std::size_t index = 0; index < count; index++) {
+        auto u  = progress[index];
+        auto v  = 1.0f - u;
+        auto b0 = v * v * v;
+        auto b1 = 3.0f * v * v * u;
+        auto b2 = 3.0f * v * u * u;
+        auto b3 = u * u * u;
+        x[index] = b0 * path.startX + b1 * path.control1X + b2 * path.control2X + b3 * (path.startX + path.deltaX);
+        y[index] = b0 * path.startY + b1 * path.control1Y + b2 * path.control2Y + b3 * (path.startY + path.deltaY);
+      }
+      break;
+    case TrajectoryModel::Noisy:
+      for (std::size_t index = 0; index < count; index++) {
+        auto t      = tau[index];
+        auto wobble = path.amplitude * std::sin(std::numbers::pi_v<float> * t) *
+                      (0.6f * std::sin(path.frequency1 * t + path.phase1) +
+                       0.4f * std::sin(path.frequency2 * t + path.phase2));
+        x[index] = path.startX + path.deltaX * progress[index] + path.normalX * wobble;
+        y[index] = path.startY + path.deltaY * progress[index] + path.normalY * wobble;
+      }
+      break;
+    case TrajectoryModel::MinimumJerk:
+    default:
+      for (std::size_t index = 0; index < count; index++) {
+        x[index] = path.startX + path.deltaX * progress[index];
+        y[index] = path.startY + path.deltaY * progress[index];
+      }
+      break;
+    }
+  }
+
+  std::size_t trajectoryLength(const TrajectoryOptions& options) {
+    if (options.duration.count() <= 0 || options.interval.count() <= 0)
+      return 1;
+
+    // One move per interval, and one more at the end when the duration is not a whole multiple.
+    auto whole = static_cast<std::size_t>(options.duration / options.interval);
+    return whole + 1 + (options.duration % options.interval != std::chrono::nanoseconds(0) ? 1 : 0);
+  }
+
+  std::size_t generateTrajectory(const TrajectoryOptions& options, std::span<TimedMouseEvent> events) {
+    auto length = trajectoryLength(options);
+    if (events.size() < length)
+      return 0;
+
+    // Without a duration there is only the end to move to.
+    if (length == 1) {
+      events[0] = TimedMouseEvent {
+        .at   = std::chrono::nanoseconds(0),
+        .data = { .xpos = options.endX, .ypos = options.endY, .scrolldy = 0, .button = MouseButton::Undefined, .state = InputState::Release },
+      };
+      return 1;
+    }
+
+    auto path     = preparePath(options);
+    auto duration = static_cast<float>(options.duration.count());
+    float tau[kTrajectoryChunkSize];
+    float x[kTrajectoryChunkSize];
+    float y[kTrajectoryChunkSize];
+
+    for (std::size_t begin = 0; begin < length; begin += kTrajectoryChunkSize) {
+      auto count = std::min(kTrajectoryChunkSize, length - begin);
+      for (std::size_t index = 0; index < count; index++) {
+        auto at = std::min(options.interval * static_cast<int64_t>(begin + index), options.duration);
+        tau[index] = static_cast<float>(at.count()) / duration;
+      }
+
+      evaluateChunk(path, tau, x, y, count);
+
+      for (std::size_t index = 0; index < count; index++) {
+        auto& event = events[begin + index];
+        event.at            = std::min(options.interval * static_cast<int64_t>(begin + index), options.duration);
+        event.data.xpos     = static_cast<int32_t>(std::floor(x[index] + 0.5f));
+        event.data.ypos     = static_cast<int32_t>(std::floor(y[index] + 0.5f));
+        event.data.scrolldy = 0;
+        event.data.button   = MouseButton::Undefined;
+        event.data.state    = InputState::Release;
+      }
+    }
+
+    // Land exactly on the target, whatever rounding did along the way.
+    events[length - 1].data.xpos = options.endX;
+    events[length - 1].data.ypos = options.endY;
+    return length;
+  }
+}
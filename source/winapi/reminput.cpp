@@ -19,10 +19,14 @@
  * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
+#include <algorithm>
 #include <array>
-#include <stdexcept>
+#include <vector>
 #include <reminput/reminput.hpp>
+#include "../backend.hpp"
 #include "../config.hpp"
+#include "../keytable.hpp"
+#include "../profiling.hpp"
 #if defined(SIMULAR_WINDOWS_PLATFORM)
 #define UNICODE 1
 #define _UNICODE 1
@@ -32,26 +36,12 @@
 
 namespace simular::reminput {
   // Maps windows VK keys to our Input keys.
-  constexpr std::array<WORD, 116> kInputKeyMap {
-    0, // Key undefined.
-    0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4A, 0x4B, 0x4C, 0x4D, 0x4E, 0x4F, 0x50, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A,
-    0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39,
-    VK_NUMPAD0, VK_NUMPAD1, VK_NUMPAD2, VK_NUMPAD3, VK_NUMPAD4, VK_NUMPAD5, VK_NUMPAD6, VK_NUMPAD7, VK_NUMPAD8, VK_NUMPAD9,
-    VK_NUMLOCK, VK_DIVIDE, VK_MULTIPLY, VK_ADD, VK_SUBTRACT, VK_DECIMAL, VK_RETURN,
-    VK_LSHIFT, VK_LCONTROL, VK_LMENU, VK_LWIN, VK_RSHIFT, VK_RCONTROL, VK_RMENU, VK_RWIN, VK_UP, VK_RIGHT, VK_DOWN, VK_LEFT,
-    VK_RETURN, VK_BACK, VK_INSERT, VK_HOME, VK_NEXT, VK_PRIOR, VK_DELETE, VK_END, VK_SNAPSHOT, VK_SCROLL, VK_PAUSE, VK_CAPITAL, VK_TAB, VK_ESCAPE, VK_SPACE,
-    VK_OEM_3, VK_OEM_MINUS, VK_OEM_PLUS, VK_OEM_4, VK_OEM_6, VK_OEM_5, VK_OEM_1, VK_OEM_7, VK_OEM_COMMA, VK_OEM_PERIOD, VK_OEM_2,
-    VK_F1, VK_F2, VK_F3, VK_F4, VK_F5, VK_F6, VK_F7, VK_F8, VK_F9, VK_F10, VK_F11, VK_F12, VK_F13, VK_F14, VK_F15, VK_F16, VK_F17, VK_F18, VK_F19, VK_F20, VK_F21, VK_F22, VK_F23, VK_F24,
-  };
-
-  void injectKeyboardEvent(HandleID injectee, const KeyEventData& data) {
-    // Convert to HWND.
-    auto* hwndInjectee = reinterpret_cast<HWND>(injectee);
-
-    // Check that HWND exists.
-    if (!IsWindow(hwndInjectee))
-      throw std::runtime_error("Injectee is not a valid HWND.");
+#define REMINPUT_WINDOWS_CODE(name, windows, evdev, keysym) static_cast<WORD>(windows),
+  constexpr std::array<WORD, kInputKeyCount> kInputKeyMap { REMINPUT_KEY_TABLE(REMINPUT_WINDOWS_CODE) };
+#undef REMINPUT_WINDOWS_CODE
 
+  // Translates a key event into the native input it is sent as.
+  static INPUT translateKeyboardEvent(const KeyEventData& data) {
     // Create necessary information to send.
     KEYBDINPUT keyboardInput{};
                keyboardInput.wVk         = kInputKeyMap[static_cast<std::size_t>(data.key)];
@@ -64,90 +54,230 @@ namespace simular::reminput {
     INPUT inputData{};
           inputData.type = INPUT_KEYBOARD;
           inputData.ki   = keyboardInput;
-
-    // Send input data.
-    SendInput(1, &inputData, sizeof(INPUT));
+    return inputData;
   }
 
-  // Store these and use them later.
-  static int ldx = 0;
-  static int ldy = 0;
-
-  // For the mouse input packs.
-  std::array<INPUT, 2> mouseInputPacks;
-
-  void injectMouseEvent(HandleID injectee, const MouseEventData& data) {
-    // Convert to HWND.
-    auto* hwndInjectee = reinterpret_cast<HWND>(injectee);
-
-    // Check that HWND exists.
-    if (!IsWindow(hwndInjectee))
-      throw std::runtime_error("Injectee is not a valid HWND.");
-
+  // Adds the wheel steps and button change of a mouse event to the native inputs starting at a
+  // move, returning how many were written. Extra buttons need a second input for their data.
+  static std::size_t translateButtons(int8_t scrolldy, MouseButton button, InputState state, MOUSEINPUT move, INPUT* inputs) {
     // Create necessary information to send.
-    MOUSEINPUT mouseInputA{};
-               mouseInputA.dx        = data.xpos;
-               mouseInputA.dy        = data.ypos;
-               mouseInputA.mouseData = data.scrolldy * WHEEL_DELTA;
-               mouseInputA.dwFlags   = MOUSEEVENTF_ABSOLUTE | MOUSEEVENTF_VIRTUALDESK;
-               mouseInputA.time      = 0;
-    MOUSEINPUT mouseInputB{};
-               mouseInputB.dx        = data.xpos;
-               mouseInputB.dy        = data.ypos;
-               mouseInputB.mouseData = data.button == MouseButton::Button3 ? XBUTTON1 :
-                                       data.button == MouseButton::Button4 ? XBUTTON2 : 0;
-               mouseInputB.dwFlags   = MOUSEEVENTF_ABSOLUTE | MOUSEEVENTF_VIRTUALDESK;
-               mouseInputB.time      = 0;
+    MOUSEINPUT mouseInputA = move;
+               mouseInputA.mouseData = scrolldy * WHEEL_DELTA;
+    MOUSEINPUT mouseInputB = move;
+               mouseInputB.mouseData = button == MouseButton::Button3 ? XBUTTON1 :
+                                       button == MouseButton::Button4 ? XBUTTON2 : 0;
+               mouseInputB.dwFlags  &= ~static_cast<DWORD>(MOUSEEVENTF_MOVE);
 
     // Check if wheel was scrolled.
-    if (data.scrolldy)
+    if (scrolldy)
       mouseInputA.dwFlags |= MOUSEEVENTF_WHEEL;
 
-    // Check if mouse moved.
-    if (ldx != data.xpos || ldy != data.ypos)
-      mouseInputA.dwFlags |= MOUSEEVENTF_MOVE;
-
     // Check for button clicks.
-    switch (data.button) {
+    switch (button) {
     case MouseButton::LeftButton:
-      mouseInputA.dwFlags |= data.state == InputState::Press ? MOUSEEVENTF_LEFTDOWN : MOUSEEVENTF_LEFTUP;
+      mouseInputA.dwFlags |= state == InputState::Press ? MOUSEEVENTF_LEFTDOWN : MOUSEEVENTF_LEFTUP;
       break;
     case MouseButton::MiddleButton:
-      mouseInputA.dwFlags |= data.state == InputState::Press ? MOUSEEVENTF_MIDDLEDOWN : MOUSEEVENTF_MIDDLEUP;
+      mouseInputA.dwFlags |= state == InputState::Press ? MOUSEEVENTF_MIDDLEDOWN : MOUSEEVENTF_MIDDLEUP;
       break;
     case MouseButton::RightButton:
-      mouseInputA.dwFlags |= data.state == InputState::Press ? MOUSEEVENTF_RIGHTDOWN : MOUSEEVENTF_RIGHTUP;
+      mouseInputA.dwFlags |= state == InputState::Press ? MOUSEEVENTF_RIGHTDOWN : MOUSEEVENTF_RIGHTUP;
       break;
     case MouseButton::Button3:
     case MouseButton::Button4:
-      mouseInputB.dwFlags |= data.state == InputState::Press ? MOUSEEVENTF_XDOWN : MOUSEEVENTF_XUP;
+      mouseInputB.dwFlags |= state == InputState::Press ? MOUSEEVENTF_XDOWN : MOUSEEVENTF_XUP;
       break;
     default:
       break;
     }
 
+    // Fill inputs.
+    inputs[0].type = INPUT_MOUSE;
+    inputs[0].mi   = mouseInputA;
+    if (button == MouseButton::Button3 || button == MouseButton::Button4) {
+      inputs[1].type = INPUT_MOUSE;
+      inputs[1].mi   = mouseInputB;
+      return 2;
+    }
+
+    return 1;
+  }
+
+  // Translates a mouse event into the native inputs it is sent as, returning how many were written.
+  static std::size_t translateMouseEvent(const MouseEventData& data, detail::Cursor& cursor, INPUT* inputs) {
+    MOUSEINPUT mouseInput{};
+               mouseInput.dx      = data.xpos;
+               mouseInput.dy      = data.ypos;
+               mouseInput.dwFlags = MOUSEEVENTF_ABSOLUTE | MOUSEEVENTF_VIRTUALDESK;
+               mouseInput.time    = 0;
+
+    // Check if mouse moved.
+    if (cursor.x != data.xpos || cursor.y != data.ypos)
+      mouseInput.dwFlags |= MOUSEEVENTF_MOVE;
+
     // Set these.
-    ldx = data.xpos;
-    ldy = data.ypos;
+    cursor.x = data.xpos;
+    cursor.y = data.ypos;
+    return translateButtons(data.scrolldy, data.button, data.state, mouseInput, inputs);
+  }
 
-    // Create inputs.
-    INPUT inputA{};
-          inputA.type = INPUT_MOUSE;
-          inputA.mi   = mouseInputA;
-    INPUT inputB{};
-          inputB.type = INPUT_MOUSE;
-          inputB.mi   = mouseInputB;
+  // Translates a relative motion into the native inputs it is sent as, returning how many were written.
+  static std::size_t translateMotionEvent(const MouseMotionData& data, INPUT* inputs) {
+    // Without MOUSEEVENTF_ABSOLUTE the deltas are in pixels, subject to pointer acceleration.
+    MOUSEINPUT mouseInput{};
+               mouseInput.dx      = data.dx;
+               mouseInput.dy      = data.dy;
+               mouseInput.dwFlags = data.dx || data.dy ? MOUSEEVENTF_MOVE : 0;
+               mouseInput.time    = 0;
+    return translateButtons(data.scrolldy, data.button, data.state, mouseInput, inputs);
+  }
 
-    // Fill inputs.
-    auto count = 1u;
-    mouseInputPacks[0] = inputA;
-    if (data.button == MouseButton::Button3 || data.button == MouseButton::Button4) {
-      count = 2;
-      mouseInputPacks[1] = inputB;
+  // Appends a press and release of each UTF-16 unit of a character, as typed by an input method.
+  static void translateUnicode(char32_t codepoint, std::vector<INPUT>& inputs) {
+    WCHAR units[2];
+    auto  count = std::size_t{1};
+    if (codepoint > 0xFFFF) {
+      codepoint -= 0x10000;
+      units[0]   = static_cast<WCHAR>(0xD800 + (codepoint >> 10));
+      units[1]   = static_cast<WCHAR>(0xDC00 + (codepoint & 0x3FF));
+      count      = 2;
+    } else {
+      units[0] = static_cast<WCHAR>(codepoint);
     }
 
-    // Send inputs.
-    SendInput(count, mouseInputPacks.data(), sizeof(INPUT));
+    for (std::size_t index = 0; index < count; index++) {
+      for (DWORD flags : { DWORD{KEYEVENTF_UNICODE}, DWORD{KEYEVENTF_UNICODE | KEYEVENTF_KEYUP} }) {
+        INPUT inputData{};
+              inputData.type           = INPUT_KEYBOARD;
+              inputData.ki.wVk         = 0;
+              inputData.ki.wScan       = units[index];
+              inputData.ki.dwFlags     = flags;
+              inputData.ki.time        = 0;
+              inputData.ki.dwExtraInfo = 0;
+        inputs.push_back(inputData);
+      }
+    }
+  }
+
+  // Sends the inputs, retrying on partial submission, and returns how many were inserted.
+  static std::size_t sendInputs(const std::vector<INPUT>& inputs) {
+    REMINPUT_PROFILE_STAGE(Submit);
+    std::size_t sent = 0;
+    while (sent < inputs.size()) {
+      // A result of zero means the input stream was blocked, so give up.
+      auto inserted = SendInput(static_cast<UINT>(inputs.size() - sent),
+                                const_cast<INPUT*>(inputs.data() + sent),
+                                sizeof(INPUT));
+      if (inserted == 0)
+        break;
+      sent += inserted;
+    }
+
+    return sent;
+  }
+
+}
+
+namespace simular::reminput::detail {
+  // Buffers reused between batches so that steady state injection does not allocate.
+  struct Scratch final {
+    std::vector<INPUT>       inputs;
+    std::vector<std::size_t> ends;
+  };
+
+  void ScratchDeleter::operator()(Scratch* scratch) const {
+    delete scratch;
+  }
+
+  std::unique_ptr<Scratch, ScratchDeleter> createScratch() {
+    return std::unique_ptr<Scratch, ScratchDeleter>(new Scratch());
+  }
+
+  const char* const kInvalidInjecteeMessage = "Injectee is not a valid HWND.";
+
+  bool validateInjectee(HandleID injectee) {
+    return IsWindow(reinterpret_cast<HWND>(injectee));
+  }
+
+  bool queryTransform(HandleID injectee, CoordinateSpace space, Transform& transform) {
+    POINT origin{};
+    if (space == CoordinateSpace::Client && !ClientToScreen(reinterpret_cast<HWND>(injectee), &origin))
+      return false;
+
+    // Absolute moves on the virtual desktop are normalized, 0 to 65535 across every monitor.
+    scaleAxis(GetSystemMetrics(SM_XVIRTUALSCREEN) - origin.x, GetSystemMetrics(SM_CXVIRTUALSCREEN), 65535,
+              transform.scaleX, transform.offsetX);
+    scaleAxis(GetSystemMetrics(SM_YVIRTUALSCREEN) - origin.y, GetSystemMetrics(SM_CYVIRTUALSCREEN), 65535,
+              transform.scaleY, transform.offsetY);
+    return true;
+  }
+
+  void translateKeyboardEvents(Scratch& scratch, std::span<const KeyEventData> data) {
+    // Translate the batch into one contiguous buffer. Key events map one to one onto inputs.
+    REMINPUT_PROFILE_STAGE(Translate);
+    scratch.inputs.clear();
+    scratch.inputs.reserve(data.size());
+    scratch.ends.clear();
+    scratch.ends.reserve(data.size());
+    for (const auto& event : data) {
+      scratch.inputs.push_back(translateKeyboardEvent(event));
+      scratch.ends.push_back(scratch.inputs.size());
+    }
+  }
+
+  void translateMouseEvents(Scratch& scratch, Cursor& cursor, std::span<const MouseEventData> data) {
+    // Translate the batch into one contiguous buffer, remembering where each event ends since
+    // extra buttons take two inputs.
+    REMINPUT_PROFILE_STAGE(Translate);
+    scratch.inputs.resize(data.size() * 2);
+    scratch.ends.clear();
+    scratch.ends.reserve(data.size());
+    auto count = std::size_t{0};
+    for (const auto& event : data) {
+      count += translateMouseEvent(event, cursor, scratch.inputs.data() + count);
+      scratch.ends.push_back(count);
+    }
+    scratch.inputs.resize(count);
+  }
+
+  void translateMotionEvents(Scratch& scratch, std::span<const MouseMotionData> data) {
+    REMINPUT_PROFILE_STAGE(Translate);
+    scratch.inputs.resize(data.size() * 2);
+    scratch.ends.clear();
+    scratch.ends.reserve(data.size());
+    auto count = std::size_t{0};
+    for (const auto& event : data) {
+      count += translateMotionEvent(event, scratch.inputs.data() + count);
+      scratch.ends.push_back(count);
+    }
+    scratch.inputs.resize(count);
+  }
+
+  // Characters without a key are typed as UTF-16 units with KEYEVENTF_UNICODE.
+  const bool kUnicodeText = true;
+
+  void translateTextEvents(Scratch& scratch, std::span<const TextStroke> data) {
+    // Translate the strokes into one contiguous buffer, remembering where each stroke ends since a
+    // character takes two inputs, or four outside the basic multilingual plane.
+    REMINPUT_PROFILE_STAGE(Translate);
+    scratch.inputs.clear();
+    scratch.ends.clear();
+    scratch.ends.reserve(data.size());
+    for (const auto& stroke : data) {
+      if (stroke.unicode)
+        translateUnicode(stroke.unicode, scratch.inputs);
+      else
+        scratch.inputs.push_back(translateKeyboardEvent(stroke.key));
+      scratch.ends.push_back(scratch.inputs.size());
+    }
+  }
+
+  std::size_t submitTranslated(const Scratch& scratch, HandleID) {
+    // An event only counts as accepted when all of its inputs were inserted.
+    auto sent = sendInputs(scratch.inputs);
+    return static_cast<std::size_t>(
+      std::upper_bound(scratch.ends.begin(), scratch.ends.end(), sent) - scratch.ends.begin()
+    );
   }
 
 }
@@ -0,0 +1,326 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <vector>
+#include <reminput/reminput.hpp>
+#include <reminput/x11.hpp>
+#include "../backend.hpp"
+#include "../config.hpp"
+#include "../context.hpp"
+#include "../keytable.hpp"
+#include "../profiling.hpp"
+#if defined(SIMULAR_LINUX_PLATFORM) && defined(REMINPUT_X11_BACKEND)
+#include <X11/Xlib.h>
+#include <X11/keysym.h>
+#include <X11/extensions/XTest.h>
+
+namespace simular::reminput {
+  // Maps X keysyms to our Input keys.
+#define REMINPUT_X11_KEYSYM(name, windows, evdev, keysym) keysym,
+  constexpr std::array<KeySym, kInputKeyCount> kInputKeyMap { REMINPUT_KEY_TABLE(REMINPUT_X11_KEYSYM) };
+#undef REMINPUT_X11_KEYSYM
+
+  // Maps X pointer buttons to our mouse buttons.
+  constexpr std::array<unsigned int, 6> kMouseButtonMap {
+    0, // Button undefined.
+    Button1, Button3, Button2, 8, 9,
+  };
+
+  // The connection every injection goes through, opened on first use. Xlib is not thread safe on
+  // its own, so every use of the display is made while holding the mutex.
+  static std::mutex  displayMutex;
+  static Display*    display = nullptr;
+  static X11Options  displayOptions;
+
+  // Key codes looked up once per connection, since the keymap of a display rarely changes.
+  static std::array<KeyCode, kInputKeyCount> keyCodes{};
+
+  // The error handler is process wide, so one is installed with the first connection and passes
+  // errors of every other display on to the handler it replaced.
+  static bool                  handlerInstalled = false;
+  static XErrorHandler         chainedHandler   = nullptr;
+  static std::atomic<Display*> handledDisplay{nullptr};
+
+  // The first request whose error is being watched for, and the error it or a later one raised.
+  // Only touched while holding the mutex, since our display only reports errors during our calls.
+  static unsigned long watchedSerial = 0;
+  static int           watchedError  = Success;
+
+  // Records errors of our display and swallows them, since a library has no business exiting the
+  // process over a window that went away.
+  static int recordErrors(Display* from, XErrorEvent* error) {
+    if (from != handledDisplay.load(std::memory_order_acquire))
+      return chainedHandler ? chainedHandler(from, error) : 0;
+    if (error->serial >= watchedSerial)
+      watchedError = error->error_code;
+    return 0;
+  }
+
+  // Starts watching for errors raised by the requests that follow.
+  static void watchErrors(Display* current) {
+    watchedSerial = NextRequest(current);
+    watchedError  = Success;
+  }
+
+  // Waits for the server to process the requests watched so far, returning whether any failed.
+  static bool watchedRequestsFailed(Display* current) {
+    XSync(current, False);
+    return watchedError != Success;
+  }
+
+  // Returns the display, connecting and caching the key codes if this is the first use.
+  static Display* acquireDisplay() {
+    if (display)
+      return display;
+
+    display = XOpenDisplay(displayOptions.display);
+    if (!display)
+      return nullptr;
+
+    // Without XTest there is nothing we can inject through.
+    int eventBase, errorBase, major, minor;
+    if (!XTestQueryExtension(display, &eventBase, &errorBase, &major, &minor)) {
+      XCloseDisplay(display);
+      display = nullptr;
+      return nullptr;
+    }
+
+    for (std::size_t index = 0; index < kInputKeyMap.size(); index++)
+      keyCodes[index] = kInputKeyMap[index] == NoSymbol ? 0 : XKeysymToKeycode(display, kInputKeyMap[index]);
+
+    handledDisplay.store(display, std::memory_order_release);
+    if (!handlerInstalled) {
+      chainedHandler   = XSetErrorHandler(&recordErrors);
+      handlerInstalled = true;
+    }
+    return display;
+  }
+
+  // Closes the display, if one is open.
+  static void releaseDisplay() {
+    if (display) {
+      handledDisplay.store(nullptr, std::memory_order_release);
+      XCloseDisplay(display);
+      display = nullptr;
+    }
+  }
+
+  void configureX11Connection(const X11Options& options) {
+    std::lock_guard lock(displayMutex);
+    releaseDisplay();
+    displayOptions = options;
+
+    // Windows checked on the old display mean nothing on the new one.
+    detail::staleInjectees();
+  }
+
+  void closeX11Connection() {
+    std::lock_guard lock(displayMutex);
+    releaseDisplay();
+    detail::staleInjectees();
+  }
+}
+
+namespace simular::reminput::detail {
+  // A single XTest request, with its key code or button already looked up.
+  struct FakeInput final {
+    enum class Type : uint8_t {
+      Key,
+      Button,
+      Motion,
+      RelativeMotion,
+    };
+
+    Type         type;
+    bool         press;
+    unsigned int code;
+    int          x;
+    int          y;
+  };
+
+  // Buffers reused between batches so that steady state injection does not allocate.
+  struct Scratch final {
+    std::vector<FakeInput>   inputs;
+    std::vector<std::size_t> ends;
+  };
+
+  void ScratchDeleter::operator()(Scratch* scratch) const {
+    delete scratch;
+  }
+
+  std::unique_ptr<Scratch, ScratchDeleter> createScratch() {
+    return std::unique_ptr<Scratch, ScratchDeleter>(new Scratch());
+  }
+
+  // Appends the wheel steps and button change of a mouse event.
+  static void appendButtons(Scratch& scratch, int8_t scrolldy, MouseButton button, InputState state) {
+    // Wheel steps are buttons four and five on X, one click for each step.
+    auto wheel = static_cast<unsigned int>(scrolldy > 0 ? Button4 : Button5);
+    for (auto step = std::abs(scrolldy); step > 0; step--) {
+      scratch.inputs.push_back({ FakeInput::Type::Button, true, wheel, 0, 0 });
+      scratch.inputs.push_back({ FakeInput::Type::Button, false, wheel, 0, 0 });
+    }
+
+    // Check for button clicks.
+    if (auto code = kMouseButtonMap[static_cast<std::size_t>(button)])
+      scratch.inputs.push_back({ FakeInput::Type::Button, state == InputState::Press, code, 0, 0 });
+  }
+
+  const char* const kInvalidInjecteeMessage = "Injectee is not a valid X window.";
+
+  bool validateInjectee(HandleID injectee) {
+    std::lock_guard lock(displayMutex);
+    auto* current = acquireDisplay();
+    if (!current || !injectee)
+      return false;
+
+    // A missing window is reported through the error handler rather than the result alone.
+    watchErrors(current);
+    XWindowAttributes attributes;
+    auto exists = XGetWindowAttributes(current, static_cast<Window>(reinterpret_cast<uintptr_t>(injectee)), &attributes) != 0;
+    return !watchedRequestsFailed(current) && exists;
+  }
+
+  bool queryTransform(HandleID injectee, CoordinateSpace space, Transform& transform) {
+    // Motion is faked on the root window, so screen positions are sent as they are.
+    transform = Transform{};
+    if (space != CoordinateSpace::Client)
+      return true;
+
+    std::lock_guard lock(displayMutex);
+    auto* current = acquireDisplay();
+    if (!current || !injectee)
+      return false;
+
+    // Find where the window starts on the root, which fails if it is gone.
+    watchErrors(current);
+    int    x     = 0;
+    int    y     = 0;
+    Window child = None;
+    auto   found = XTranslateCoordinates(current, static_cast<Window>(reinterpret_cast<uintptr_t>(injectee)),
+                                         DefaultRootWindow(current), 0, 0, &x, &y, &child) != 0;
+    found = !watchedRequestsFailed(current) && found;
+    transform.offsetX = int64_t{x} << kTransformBits;
+    transform.offsetY = int64_t{y} << kTransformBits;
+    return found;
+  }
+
+  void translateKeyboardEvents(Scratch& scratch, std::span<const KeyEventData> data) {
+    REMINPUT_PROFILE_STAGE(Translate);
+    scratch.inputs.clear();
+    scratch.ends.clear();
+
+    // Key codes are only known once connected.
+    std::lock_guard lock(displayMutex);
+    if (!acquireDisplay())
+      return;
+
+    for (const auto& event : data) {
+      if (auto code = keyCodes[static_cast<std::size_t>(event.key)])
+        scratch.inputs.push_back({ FakeInput::Type::Key, event.state == InputState::Press, code, 0, 0 });
+      scratch.ends.push_back(scratch.inputs.size());
+    }
+  }
+
+  void translateMouseEvents(Scratch& scratch, Cursor& cursor, std::span<const MouseEventData> data) {
+    REMINPUT_PROFILE_STAGE(Translate);
+    scratch.inputs.clear();
+    scratch.ends.clear();
+    for (const auto& event : data) {
+      // Check if mouse moved.
+      if (cursor.x != event.xpos || cursor.y != event.ypos)
+        scratch.inputs.push_back({ FakeInput::Type::Motion, false, 0, event.xpos, event.ypos });
+      cursor.x = event.xpos;
+      cursor.y = event.ypos;
+
+      appendButtons(scratch, event.scrolldy, event.button, event.state);
+      scratch.ends.push_back(scratch.inputs.size());
+    }
+  }
+
+  void translateMotionEvents(Scratch& scratch, std::span<const MouseMotionData> data) {
+    REMINPUT_PROFILE_STAGE(Translate);
+    scratch.inputs.clear();
+    scratch.ends.clear();
+    for (const auto& event : data) {
+      if (event.dx || event.dy)
+        scratch.inputs.push_back({ FakeInput::Type::RelativeMotion, false, 0, event.dx, event.dy });
+      appendButtons(scratch, event.scrolldy, event.button, event.state);
+      scratch.ends.push_back(scratch.inputs.size());
+    }
+  }
+
+  // XTest can only press keys that have a keycode, so text is limited to what the keys can type.
+  const bool kUnicodeText = false;
+
+  void translateTextEvents(Scratch& scratch, std::span<const TextStroke> data) {
+    REMINPUT_PROFILE_STAGE(Translate);
+    scratch.inputs.clear();
+    scratch.ends.clear();
+
+    // Key codes are only known once connected.
+    std::lock_guard lock(displayMutex);
+    if (!acquireDisplay())
+      return;
+
+    for (const auto& stroke : data) {
+      if (auto code = keyCodes[static_cast<std::size_t>(stroke.key.key)])
+        scratch.inputs.push_back({ FakeInput::Type::Key, stroke.key.state == InputState::Press, code, 0, 0 });
+      scratch.ends.push_back(scratch.inputs.size());
+    }
+  }
+
+  std::size_t submitTranslated(const Scratch& scratch, HandleID) {
+    REMINPUT_PROFILE_STAGE(Submit);
+    std::lock_guard lock(displayMutex);
+    auto* current = acquireDisplay();
+    if (!current)
+      return 0;
+
+    // Requests are only queued here, nothing is sent until the flush below.
+    for (const auto& input : scratch.inputs) {
+      switch (input.type) {
+      case FakeInput::Type::Key:
+        XTestFakeKeyEvent(current, input.code, input.press, CurrentTime);
+        break;
+      case FakeInput::Type::Button:
+        XTestFakeButtonEvent(current, input.code, input.press, CurrentTime);
+        break;
+      case FakeInput::Type::Motion:
+        XTestFakeMotionEvent(current, -1, input.x, input.y, CurrentTime);
+        break;
+      case FakeInput::Type::RelativeMotion:
+        XTestFakeRelativeMotionEvent(current, input.x, input.y, CurrentTime);
+        break;
+      }
+    }
+
+    // Send the whole batch at once, without waiting for the server to reply.
+    return XFlush(current) ? scratch.ends.size() : 0;
+  }
+}
+
+#endif
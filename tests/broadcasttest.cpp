@@ -0,0 +1,93 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <cstdlib>
+#include <vector>
+#include <reminput/broadcast.hpp>
+#include <reminput/uinput.hpp>
+#include <fcntl.h>
+#include <unistd.h>
+#include <linux/input.h>
+#include "testing.hpp"
+
+// Reads every input event currently waiting in the pipe.
+static std::vector<input_event> readEvents(int descriptor) {
+  std::vector<input_event> events(1024);
+  auto bytes = read(descriptor, events.data(), events.size() * sizeof(input_event));
+  events.resize(bytes > 0 ? static_cast<std::size_t>(bytes) / sizeof(input_event) : 0);
+  return events;
+}
+
+int main(void) {
+  // For explicitness.
+  using namespace simular::reminput;
+
+  // Stand in for /dev/uinput with a pipe.
+  int descriptors[2];
+  if (pipe2(descriptors, O_NONBLOCK) != 0)
+    return EXIT_FAILURE;
+  attachUInputDevice(descriptors[1]);
+
+  // Any non-null handle names a session, and the last target is not one.
+  int sessions[8] = {};
+  std::vector<BroadcastTarget> targets(9);
+  for (std::size_t index = 0; index < 8; index++)
+    targets[index].injectee = reinterpret_cast<HandleID>(&sessions[index]);
+
+  const KeyEventData keys[] {
+    { .key = InputKey::A, .state = InputState::Press   },
+    { .key = InputKey::A, .state = InputState::Release },
+  };
+  const MouseEventData mice[] {
+    { .xpos = 10, .ypos = 20, .scrolldy = 0, .button = MouseButton::LeftButton, .state = InputState::Press   },
+    { .xpos = 10, .ypos = 20, .scrolldy = 0, .button = MouseButton::LeftButton, .state = InputState::Release },
+  };
+
+  // The same results come back however many workers share the targets.
+  for (std::size_t workers : { 0, 3 }) {
+    Broadcaster broadcaster(workers);
+    auto timing = broadcaster.broadcast(targets, keys);
+    auto served = true;
+    for (std::size_t index = 0; index < 8; index++)
+      served = served && targets[index].valid && targets[index].accepted == 2;
+    check(served, "every session accepted the keys");
+    check(!targets[8].valid && targets[8].accepted == 0, "null target skipped");
+    check(timing.fanout >= timing.slowest, "fan-out covers the slowest target");
+
+    auto events = readEvents(descriptors[0]);
+    check(events.size() == 8 * 4, "one key record and one report per event per session");
+    auto pressed = std::size_t{0};
+    for (const auto& event : events)
+      pressed += event.type == EV_KEY && event.code == KEY_A && event.value == 1;
+    check(pressed == 8, "A pressed once per session");
+
+    // Every session is sent the first position, even after an earlier broadcast moved there.
+    for (auto round = 0; round < 2; round++) {
+      broadcaster.broadcast(targets, mice);
+      events = readEvents(descriptors[0]);
+      check(events.size() == 8 * 6, "each session moved, pressed and released");
+    }
+  }
+
+  closeUInputDevice();
+  close(descriptors[0]);
+  return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,117 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <cstdlib>
+#include <vector>
+#include <reminput/reminput.hpp>
+#include <reminput/uinput.hpp>
+#include <fcntl.h>
+#include <unistd.h>
+#include <linux/input.h>
+#include "../source/context.hpp"
+#include "../source/coordinates.hpp"
+#include "testing.hpp"
+
+// Reads every input event currently waiting in the pipe.
+static std::vector<input_event> readEvents(int descriptor) {
+  std::vector<input_event> events(256);
+  auto bytes = read(descriptor, events.data(), events.size() * sizeof(input_event));
+  events.resize(bytes > 0 ? static_cast<std::size_t>(bytes) / sizeof(input_event) : 0);
+  return events;
+}
+
+int main(void) {
+  // For explicitness.
+  using namespace simular::reminput;
+
+  // A desktop of three 1920 pixel monitors, starting one monitor left of the primary, normalized
+  // the way Windows takes absolute moves. Both edges land on the ends of the range.
+  detail::Transform desktop;
+  detail::scaleAxis(-1920, 3 * 1920, 65535, desktop.scaleX, desktop.offsetX);
+  detail::scaleAxis(0, 1080, 65535, desktop.scaleY, desktop.offsetY);
+  check(!desktop.identity(), "normalizing transform is not the identity");
+  const MouseEventData corners[] {
+    { .xpos = -1920, .ypos = 0,    .scrolldy = 0, .button = MouseButton::Undefined, .state = InputState::Release },
+    { .xpos = 3839,  .ypos = 1079, .scrolldy = 0, .button = MouseButton::Undefined, .state = InputState::Release },
+    { .xpos = 960,   .ypos = 540,  .scrolldy = 0, .button = MouseButton::Undefined, .state = InputState::Release },
+  };
+  std::vector<MouseEventData> mapped;
+  auto normalized = detail::mapPositions(desktop, corners, mapped);
+  check(normalized[0].xpos == 0 && normalized[0].ypos == 0, "top left corner lands on zero");
+  check(normalized[1].xpos == 65535 && normalized[1].ypos == 65535, "bottom right corner lands on the end");
+  check(normalized[2].xpos == 32773 && normalized[2].ypos == 32798, "middle of the primary rounds to nearest");
+  check(detail::mapPositions(detail::Transform{}, corners, mapped).data() == corners, "identity maps nothing");
+
+  // Stand in for /dev/uinput with a pipe.
+  int descriptors[2];
+  if (pipe2(descriptors, O_NONBLOCK) != 0)
+    return EXIT_FAILURE;
+  attachUInputDevice(descriptors[1]);
+  int session = 0;
+  auto id = reinterpret_cast<HandleID>(&session);
+
+  // A client area 100 pixels right and 50 down. Positions are mapped once on the way out.
+  detail::Context       context;
+  detail::InjecteeState state;
+                        state.transform.offsetX = int64_t{100} << detail::kTransformBits;
+                        state.transform.offsetY = int64_t{50} << detail::kTransformBits;
+  const MouseEventData press { .xpos = 10, .ypos = 20, .scrolldy = 0, .button = MouseButton::LeftButton, .state = InputState::Press };
+  check(detail::dispatchMouseEvents(context, state, id, std::span(&press, 1)) == 1, "client press accepted");
+  auto events = readEvents(descriptors[0]);
+  check(events.size() == 4 && events[0].code == ABS_X && events[0].value == 110 &&
+        events[1].code == ABS_Y && events[1].value == 70, "client position offset once");
+
+  // Releasing what is held never sends a position, so nothing can be mapped twice.
+  auto count = std::size_t{0};
+  check(detail::dispatchInputState(context, state, id, InputSet{}, count) == 1 && count == 1, "held button released");
+  events = readEvents(descriptors[0]);
+  check(events.size() == 2 && events[0].type == EV_KEY && events[0].code == BTN_LEFT && events[0].value == 0,
+        "button released where the pointer is");
+
+  // The cursor is kept as sent, so pressing again at the same client position does not move.
+  check(detail::dispatchMouseEvents(context, state, id, std::span(&press, 1)) == 1, "client press repeated");
+  check(readEvents(descriptors[0]).size() == 2, "repeated position not sent again");
+
+  // Geometry is only read again for the injectee invalidated, not for every other one.
+  int other = 0;
+  auto otherId = reinterpret_cast<HandleID>(&other);
+  detail::InjecteeState otherState;
+  check(detail::checkInjectee(state, id) && detail::checkInjectee(otherState, otherId), "both injectees checked");
+  auto checkedAt = otherState.validatedAt;
+  invalidateInjectee(id);
+  check(detail::checkInjectee(state, id) && state.invalidations != otherState.invalidations, "invalidated injectee checked again");
+  check(detail::checkInjectee(otherState, otherId) && otherState.validatedAt == checkedAt, "other injectee still trusted");
+
+  // Once full, a context forgets the injectees holding nothing, and refuses more when all hold something.
+  detail::Context crowded;
+  detail::InjecteeState holding;
+  holding.held.set(InputKey::A);
+  for (uintptr_t handle = 1; handle <= detail::kMaxInjectees; handle++)
+    crowded.injectees[reinterpret_cast<HandleID>(handle)] = handle == 1 ? holding : detail::InjecteeState{};
+  check(detail::makeInjecteeRoom(crowded) && crowded.injectees.size() == 1, "idle injectees forgotten when full");
+  for (uintptr_t handle = 1; handle <= detail::kMaxInjectees; handle++)
+    crowded.injectees[reinterpret_cast<HandleID>(handle)] = holding;
+  check(!detail::makeInjecteeRoom(crowded) && crowded.injectees.size() == detail::kMaxInjectees, "holding injectees kept");
+
+  closeUInputDevice();
+  close(descriptors[0]);
+  return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
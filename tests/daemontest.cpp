@@ -0,0 +1,148 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <reminput/daemon.hpp>
+#include <reminput/uinput.hpp>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <linux/input.h>
+#include "testing.hpp"
+
+// For explicitness.
+using namespace simular::reminput;
+
+// Connects from a new process, sends key presses for a session of its own, then exits, with or
+// without closing its ring. Only the parent returns.
+static pid_t spawnClient(const std::string& name, int session, int events, bool crash) {
+  auto child = fork();
+  if (child != 0)
+    return child;
+
+  {
+    DaemonClient client(name.c_str());
+    if (!client.connected())
+      _exit(2);
+
+    auto id = reinterpret_cast<HandleID>(static_cast<uintptr_t>(session));
+    for (int event = 0; event < events;) {
+      if (client.enqueue(id, KeyEventData { .key = InputKey::A, .state = InputState::Press }))
+        event++;
+      else
+        std::this_thread::yield();
+    }
+
+    if (crash)
+      _exit(0);
+  }
+  _exit(0);
+}
+
+// Waits for a child and checks that it connected and sent everything.
+static bool joinClient(pid_t child) {
+  int status = 0;
+  return waitpid(child, &status, 0) == child && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+int main(void) {
+  // Stand in for /dev/uinput with a pipe large enough for the whole test.
+  int descriptors[2];
+  if (pipe2(descriptors, O_NONBLOCK) != 0)
+    return EXIT_FAILURE;
+  fcntl(descriptors[1], F_SETPIPE_SZ, 1 << 20);
+  attachUInputDevice(descriptors[1]);
+
+  // Few small rings, so clients have to wait on the daemon and rings have to be reused.
+  auto name = "/reminputd-test-" + std::to_string(getpid());
+  InjectionDaemon daemon(DaemonOptions { .name = name.c_str(), .clients = 3, .capacity = 64, .spins = 64 });
+  check(daemon.valid(), "segment created");
+  {
+    // A second daemon never takes the segment away from a live one.
+    InjectionDaemon usurper(DaemonOptions { .name = name.c_str(), .clients = 1, .capacity = 2 });
+    check(!usurper.valid(), "live daemon's segment left alone");
+  }
+  std::thread runner([&] { daemon.run(); });
+
+  constexpr int kClients = 3;
+  constexpr int kEvents  = 500;
+  constexpr int kCrashed = 10;
+
+  // A client that dies without closing its ring still has what it sent injected, and its ring is
+  // handed to another client once the daemon notices.
+  auto crashed = spawnClient(name, 100, kCrashed, true);
+  check(joinClient(crashed), "crashed client sent everything");
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+  std::vector<pid_t> children;
+  for (int client = 0; client < kClients; client++) {
+    children.push_back(spawnClient(name, client + 1, kEvents, false));
+  }
+  for (auto child : children)
+    check(joinClient(child), "client connected and sent everything");
+
+  // A record the backends cannot index is dropped, and the good one next to it still goes out.
+  // Every ring may still be draining, so connecting is retried until one is handed back.
+  {
+    auto client = std::make_unique<DaemonClient>(name.c_str());
+    auto retry  = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!client->connected() && std::chrono::steady_clock::now() < retry) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      client = std::make_unique<DaemonClient>(name.c_str());
+    }
+    InputEvent mixed[] {
+      InputEvent::fromKeyboard(KeyEventData { .key = InputKey::A, .state = InputState::Press }),
+      InputEvent::fromKeyboard(KeyEventData { .key = InputKey::A, .state = InputState::Press }),
+    };
+    mixed[0].code = 250;
+    check(client->enqueue(reinterpret_cast<HandleID>(uintptr_t{200}), mixed) == 2, "bad record handed over");
+  }
+
+  // Everything else handed over is injected.
+  constexpr uint64_t kTotal = kClients * kEvents + kCrashed + 1;
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (daemon.statistics().submitted < kTotal && std::chrono::steady_clock::now() < deadline)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  daemon.stop();
+  runner.join();
+
+  auto statistics = daemon.statistics();
+  check(statistics.submitted == kTotal && statistics.failed == 1, "every good event submitted");
+  check(statistics.connections == kClients + 2, "every client counted");
+
+  // One key record and one report per event reached the device.
+  std::vector<input_event> events(2 * kTotal + 1);
+  auto bytes = read(descriptors[0], events.data(), events.size() * sizeof(input_event));
+  check(bytes == static_cast<ssize_t>(2 * kTotal * sizeof(input_event)), "every event reached the device");
+
+  // Without a daemon, clients do not connect.
+  DaemonClient orphan("/reminputd-test-missing");
+  check(!orphan.connected() && !orphan.enqueue(nullptr, KeyEventData{}), "no daemon, no connection");
+
+  closeUInputDevice();
+  close(descriptors[0]);
+  return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,52 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <cstdlib>
+#include <string_view>
+#include <reminput/keys.hpp>
+#include "testing.hpp"
+
+// Names resolve while compiling.
+static_assert(simular::reminput::parseInputKey("PageUp") == simular::reminput::InputKey::PageUp);
+static_assert(simular::reminput::toString(simular::reminput::InputKey::F24) == "F24");
+
+int main(void) {
+  // For explicitness.
+  using namespace simular::reminput;
+  using namespace std::string_view_literals;
+
+  // Every key survives a round trip through its name.
+  auto roundTrips = true;
+  for (std::size_t index = 0; index < kInputKeyCount; index++) {
+    auto key   = static_cast<InputKey>(index);
+    roundTrips = roundTrips && parseInputKey(toString(key)) == key;
+  }
+  check(roundTrips, "every name parses back to its key");
+
+  check(parseInputKey("pagedown"sv) == InputKey::PageDown, "case is ignored");
+  check(parseInputKey("NUMPADENTER"sv) == InputKey::NumPadEnter, "case is ignored");
+  check(!parseInputKey(""sv), "empty name rejected");
+  check(!parseInputKey("PageUpp"sv), "unknown name rejected");
+  check(!parseInputKey("F25"sv), "unknown name rejected");
+  check(toString(static_cast<InputKey>(kInputKeyCount)).empty(), "out of range key unnamed");
+
+  return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,299 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <chrono>
+#include <cstdlib>
+#include <stdexcept>
+#include <vector>
+#include <reminput/compiled.hpp>
+#include <reminput/profiling.hpp>
+#include <reminput/reminput.hpp>
+#include <reminput/uinput.hpp>
+#include <fcntl.h>
+#include <unistd.h>
+#include <linux/input.h>
+#include "testing.hpp"
+
+// Reads every input event currently waiting in the pipe.
+static std::vector<input_event> readEvents(int descriptor) {
+  std::vector<input_event> events(256);
+  auto bytes = read(descriptor, events.data(), events.size() * sizeof(input_event));
+  events.resize(bytes > 0 ? static_cast<std::size_t>(bytes) / sizeof(input_event) : 0);
+  return events;
+}
+
+int main(void) {
+  // For explicitness.
+  using namespace simular::reminput;
+
+  // Stand in for /dev/uinput with a pipe.
+  int descriptors[2];
+  if (pipe2(descriptors, O_NONBLOCK) != 0)
+    return EXIT_FAILURE;
+  attachUInputDevice(descriptors[1]);
+
+  // Any non-null handle names a session.
+  int session = 0;
+  auto id = reinterpret_cast<HandleID>(&session);
+
+  // A key batch writes one report per event.
+  const KeyEventData keys[] {
+    { .key = InputKey::A,         .state = InputState::Press   },
+    { .key = InputKey::A,         .state = InputState::Release },
+    { .key = InputKey::LeftShift, .state = InputState::Press   },
+  };
+  check(injectKeyboardEvents(id, keys) == 3, "all key events accepted");
+  auto events = readEvents(descriptors[0]);
+  check(events.size() == 6, "one key record and one report per key event");
+  if (events.size() == 6) {
+    check(events[0].type == EV_KEY && events[0].code == KEY_A && events[0].value == 1, "A pressed");
+    check(events[1].type == EV_SYN && events[1].code == SYN_REPORT, "report after press");
+    check(events[2].type == EV_KEY && events[2].code == KEY_A && events[2].value == 0, "A released");
+    check(events[4].type == EV_KEY && events[4].code == KEY_LEFTSHIFT, "left shift pressed");
+  }
+
+  // Mouse events only move when the position changed.
+  const MouseEventData mice[] {
+    { .xpos = 10, .ypos = 20, .scrolldy = 0, .button = MouseButton::LeftButton, .state = InputState::Press   },
+    { .xpos = 10, .ypos = 20, .scrolldy = 0, .button = MouseButton::LeftButton, .state = InputState::Release },
+    { .xpos = 10, .ypos = 20, .scrolldy = 2, .button = MouseButton::Undefined,  .state = InputState::Release },
+  };
+  check(injectMouseEvents(id, mice) == 3, "all mouse events accepted");
+  events = readEvents(descriptors[0]);
+  check(events.size() == 8, "moves are only sent once");
+  if (events.size() == 8) {
+    check(events[0].type == EV_ABS && events[0].code == ABS_X && events[0].value == 10, "moved on x");
+    check(events[1].type == EV_ABS && events[1].code == ABS_Y && events[1].value == 20, "moved on y");
+    check(events[2].type == EV_KEY && events[2].code == BTN_LEFT && events[2].value == 1, "left pressed");
+    check(events[6].type == EV_REL && events[6].code == REL_WHEEL && events[6].value == 2, "scrolled");
+  }
+
+  // Cursor state is kept per injectee, so another session moving to the same place still moves.
+  int otherSession = 0;
+  auto otherId = reinterpret_cast<HandleID>(&otherSession);
+  Injector injector;
+  check(injector.injectMouseEvents(otherId, std::span(mice, 1)) == 1, "other session accepted");
+  events = readEvents(descriptors[0]);
+  check(events.size() == 4 && events[0].code == ABS_X, "other session moved");
+
+  // A null handle is rejected.
+#if defined(__cpp_exceptions)
+  auto threw = false;
+  try {
+    injectKeyboardEvent(nullptr, keys[0]);
+  } catch (const std::runtime_error&) {
+    threw = true;
+  }
+  check(threw, "null injectee throws");
+#endif
+
+  // Buckets stay within an eighth of the value they hold.
+  for (uint64_t value : { 0ull, 7ull, 8ull, 1000ull, 123456789ull }) {
+    auto bound = LatencyHistogram::bucketUpperBound(LatencyHistogram::bucketOf(value));
+    check(bound >= value && bound <= value + value / 8, "histogram bucket bounds value");
+  }
+
+#if defined(REMINPUT_PROFILING)
+  // Everything injected above was timed and counted.
+  auto snapshot = profileSnapshot();
+  check(snapshot.requested == 7 && snapshot.accepted == 7, "events counted");
+  check(snapshot[ProfileStage::Validate].total() == 4, "validation timed once per batch, rejected ones too");
+  check(snapshot[ProfileStage::Submit].total() == 3, "submission timed once per batch");
+#endif
+
+  // The functions that never throw report each kind of failure in their result.
+  auto result = tryInjectKeyboardEvents(nullptr, keys);
+  check(result.status == InjectStatus::InvalidInjectee && result.accepted == 0, "null injectee reported");
+  result = tryInjectKeyboardEvents(id, keys);
+  check(result && result.accepted == 3, "valid batch reported ok");
+  readEvents(descriptors[0]);
+
+  // A batch larger than the pipe only goes in part of the way.
+  std::vector<KeyEventData> flood(4096, keys[0]);
+  result = tryInjectKeyboardEvents(id, flood);
+  check(result.status == InjectStatus::Partial && result.accepted > 0 && result.accepted < flood.size(), "partial submission counted");
+  while (!readEvents(descriptors[0]).empty())
+    continue;
+
+  // Without a device, nothing is accepted. Configuring closes the pipe, so keep a copy of it.
+  auto spare = dup(descriptors[1]);
+  configureUInputDevice(UInputOptions { .path = "/nonexistent/uinput" });
+  result = tryInjectMouseEvents(id, mice);
+  check(result.status == InjectStatus::BackendFailure && result.accepted == 0, "backend failure reported");
+  attachUInputDevice(spare);
+
+  // Text stops before characters no key types, and shift is only held where needed.
+  check(injectText(id, u8"Hi!\u00e9") == 3, "typed up to the accented character");
+  check(tryInjectText(id, u8"\u00e9").status == InjectStatus::Partial, "text cut short reported as partial");
+  events = readEvents(descriptors[0]);
+  check(events.size() == 20, "ten strokes for three characters");
+  if (events.size() == 20) {
+    check(events[0].code == KEY_LEFTSHIFT && events[0].value == 1, "shift pressed for H");
+    check(events[2].code == KEY_H && events[2].value == 1, "H pressed");
+    check(events[6].code == KEY_LEFTSHIFT && events[6].value == 0, "shift released for i");
+    check(events[14].code == KEY_1 && events[14].value == 1, "1 pressed for the bang");
+    check(events[18].code == KEY_LEFTSHIFT && events[18].value == 0, "shift released at the end");
+  }
+
+  // Packed records of mixed kinds go in order, and waits count as accepted.
+  const InputEvent packed[] {
+    InputEvent::fromKeyboard(keys[0]),
+    InputEvent::wait(1000),
+    InputEvent::fromMouse(mice[0]),
+    InputEvent::fromKeyboard(keys[1], 500),
+  };
+  check(injectEvents(id, packed) == 4, "all packed records accepted");
+  events = readEvents(descriptors[0]);
+  check(events.size() == 6, "one report per packed event, none for the wait");
+  if (events.size() == 6) {
+    check(events[0].code == KEY_A && events[0].value == 1, "packed A pressed");
+    check(events[2].code == BTN_LEFT && events[2].value == 1, "packed left pressed without moving");
+    check(events[4].code == KEY_A && events[4].value == 0, "packed A released");
+  }
+
+  // A record no key, button, state or kind matches stops the batch before reaching the device.
+  InputEvent corrupt[] { InputEvent::fromKeyboard(keys[0]), InputEvent::fromMouse(mice[0]), InputEvent::wait(0) };
+  corrupt[0].code = 250;
+  corrupt[1].code = 9;
+  corrupt[2].kind = static_cast<InputEvent::Kind>(7);
+  for (std::size_t index = 0; index < std::size(corrupt); index++) {
+    auto cut = injector.tryInjectEvents(id, std::span(corrupt + index, 1));
+    check(cut.status == InjectStatus::Partial && cut.accepted == 0, "bad packed record refused");
+  }
+  check(readEvents(descriptors[0]).empty(), "nothing sent for bad records");
+  InputSet outOfRange;
+  outOfRange.set(static_cast<InputKey>(250));
+  outOfRange.set(static_cast<MouseButton>(40));
+  check(outOfRange.empty() && !outOfRange.test(static_cast<InputKey>(250)) && !outOfRange.test(static_cast<MouseButton>(40)),
+        "values past the last key or button ignored");
+
+  // Setting the held keys only sends what changed, releases first.
+  int thirdSession = 0;
+  auto thirdId = reinterpret_cast<HandleID>(&thirdSession);
+  InputSet desired;
+  desired.set(InputKey::A);
+  desired.set(InputKey::LeftShift);
+  check(injector.setInputState(thirdId, desired) == 2, "two keys pressed");
+  check(injector.heldInputs(thirdId) == desired, "pressed keys tracked");
+  readEvents(descriptors[0]);
+  desired.set(InputKey::A, false);
+  desired.set(InputKey::B);
+  check(injector.setInputState(thirdId, desired) == 2, "one key swapped for another");
+  events = readEvents(descriptors[0]);
+  check(events.size() == 4 && events[0].code == KEY_A && events[0].value == 0 &&
+        events[2].code == KEY_B && events[2].value == 1, "released before pressing");
+  check(injector.setInputState(thirdId, desired) == 0 && readEvents(descriptors[0]).empty(), "nothing sent without changes");
+
+  // Events injected any other way are tracked too, and everything held can be let go at once.
+  const KeyEventData control { .key = InputKey::LeftControl, .state = InputState::Press };
+  injector.injectKeyboardEvent(thirdId, control);
+  check(injector.heldInputs(thirdId).test(InputKey::LeftControl), "injected press tracked");
+  check(injector.releaseAll() == 4, "every held key released, and the button the other session held");
+  check(injector.heldInputs(thirdId).empty() && injector.heldInputs(otherId).empty(), "nothing held after releasing");
+  readEvents(descriptors[0]);
+
+  // A fixed sequence is translated once and sends the same reports every time it is injected.
+  static constexpr InputEvent kFixed[] {
+    InputEvent::fromMouse(MouseEventData { .xpos = 5, .ypos = 6, .scrolldy = 0, .button = MouseButton::Undefined, .state = InputState::Release }),
+    InputEvent::wait(1000),
+    InputEvent::fromKeyboard(KeyEventData { .key = InputKey::B, .state = InputState::Press }),
+    InputEvent::fromKeyboard(KeyEventData { .key = InputKey::B, .state = InputState::Release }),
+  };
+  CompiledSequence sequence(kFixed);
+  check(sequence.size() == 3, "waits left out of the sequence");
+  for (int round = 0; round < 2; round++) {
+    check(injector.injectSequence(thirdId, sequence) == 3, "whole sequence accepted");
+    events = readEvents(descriptors[0]);
+    check(events.size() == 7 && events[0].code == ABS_X && events[0].value == 5 &&
+          events[3].code == KEY_B && events[3].value == 1, "sequence moved, then typed B");
+  }
+  check(injector.heldInputs(thirdId).empty(), "sequence left nothing held");
+  check(tryInjectSequence(nullptr, sequence).status == InjectStatus::InvalidInjectee, "sequence rejects a null injectee");
+
+  // Pacing sends a batch in bursts, waiting between them for the budget to refill.
+  Injector paced;
+  // The interval is long enough that being descheduled between bursts rarely spares one a wait.
+  paced.setPacing(PacingOptions { .rate = 200, .burst = 2, .policy = PacingPolicy::Delay });
+  const std::vector<KeyEventData> pacedKeys(6, keys[0]);
+  auto started = std::chrono::steady_clock::now();
+  check(paced.injectKeyboardEvents(id, pacedKeys) == 6, "paced batch accepted");
+  check(std::chrono::steady_clock::now() - started >= std::chrono::milliseconds(15), "paced batch spread out");
+  check(paced.pacingStatistics().throttled >= 1 && paced.pacingStatistics().throttled <= 2 &&
+        paced.pacingStatistics().delayed > std::chrono::nanoseconds::zero(), "later bursts waited");
+  check(readEvents(descriptors[0]).size() == 12, "every paced key sent");
+
+  // Coalescing pacing only sends the newest of the moves that would have had to wait.
+  Injector coalescing;
+  coalescing.setPacing(PacingOptions { .rate = 1000, .burst = 1, .policy = PacingPolicy::Coalesce });
+  std::vector<MouseEventData> moves;
+  for (int32_t step = 1; step <= 5; step++)
+    moves.push_back(MouseEventData { .xpos = step, .ypos = step, .scrolldy = 0, .button = MouseButton::Undefined, .state = InputState::Release });
+  check(coalescing.injectMouseEvents(id, moves) == 5, "coalesced moves count as accepted");
+  check(coalescing.pacingStatistics().coalesced == 4 && coalescing.pacingStatistics().throttled == 0, "moves coalesced instead of waiting");
+  events = readEvents(descriptors[0]);
+  check(events.size() == 3 && events[0].value == 5, "only the newest move sent");
+
+  // Relative motion goes out as whole pixel steps, with what is left carried into the next motion.
+  Injector relative;
+  check(relative.injectMouseEvents(id, std::span(mice + 2, 1)) == 1, "absolute move before motion");
+  readEvents(descriptors[0]);
+  relative.injectMouseMotion(id, MouseMotionData {
+    .dx = 3 * kSubpixelScale / 2, .dy = -2 * kSubpixelScale, .scrolldy = 0, .button = MouseButton::LeftButton, .state = InputState::Press
+  });
+  events = readEvents(descriptors[0]);
+  check(events.size() == 4, "motion sent in one report");
+  if (events.size() == 4) {
+    check(events[0].type == EV_REL && events[0].code == REL_X && events[0].value == 2, "moved right by the rounded delta");
+    check(events[1].type == EV_REL && events[1].code == REL_Y && events[1].value == -2, "moved up");
+    check(events[2].type == EV_KEY && events[2].code == BTN_LEFT && events[2].value == 1, "pressed with the motion");
+  }
+  const MouseMotionData settle { .dx = kSubpixelScale / 2, .dy = 0, .scrolldy = 0, .button = MouseButton::Undefined, .state = InputState::Release };
+  check(relative.tryInjectMouseMotion(id, settle).accepted == 1, "motion below a pixel accepted");
+  check(readEvents(descriptors[0]).empty(), "leftover motion cancelled out");
+  check(relative.heldInputs(id).test(MouseButton::LeftButton), "button held by motion tracked");
+  check(relative.releaseAll(id) == 1, "button held by motion released");
+  events = readEvents(descriptors[0]);
+  check(events.size() == 2 && events[0].type == EV_KEY && events[0].code == BTN_LEFT && events[0].value == 0,
+        "released where the pointer is, without moving it");
+  check(relative.injectMouseEvents(id, std::span(mice + 1, 1)) == 1, "absolute event after motion");
+  events = readEvents(descriptors[0]);
+  check(events.size() == 4 && events[0].code == ABS_X, "position sent again after moving relatively");
+
+  // A session spans the whole screen, so client positions go out as they are.
+  Injector client;
+  client.setCoordinateSpace(CoordinateSpace::Client);
+  check(client.injectMouseEvents(id, std::span(mice, 2)) == 2, "client space accepted");
+  events = readEvents(descriptors[0]);
+  check(events.size() == 6 && events[0].value == 10 && events[1].value == 20, "client positions sent unchanged");
+
+  // The budget of the process holds back injectors that have none of their own.
+  setGlobalPacing(200, 1);
+  Injector governed;
+  check(governed.injectKeyboardEvents(id, std::span(pacedKeys).first(3)) == 3, "governed batch accepted");
+  check(governed.pacingStatistics().throttled >= 1 && governed.pacingStatistics().throttled <= 2,
+        "process budget waited between events");
+  setGlobalPacing(0, 0);
+  readEvents(descriptors[0]);
+
+  closeUInputDevice();
+  close(descriptors[0]);
+  return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
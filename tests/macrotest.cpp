@@ -0,0 +1,85 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <reminput/macro.hpp>
+#include <reminput/recording.hpp>
+#include "testing.hpp"
+
+int main(void) {
+  // For explicitness.
+  using namespace simular::reminput;
+  using namespace std::chrono_literals;
+
+  constexpr const char* kMacroPath = "macrotest.macro";
+  constexpr const char* kLogPath   = "macrotest.log";
+  int window = 0;
+  auto id    = reinterpret_cast<HandleID>(&window);
+
+  // Two key runs around a mouse run, with a gap too long for one record.
+  MacroWriter writer;
+  writer.key(0ns, KeyEventData { .key = InputKey::H, .state = InputState::Press });
+  writer.key(250us, KeyEventData { .key = InputKey::H, .state = InputState::Release });
+  writer.mouse(10s, MouseEventData { .xpos = 5, .ypos = 6, .scrolldy = 1, .button = MouseButton::LeftButton, .state = InputState::Press });
+  writer.mouse(1ms, MouseEventData { .xpos = 7, .ypos = 8, .scrolldy = 0, .button = MouseButton::LeftButton, .state = InputState::Release });
+  writer.key(0ns, KeyEventData { .key = InputKey::I, .state = InputState::Press });
+  check(writer.records().size() == 7, "long gap split into waits");
+  check(writer.save(kMacroPath), "macro saved");
+
+  MacroFile macro(kMacroPath);
+  check(macro.valid(), "macro mapped");
+  check(macro.records().size() == 7, "every record mapped");
+  check(macro.records()[1].delay == 250000, "delay kept in nanoseconds");
+
+  // Replay into a recording, so the events can be read back.
+  check(startRecording(RecordingOptions { .path = kLogPath, .capacity = 16 }), "recording started");
+  Injector injector;
+  check(replayMacro(injector, id, macro.records()) == 5, "every event replayed");
+  stopRecording();
+
+  {
+    RecordingLog log(kLogPath);
+    check(log.size() == 5, "five events recorded");
+    check(log[0].code == static_cast<uint8_t>(InputKey::H) && log[1].state == static_cast<uint8_t>(InputState::Release), "keys replayed");
+    check(log[2].kind == RecordedEvent::Kind::Mouse && log[2].xpos == 5 && log[2].scrolldy == 1, "mouse replayed");
+    check(log[4].code == static_cast<uint8_t>(InputKey::I), "order kept");
+  }
+
+  // Anything that is not a macro is rejected.
+  check(!MacroFile(kLogPath).valid(), "log is not a macro");
+
+  // So is a macro with a record no key matches, past the 32 byte header.
+  if (auto* file = std::fopen(kMacroPath, "r+b")) {
+    const uint8_t corrupt = 250;
+    std::fseek(file, static_cast<long>(32 + offsetof(MacroRecord, code)), SEEK_SET);
+    std::fwrite(&corrupt, sizeof(corrupt), 1, file);
+    std::fclose(file);
+  }
+  check(!MacroFile(kMacroPath).valid(), "corrupted macro rejected");
+
+  std::remove(kMacroPath);
+  std::remove(kLogPath);
+  return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,80 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include <reminput/queue.hpp>
+#include <reminput/uinput.hpp>
+#include <fcntl.h>
+#include <unistd.h>
+#include <linux/input.h>
+#include "testing.hpp"
+
+int main(void) {
+  // For explicitness.
+  using namespace simular::reminput;
+
+  // Stand in for /dev/uinput with a pipe large enough for the whole test.
+  int descriptors[2];
+  if (pipe2(descriptors, O_NONBLOCK) != 0)
+    return EXIT_FAILURE;
+  fcntl(descriptors[1], F_SETPIPE_SZ, 1 << 20);
+  attachUInputDevice(descriptors[1]);
+
+  constexpr int kProducers = 4;
+  constexpr int kEvents    = 250;
+  int sessions[kProducers];
+
+  {
+    // A small ring, so producers have to wait on the dispatcher.
+    AsyncInjector injector(64, QueuePolicy::Block);
+
+    std::vector<std::thread> producers;
+    for (int producer = 0; producer < kProducers; producer++) {
+      producers.emplace_back([&, producer] {
+        auto id = reinterpret_cast<HandleID>(&sessions[producer]);
+        for (int event = 0; event < kEvents; event++)
+          injector.enqueue(id, KeyEventData { .key = InputKey::A, .state = InputState::Press });
+      });
+    }
+    for (auto& producer : producers)
+      producer.join();
+
+    // Events for an invalid injectee fail without throwing.
+    injector.enqueue(nullptr, KeyEventData { .key = InputKey::B, .state = InputState::Press });
+
+    injector.flush();
+    auto statistics = injector.statistics();
+    check(statistics.submitted == kProducers * kEvents, "every valid event submitted");
+    check(statistics.failed == 1, "invalid injectee counted as failed");
+    check(statistics.dropped == 0, "nothing dropped when blocking");
+  }
+
+  // Every event became a key record and a report.
+  std::vector<input_event> events(kProducers * kEvents * 2 + 1);
+  auto bytes = read(descriptors[0], events.data(), events.size() * sizeof(input_event));
+  check(bytes == static_cast<ssize_t>(kProducers * kEvents * 2 * sizeof(input_event)), "all records written");
+
+  closeUInputDevice();
+  close(descriptors[0]);
+  return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
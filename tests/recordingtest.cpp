@@ -0,0 +1,179 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <reminput/queue.hpp>
+#include <reminput/recording.hpp>
+#include "testing.hpp"
+
+int main(void) {
+  // For explicitness.
+  using namespace simular::reminput;
+
+  // No window is needed, any non-null handle is accepted while recording.
+  constexpr const char* kPath = "recordingtest.log";
+  int window = 0;
+  auto id    = reinterpret_cast<HandleID>(&window);
+
+  // A small ring, so the test also covers wrapping around.
+  check(startRecording(RecordingOptions { .path = kPath, .capacity = 6 }), "recording started");
+  check(isRecording(), "recording reported");
+
+  const KeyEventData keys[] {
+    { .key = InputKey::A, .state = InputState::Press },
+    { .key = InputKey::A, .state = InputState::Release },
+  };
+  check(injectKeyboardEvents(id, keys) == 2, "key batch recorded");
+
+  const MouseEventData moves[] {
+    { .xpos = 10, .ypos = 20, .scrolldy = 0, .button = MouseButton::Undefined, .state = InputState::Release },
+    { .xpos = 30, .ypos = 40, .scrolldy = -1, .button = MouseButton::RightButton, .state = InputState::Press },
+  };
+  check(injectMouseEvents(id, moves) == 2, "mouse batch recorded");
+
+#if defined(__cpp_exceptions)
+  auto threw = false;
+  try {
+    injectKeyboardEvent(nullptr, keys[0]);
+  } catch (const std::runtime_error&) {
+    threw = true;
+  }
+  check(threw, "null injectee still rejected");
+#endif
+
+  {
+    RecordingLog log(kPath);
+    check(log.valid(), "log readable while recording");
+    check(log.size() == 4 && log.appended() == 4, "four records");
+    check(log[0].kind == RecordedEvent::Kind::Keyboard && log[0].code == static_cast<uint8_t>(InputKey::A), "key record");
+    check(log[1].state == static_cast<uint8_t>(InputState::Release), "key release recorded");
+    check(log[3].kind == RecordedEvent::Kind::Mouse && log[3].xpos == 30 && log[3].ypos == 40, "mouse record");
+    check(log[3].code == static_cast<uint8_t>(MouseButton::RightButton) && log[3].scrolldy == -1, "mouse button recorded");
+    check(log[3].injectee == reinterpret_cast<uintptr_t>(id), "injectee recorded");
+    for (std::size_t index = 0; index < log.size(); index++)
+      check(log[index].sequence == index + 1, "records published in order");
+  }
+
+  // Queued events are recorded by the dispatcher.
+  {
+    AsyncInjector injector(16, QueuePolicy::Block);
+    for (int event = 0; event < 6; event++)
+      injector.enqueue(id, KeyEventData { .key = InputKey::B, .state = InputState::Press });
+    injector.flush();
+    check(injector.statistics().submitted == 6, "queued events recorded");
+  }
+
+  stopRecording();
+  check(!isRecording(), "recording stopped");
+
+  {
+    // The ring of eight kept only the newest records.
+    RecordingLog log(kPath);
+    check(log.appended() == 10 && log.size() == 8, "ring wrapped");
+    check(log[0].sequence == 3 && log[7].sequence == 10, "oldest records overwritten");
+    check(log[7].code == static_cast<uint8_t>(InputKey::B), "newest record last");
+    RecordedEvent copy{};
+    check(log.read(0, copy) && copy.sequence == 3 && copy.code == log[0].code, "whole record copied");
+
+    // A record caught while being overwritten, past the 64 byte header, is not copied.
+    if (auto* file = std::fopen(kPath, "r+b")) {
+      const uint64_t writing = 0;
+      std::fseek(file, static_cast<long>(64 + (9 & 7) * sizeof(RecordedEvent) + offsetof(RecordedEvent, sequence)), SEEK_SET);
+      std::fwrite(&writing, sizeof(writing), 1, file);
+      std::fclose(file);
+    }
+    check(!log.read(7, copy), "torn record refused");
+  }
+
+  // Recordings keep characters without a key as code points, between shifted runs.
+  check(startRecording(RecordingOptions { .path = kPath, .capacity = 16 }), "recording restarted");
+  check(injectText(id, u8"AB\u00e9") == 3, "text recorded");
+  stopRecording();
+  {
+    RecordingLog log(kPath);
+    check(log.size() == 7, "shift held across both capitals");
+    check(log[0].code == static_cast<uint8_t>(InputKey::LeftShift) && log[0].state == static_cast<uint8_t>(InputState::Press), "shift pressed once");
+    check(log[5].code == static_cast<uint8_t>(InputKey::LeftShift) && log[5].state == static_cast<uint8_t>(InputState::Release), "shift released before the code point");
+    check(log[6].kind == RecordedEvent::Kind::Unicode && log[6].xpos == 0xE9, "code point recorded");
+  }
+
+  // Runs of pure moves collapse to their newest position, without crossing clicks or wheel steps.
+  check(startRecording(RecordingOptions { .path = kPath, .capacity = 16 }), "recording restarted for moves");
+  const MouseEventData burst[] {
+    { .xpos = 1, .ypos = 1, .scrolldy = 0, .button = MouseButton::Undefined,  .state = InputState::Release },
+    { .xpos = 2, .ypos = 2, .scrolldy = 0, .button = MouseButton::Undefined,  .state = InputState::Release },
+    { .xpos = 3, .ypos = 3, .scrolldy = 0, .button = MouseButton::Undefined,  .state = InputState::Release },
+    { .xpos = 3, .ypos = 3, .scrolldy = 0, .button = MouseButton::LeftButton, .state = InputState::Press   },
+    { .xpos = 4, .ypos = 4, .scrolldy = 0, .button = MouseButton::Undefined,  .state = InputState::Release },
+    { .xpos = 5, .ypos = 5, .scrolldy = 1, .button = MouseButton::Undefined,  .state = InputState::Release },
+    { .xpos = 6, .ypos = 6, .scrolldy = 0, .button = MouseButton::Undefined,  .state = InputState::Release },
+    { .xpos = 7, .ypos = 7, .scrolldy = 0, .button = MouseButton::Undefined,  .state = InputState::Release },
+  };
+  Injector coalescing;
+  coalescing.setMoveCoalescing(true);
+  check(coalescing.injectMouseEvents(id, burst) == 8, "coalesced moves count as accepted");
+  check(coalescing.coalescedMoves() == 3, "three moves replaced");
+  {
+    AsyncInjector injector(16, QueuePolicy::Block);
+    injector.setMoveCoalescing(true);
+    for (const auto& event : burst)
+      injector.enqueue(id, event);
+    injector.flush();
+    auto statistics = injector.statistics();
+    check(statistics.submitted + statistics.coalesced == 8, "queued moves submitted or coalesced");
+  }
+  stopRecording();
+  {
+    RecordingLog log(kPath);
+    check(log.size() >= 5, "coalesced batch recorded");
+    check(log[0].xpos == 3 && log[1].code == static_cast<uint8_t>(MouseButton::LeftButton), "newest move kept before the click");
+    check(log[2].xpos == 4 && log[3].scrolldy == 1 && log[4].xpos == 7, "wheel steps break runs");
+  }
+
+  // Relative motion below a pixel carries over until it adds up, so the total is exact.
+  check(startRecording(RecordingOptions { .path = kPath, .capacity = 16 }), "recording restarted for motion");
+  std::vector<MouseMotionData> creep(4 * kSubpixelScale, MouseMotionData {
+    .dx = 1, .dy = -1, .scrolldy = 0, .button = MouseButton::Undefined, .state = InputState::Release
+  });
+  check(injectMouseMotions(id, creep) == creep.size(), "sub-pixel motions count as accepted");
+  injectMouseMotion(id, MouseMotionData { .dx = 0, .dy = 0, .scrolldy = 0, .button = MouseButton::LeftButton, .state = InputState::Press });
+  stopRecording();
+  {
+    RecordingLog log(kPath);
+    auto dx = int64_t{0};
+    auto dy = int64_t{0};
+    for (std::size_t index = 0; index + 1 < log.size(); index++) {
+      check(log[index].kind == RecordedEvent::Kind::Motion, "motion recorded");
+      dx += log[index].xpos;
+      dy += log[index].ypos;
+    }
+    check(log.size() == 9 && dx == 4 && dy == -4, "tiny deltas add up to whole pixels");
+    check(log[8].code == static_cast<uint8_t>(MouseButton::LeftButton) && log[8].xpos == 0, "button sent without moving");
+  }
+
+  std::remove(kPath);
+  return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,81 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <reminput/recording.hpp>
+#include <reminput/scheduler.hpp>
+#include "testing.hpp"
+
+int main(void) {
+  // For explicitness.
+  using namespace simular::reminput;
+  using namespace std::chrono_literals;
+
+  constexpr const char* kLogPath = "schedulertest.log";
+  int window = 0;
+  auto id    = reinterpret_cast<HandleID>(&window);
+  check(startRecording(RecordingOptions { .path = kLogPath, .capacity = 64 }), "recording started");
+
+  Scheduler scheduler(SchedulerOptions { .spinBudget = 100us });
+  scheduler.calibrate(4);
+
+  // Waiting never returns early.
+  auto deadline = std::chrono::steady_clock::now() + 2ms;
+  check(scheduler.waitUntil(deadline) >= deadline, "wait reaches its deadline");
+
+  // Events half a millisecond apart, with a pair sharing a deadline.
+  std::vector<TimedKeyEvent> events;
+  for (int event = 0; event < 10; event++)
+    events.push_back(TimedKeyEvent { .at = event * 500us, .data = { .key = InputKey::A, .state = InputState::Press } });
+  events.push_back(TimedKeyEvent { .at = 4500us, .data = { .key = InputKey::B, .state = InputState::Press } });
+
+  Injector injector;
+  auto started = std::chrono::steady_clock::now();
+  check(scheduler.play(injector, id, events) == events.size(), "every key played");
+  check(std::chrono::steady_clock::now() - started >= 4500us, "playback took as long as the events");
+  check(scheduler.lateness().total() == events.size(), "lateness recorded per event");
+
+  // Macro delays are honoured too, waits included.
+  MacroWriter writer;
+  writer.mouse(0ns, MouseEventData { .xpos = 1, .ypos = 1, .scrolldy = 0, .button = MouseButton::Undefined, .state = InputState::Release });
+  writer.mouse(1ms, MouseEventData { .xpos = 2, .ypos = 2, .scrolldy = 0, .button = MouseButton::Undefined, .state = InputState::Release });
+  writer.key(1ms, KeyEventData { .key = InputKey::C, .state = InputState::Press });
+  scheduler.resetLateness();
+  started = std::chrono::steady_clock::now();
+  check(scheduler.play(injector, id, writer.records()) == 3, "every macro event played");
+  check(std::chrono::steady_clock::now() - started >= 2ms, "macro delays honoured");
+  check(scheduler.lateness().total() == 3, "macro lateness recorded");
+
+  stopRecording();
+  {
+    RecordingLog log(kLogPath);
+    check(log.size() == events.size() + 3, "every event recorded");
+    check(log[log.size() - 1].code == static_cast<uint8_t>(InputKey::C), "macro order kept");
+    for (std::size_t index = 1; index < log.size(); index++)
+      check(log[index].timestamp >= log[index - 1].timestamp, "released in order");
+  }
+
+  std::remove(kLogPath);
+  return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,199 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include <reminput/socket.hpp>
+#include <reminput/uinput.hpp>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <linux/input.h>
+#include "testing.hpp"
+
+// For explicitness.
+using namespace simular::reminput;
+
+// Connects to the server, returning -1 on failure.
+static int connectTo(const std::string& path) {
+  auto fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  std::strcpy(address.sun_path, path.c_str());
+  if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+// Builds a frame of key presses.
+static std::vector<std::byte> keyFrame(uint32_t count) {
+  FrameHeader header { .count = count, .flags = 0, .injectee = 1 };
+  std::vector<std::byte> frame(sizeof(header) + count * sizeof(InputEvent));
+  std::memcpy(frame.data(), &header, sizeof(header));
+  for (uint32_t index = 0; index < count; index++) {
+    auto event = InputEvent::fromKeyboard(KeyEventData { .key = InputKey::A, .state = InputState::Press });
+    std::memcpy(frame.data() + sizeof(header) + index * sizeof(event), &event, sizeof(event));
+  }
+  return frame;
+}
+
+// Waits until the server counts the given number of frames, or gives up after a while.
+static void waitForFrames(const SocketServer& server, uint64_t frames) {
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (server.statistics().frames < frames && std::chrono::steady_clock::now() < deadline)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
+
+// Sends frames whole, split and from many clients, returning how many events were sent.
+static uint64_t exercise(const std::string& path, bool forceEpoll) {
+  // Few small buffers, so the kernel runs out of them and frames straddle receives.
+  SocketServer server(SocketServerOptions {
+    .path = path.c_str(), .connections = 16, .bufferSize = 256, .bufferCount = 4, .forceEpoll = forceEpoll,
+  });
+  check(server.valid(), "server listening");
+  check(!forceEpoll || !server.usingIoUring(), "epoll forced");
+  std::thread runner([&] { server.run(); });
+
+  uint64_t sent   = 0;
+  uint64_t frames = 0;
+
+  // A frame written a few bytes at a time is injected once it is complete.
+  {
+    auto fd    = connectTo(path);
+    auto frame = keyFrame(5);
+    for (std::size_t offset = 0; offset < frame.size(); offset += 7) {
+      check(write(fd, frame.data() + offset, std::min<std::size_t>(7, frame.size() - offset)) > 0, "split write");
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    waitForFrames(server, ++frames);
+    sent += 5;
+    close(fd);
+  }
+
+  // Many frames in one write, larger than a receive buffer, and an empty frame.
+  {
+    auto fd = connectTo(path);
+    std::vector<std::byte> stream;
+    for (uint32_t count : { 1u, 40u, 0u, 3u }) {
+      auto frame = keyFrame(count);
+      stream.insert(stream.end(), frame.begin(), frame.end());
+      sent += count;
+      frames++;
+    }
+    check(write(fd, stream.data(), stream.size()) == static_cast<ssize_t>(stream.size()), "batched write");
+    waitForFrames(server, frames);
+    close(fd);
+  }
+
+  // Clients connected at once are all served.
+  {
+    std::vector<int> clients;
+    for (int client = 0; client < 12; client++)
+      clients.push_back(connectTo(path));
+    for (auto fd : clients) {
+      auto frame = keyFrame(2);
+      check(write(fd, frame.data(), frame.size()) == static_cast<ssize_t>(frame.size()), "client write");
+      sent += 2;
+      frames++;
+    }
+    waitForFrames(server, frames);
+    for (auto fd : clients)
+      close(fd);
+  }
+
+  // A malformed frame closes the connection without injecting anything.
+  {
+    auto fd    = connectTo(path);
+    auto frame = keyFrame(1);
+    frame[sizeof(FrameHeader) + 5] = std::byte{0xFF};
+    check(write(fd, frame.data(), frame.size()) == static_cast<ssize_t>(frame.size()), "malformed write");
+    char byte;
+    check(read(fd, &byte, 1) == 0, "malformed frame closes the connection");
+    close(fd);
+  }
+
+  server.stop();
+  runner.join();
+
+  auto statistics = server.statistics();
+  check(statistics.frames == frames, "every frame received");
+  check(statistics.submitted == sent && statistics.failed == 0, "every event submitted");
+  check(statistics.rejected == 1, "malformed frame rejected");
+  check(statistics.connections == 15, "every client counted");
+  return sent;
+}
+
+int main(void) {
+  // Stand in for /dev/uinput with a pipe large enough for the whole test.
+  int descriptors[2];
+  if (pipe2(descriptors, O_NONBLOCK) != 0)
+    return EXIT_FAILURE;
+  fcntl(descriptors[1], F_SETPIPE_SZ, 1 << 20);
+  attachUInputDevice(descriptors[1]);
+
+  // The same traffic through io_uring, where available, and through epoll.
+  auto path  = "/tmp/reminput-socket-test-" + std::to_string(getpid());
+  auto total = exercise(path, false) + exercise(path, true);
+  check(access(path.c_str(), F_OK) != 0, "socket removed");
+
+  // A socket another server answers on is left alone, one nobody answers on is replaced.
+  {
+    SocketServer first(SocketServerOptions { .path = path.c_str() });
+    SocketServer second(SocketServerOptions { .path = path.c_str() });
+    check(first.valid() && !second.valid(), "live server kept its socket");
+    auto fd = connectTo(path);
+    check(fd >= 0, "live server still reachable");
+    if (fd >= 0)
+      close(fd);
+  }
+  {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strcpy(address.sun_path, path.c_str());
+    auto abandoned = socket(AF_UNIX, SOCK_STREAM, 0);
+    bind(abandoned, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    close(abandoned);
+    SocketServer server(SocketServerOptions { .path = path.c_str() });
+    check(server.valid(), "abandoned socket replaced");
+  }
+  {
+    close(open(path.c_str(), O_CREAT | O_WRONLY, 0600));
+    SocketServer server(SocketServerOptions { .path = path.c_str() });
+    check(!server.valid() && access(path.c_str(), F_OK) == 0, "file that is not a socket kept");
+    unlink(path.c_str());
+  }
+
+  // One key record and one report per event reached the device.
+  std::vector<input_event> events(2 * total + 1);
+  auto bytes = read(descriptors[0], events.data(), events.size() * sizeof(input_event));
+  check(bytes == static_cast<ssize_t>(2 * total * sizeof(input_event)), "every event reached the device");
+
+  closeUInputDevice();
+  close(descriptors[0]);
+  return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
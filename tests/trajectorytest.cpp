@@ -0,0 +1,82 @@
+/* Copyright (c) 2020 Simular Games, LLC.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * MIT License
+ * -------------------------------------------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+ * associated documentation files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ * -------------------------------------------------------------------------------------------------
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+ * NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <chrono>
+#include <cstdlib>
+#include <vector>
+#include <reminput/trajectory.hpp>
+#include "testing.hpp"
+
+int main(void) {
+  // For explicitness.
+  using namespace simular::reminput;
+  using namespace std::chrono_literals;
+
+  TrajectoryOptions options {
+    .startX   = 100,
+    .startY   = 200,
+    .endX     = 900,
+    .endY     = 600,
+    .duration = 100500us,
+    .interval = 1ms,
+  };
+
+  // A whole number of intervals, plus one at the start and one for the remainder.
+  check(trajectoryLength(options) == 102, "length covers the duration");
+
+  std::vector<TimedMouseEvent> events(trajectoryLength(options));
+  check(generateTrajectory(options, std::span(events).first(10)) == 0, "short buffer rejected");
+
+  for (auto model : { TrajectoryModel::MinimumJerk, TrajectoryModel::Bezier, TrajectoryModel::Noisy }) {
+    options.model = model;
+    check(generateTrajectory(options, events) == events.size(), "every move generated");
+    check(events.front().data.xpos == 100 && events.front().data.ypos == 200, "starts at the start");
+    check(events.back().data.xpos == 900 && events.back().data.ypos == 600, "ends at the end");
+    check(events.back().at == options.duration, "last move at the end");
+    for (std::size_t index = 1; index < events.size(); index++)
+      check(events[index].at > events[index - 1].at, "moves in time order");
+  }
+
+  // A straight minimum-jerk path is symmetric, and slow at both ends.
+  options.model = TrajectoryModel::MinimumJerk;
+  options.duration = 100ms;
+  events.resize(trajectoryLength(options));
+  generateTrajectory(options, events);
+  check(events[50].data.xpos == 500 && events[50].data.ypos == 400, "halfway at the midpoint");
+  check(events[1].data.xpos - events[0].data.xpos < events[51].data.xpos - events[50].data.xpos, "eases in");
+
+  // A Bezier path leaves the straight line, and the same seed gives the same noisy path.
+  options.model = TrajectoryModel::Bezier;
+  generateTrajectory(options, events);
+  check(events[50].data.xpos != 500 || events[50].data.ypos != 400, "curve bows");
+
+  options.model = TrajectoryModel::Noisy;
+  options.seed  = 42;
+  std::vector<TimedMouseEvent> again(events.size());
+  generateTrajectory(options, events);
+  generateTrajectory(options, again);
+  auto same = true;
+  for (std::size_t index = 0; index < events.size(); index++)
+    same = same && events[index].data.xpos == again[index].data.xpos && events[index].data.ypos == again[index].data.ypos;
+  check(same, "noise is seeded");
+
+  return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
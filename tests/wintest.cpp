@@ -82,4 +82,17 @@ int main(void) {
     injectKeyboardEvent(id, keydata);
     std::this_thread::sleep_for(std::chrono::milliseconds(100));
   }
+
+  // Move to a point in the client area, which should land on the same pixel of the screen.
+  Injector injector;
+  injector.setCoordinateSpace(CoordinateSpace::Client);
+  injector.injectMouseEvent(id, MouseEventData {
+    .xpos = 10, .ypos = 10, .scrolldy = 0, .button = MouseButton::Undefined, .state = InputState::Release
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  POINT expected { 10, 10 };
+  POINT cursor   {};
+  ClientToScreen(vscodeHWND, &expected);
+  GetCursorPos(&cursor);
+  std::wcout << L"cursor at " << cursor.x << L"," << cursor.y << L", expected " << expected.x << L"," << expected.y << std::endl;
 }